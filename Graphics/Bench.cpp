@@ -0,0 +1,1416 @@
+#include "Bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "BucketQueue.h"
+#include "CoverField.h"
+#include "Explosions.h"
+#include "Match.h"
+#include "Pathfinding.h"
+#include "PathJobs.h"
+#include "ProjectilePool.h"
+#include "Rng.h"
+#include "UnitBins.h"
+#include "Units.h"
+#include "Visibility.h"
+#include "World.h"
+
+using namespace Definitions;
+
+namespace Simulation {
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        // Wall time of one call to `f`, in milliseconds.
+        template <typename F>
+        double timeMs(F&& f) {
+            const Clock::time_point t0 = Clock::now();
+            f();
+            return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        }
+
+        // slow / fast for the speedup columns, 0 when nothing was timed.
+        inline double speedup(double slow, double fast) {
+            return fast > 0.0 ? slow / fast : 0.0;
+        }
+
+        // Every bench ends with this line: what it checked and whether that
+        // held. Returns the bench's exit code.
+        int verdict(bool ok, const char* check) {
+            std::printf("%s: %s\n", check, ok ? "pass" : "FAIL");
+            return ok ? 0 : 1;
+        }
+
+        bool randomWalkable(const Models::Grid& grid, Rng& rng, int& r, int& c) {
+            for (int k = 0; k < 1000; ++k) {
+                r = rng.below(GRID_SIZE);
+                c = rng.below(GRID_SIZE);
+                if (AI::Pathfinding::inPlayfield(r, c) && grid.walkable(r, c))
+                    return true;
+            }
+            return false;
+        }
+
+        std::unique_ptr<Match> testMatch(uint32_t seed) {
+            std::unique_ptr<Match> m(new Match());
+            m->buildTestWorld(seed);
+            return m;
+        }
+
+        // The test world after 600 ticks with the commanders on, so the
+        // security map has the texture a running match gives it.
+        std::unique_ptr<Match> warmedMatch(uint32_t seed) {
+            std::unique_ptr<Match> m = testMatch(seed);
+            m->setCommanderEnabled(true);
+            for (int i = 0; i < 600; ++i) m->step();
+            return m;
+        }
+
+        // The test world plus 200 warriors on random walkable cells, half
+        // per team, so shots have something to hit.
+        std::unique_ptr<Match> crowdedMatch(uint32_t seed) {
+            std::unique_ptr<Match> m = testMatch(seed);
+            World& w = m->world();
+            Rng place(seed, 96);
+            for (int i = 0; i < 200; ++i) {
+                int r = 0, c = 0;
+                if (!randomWalkable(w.grid, place, r, c)) break;
+                Models::Unit* u = new Models::Unit(w, (i & 1) ? Team::Orange : Team::Blue, Role::Warrior, r, c);
+                u->id = 1000 + i;
+                w.units.push_back(u);
+            }
+            w.occupancy.rebuild(w.units);
+            w.proximity.rebuild(w.units);
+            return m;
+        }
+
+        // A bare world (no terrain) with `units` warriors anywhere on the
+        // map, half per team.
+        std::unique_ptr<World> scatteredWorld(Rng& rng, int units) {
+            std::unique_ptr<World> world(new World());
+            for (int i = 0; i < units; ++i) {
+                const Team t = (i & 1) ? Team::Orange : Team::Blue;
+                Models::Unit* u = new Models::Unit(*world, t, Role::Warrior,
+                    rng.range(0, GRID_SIZE - 1), rng.range(0, GRID_SIZE - 1));
+                u->id = i + 1;
+                world->units.push_back(u);
+            }
+            world->occupancy.rebuild(world->units);
+            world->proximity.rebuild(world->units);
+            return world;
+        }
+
+        // Open sets for the queue benchmark: the binary heap grid searches
+        // used before BucketQueue, and BucketQueue itself.
+        struct HeapOpen {
+            using Node = AI::Pathfinding::PathfinderContext::Node;
+            struct Cmp { bool operator()(const Node& a, const Node& b) const { return a.f > b.f; } };
+            std::vector<Node> v;
+            void clear() { v.clear(); }
+            bool empty() const { return v.empty(); }
+            void push(float f, float g, int idx) { v.push_back({ f, g, idx }); std::push_heap(v.begin(), v.end(), Cmp()); }
+            Node pop() { std::pop_heap(v.begin(), v.end(), Cmp()); const Node n = v.back(); v.pop_back(); return n; }
+        };
+
+        struct BucketOpen {
+            using Node = AI::Pathfinding::PathfinderContext::Node;
+            AI::Pathfinding::BucketQueue<Node> q{ 1024 };
+            void clear() { q.clear(); }
+            bool empty() const { return q.empty(); }
+            void push(float f, float g, int idx) { q.push(AI::Pathfinding::CostKey(f), { f, g, idx }); }
+            Node pop() { return q.pop(); }
+        };
+
+        // Search kernel shared by both open sets, with the grid step costs.
+        // Toward `goal` it is A* with a closed set, like ExpandAStar; with
+        // goal < 0 it is a whole-map Dijkstra that relaxes improved cells
+        // again, like the flow field build. Returns the cost to the goal.
+        template <typename Open>
+        float gridSearch(Open& open, const Models::Grid& grid, const Simulation::SecurityMap& smap,
+            int start, int goal, float w, std::vector<float>& dist, std::vector<uint8_t>& closed, int& pushes)
+        {
+            const int N = GRID_SIZE;
+            const int dr[4] = { +1,-1,0,0 };
+            const int dc[4] = { 0,0,+1,-1 };
+            const auto& norm = smap.normalized();
+            auto h = [&](int i) {
+                return goal < 0 ? 0.0f : (float)(std::abs(i / N - goal / N) + std::abs(i % N - goal % N));
+            };
+            dist.assign(N * N, std::numeric_limits<float>::infinity());
+            closed.assign(N * N, 0);
+            open.clear();
+            dist[start] = 0.0f;
+            open.push(h(start), 0.0f, start);
+            ++pushes;
+            while (!open.empty()) {
+                const auto cur = open.pop();
+                if (goal < 0) {
+                    if (cur.g > dist[cur.idx]) continue;
+                }
+                else {
+                    if (closed[cur.idx]) continue;
+                    closed[cur.idx] = 1;
+                    if (cur.idx == goal) break;
+                }
+                const int r = cur.idx / N, c = cur.idx % N;
+                for (int k = 0; k < 4; ++k) {
+                    const int nr = r + dr[k], nc = c + dc[k];
+                    if (nr < 0 || nr >= N || nc < 0 || nc >= N) continue;
+                    const int n = nr * N + nc;
+                    if (closed[n] || !grid.walkable(nr, nc)) continue;
+                    const float g = dist[cur.idx] + 1.0f + w * norm[nr][nc];
+                    if (g < dist[n]) {
+                        dist[n] = g;
+                        open.push(g + h(n), g, n);
+                        ++pushes;
+                    }
+                }
+            }
+            return goal < 0 ? 0.0f : dist[goal];
+        }
+
+        // The grid kernels as they were before the padded layout: 2D
+        // indices, a bounds check and Grid::at per neighbour. Kept here as
+        // the baseline for BenchGridKernels.
+        bool legacyAStar(AI::Pathfinding::PathfinderContext& ctx, const Simulation::OccupancyGrid* occ, int unitId,
+            const Models::Grid& grid, const Simulation::SecurityMap& smap,
+            AI::Pathfinding::Cell start, AI::Pathfinding::Cell goal, float w, AI::Pathfinding::Path& out)
+        {
+            using namespace AI::Pathfinding;
+            const int N = GRID_SIZE;
+            const int dr[4] = { +1,-1,0,0 };
+            const int dc[4] = { 0,0,+1,-1 };
+            auto inBounds = [N](int r, int c) { return r >= 0 && r < N && c >= 0 && c < N; };
+            auto h = [&](int r, int c) { return (float)(std::abs(r - goal.first) + std::abs(c - goal.second)); };
+            const auto& norm = smap.normalized();
+            ctx.beginSearch();
+            BucketQueue<int>& open = ctx.frontier();
+            const int startIdx = start.first * N + start.second, goalIdx = goal.first * N + goal.second;
+            ctx.open(startIdx, 0.0f, -1);
+            open.push(CostKey(h(start.first, start.second)), startIdx);
+            while (!open.empty()) {
+                const int cur = open.pop();
+                if (ctx.closed(cur)) continue;
+                ctx.close(cur);
+                if (cur == goalIdx) break;
+                const int cr = cur / N, cc = cur % N;
+                const float gCur = ctx.gScore(cur);
+                for (int k = 0; k < 4; ++k) {
+                    const int nr = cr + dr[k], nc = cc + dc[k];
+                    if (!inBounds(nr, nc)) continue;
+                    const int n = nr * N + nc;
+                    if (ctx.closed(n)) continue;
+                    if (!IsWalkableForMovement(grid.at(nr, nc))) continue;
+                    float step = 1.0f + w * norm[nr][nc];
+                    if (occ && IsOccupiedByOther(*occ, nr, nc, unitId)) step += 25.0f;
+                    const float t = gCur + step;
+                    if (t < ctx.gScore(n)) {
+                        ctx.open(n, t, cur);
+                        open.push(CostKey(t + h(nr, nc)), n);
+                    }
+                }
+            }
+            return ctx.reconstruct(startIdx, goalIdx, out);
+        }
+
+        bool legacyBFS(AI::Pathfinding::PathfinderContext& ctx, const Models::Grid& grid,
+            AI::Pathfinding::Cell start, AI::Pathfinding::Cell goal, AI::Pathfinding::Path& out)
+        {
+            using namespace AI::Pathfinding;
+            const int N = GRID_SIZE;
+            const int dr[4] = { +1,-1,0,0 };
+            const int dc[4] = { 0,0,+1,-1 };
+            ctx.beginSearch();
+            std::vector<int>& q = ctx.queue();
+            int head = 0, tail = 0;
+            const int startIdx = start.first * N + start.second, goalIdx = goal.first * N + goal.second;
+            q[tail++] = startIdx;
+            ctx.open(startIdx, 0.0f, -1);
+            while (head < tail) {
+                const int u = q[head++];
+                if (u == goalIdx) break;
+                const int ur = u / N, uc = u % N;
+                for (int k = 0; k < 4; ++k) {
+                    const int nr = ur + dr[k], nc = uc + dc[k];
+                    if (nr < 0 || nr >= N || nc < 0 || nc >= N) continue;
+                    const int n = nr * N + nc;
+                    if (ctx.seen(n) || !IsWalkableForMovement(grid.at(nr, nc))) continue;
+                    ctx.open(n, 0.0f, u);
+                    q[tail++] = n;
+                }
+            }
+            return ctx.reconstruct(startIdx, goalIdx, out);
+        }
+
+        bool pathValid(const Models::Grid& grid, const AI::Pathfinding::Path& p,
+            AI::Pathfinding::Cell start, AI::Pathfinding::Cell goal) {
+            if (p.empty() || p.front() != start || p.back() != goal) return false;
+            for (size_t i = 0; i < p.size(); ++i) {
+                if (!grid.walkable(p[i].first, p[i].second) && i > 0) return false;
+                if (i > 0 && std::abs(p[i].first - p[i - 1].first) + std::abs(p[i].second - p[i - 1].second) != 1) return false;
+            }
+            return true;
+        }
+
+        float pathCost(const Simulation::SecurityMap& smap, const AI::Pathfinding::Path& p, float w) {
+            const auto& norm = smap.normalized();
+            float cost = 0.0f;
+            for (size_t i = 1; i < p.size(); ++i) cost += 1.0f + w * norm[p[i].first][p[i].second];
+            return cost;
+        }
+    }
+
+    int BenchPathfinding(uint32_t seed, int queries)
+    {
+        using namespace AI::Pathfinding;
+
+        std::unique_ptr<Match> match = warmedMatch(seed);
+        World& world = match->world();
+
+        const Models::Unit* unit = world.units.front();
+        const float w = ASTAR_RISK_WEIGHT;
+        Rng rng(seed, 99);
+
+        std::vector<std::pair<AI::Pathfinding::Cell, AI::Pathfinding::Cell>> pairs;
+        while ((int)pairs.size() < queries) {
+            int r0, c0, r1, c1;
+            if (!randomWalkable(world.grid, rng, r0, c0) || !randomWalkable(world.grid, rng, r1, c1)) break;
+            if (std::abs(r0 - r1) + std::abs(c0 - c1) < 60) continue;
+            pairs.push_back({ { r0, c0 }, { r1, c1 } });
+        }
+
+        PathfinderContext& ctx = PathfinderContext::local();
+        Path path;
+
+        AI::Pathfinding::HierarchicalPlanner fresh;
+        const double buildMs = timeMs([&] { fresh.sync(world.grid); });
+        world.hpa.sync(world.grid);
+
+        struct Row { const char* name; Planner planner; double ms = 0; uint64_t expanded = 0; int found = 0; int invalid = 0; double cost = 0; double len = 0; };
+        Row rows[2] = { { "A*", Planner::Grid }, { "HPA*", Planner::Hierarchical } };
+        for (Row& row : rows) {
+            const uint64_t e0 = ctx.expanded();
+            row.ms = timeMs([&] {
+                for (const auto& q : pairs) {
+                    if (FindPath(ctx, unit, world.grid, world.smap, q.first, q.second, w, path, row.planner)) {
+                        ++row.found;
+                        if (!pathValid(world.grid, path, q.first, q.second)) ++row.invalid;
+                        row.cost += pathCost(world.smap, path, w);
+                        row.len += (double)path.size();
+                    }
+                }
+            });
+            row.expanded = ctx.expanded() - e0;
+        }
+
+        const int n = (int)pairs.size();
+        std::printf("pathfinding bench: seed=%u queries=%d clusters=%dx%d nodes=%d graph build=%.2fms\n",
+            seed, n, HierarchicalPlanner::CLUSTERS_PER_SIDE, HierarchicalPlanner::CLUSTERS_PER_SIDE,
+            world.hpa.nodeCount(), buildMs);
+        std::printf("%-6s %10s %14s %8s %8s %10s %10s\n", "", "us/query", "expanded/query", "found", "invalid", "avg len", "avg cost");
+        for (const Row& row : rows) {
+            std::printf("%-6s %10.1f %14.1f %8d %8d %10.1f %10.1f\n", row.name,
+                n ? row.ms * 1000.0 / n : 0.0, n ? (double)row.expanded / n : 0.0, row.found, row.invalid,
+                row.found ? row.len / row.found : 0.0, row.found ? row.cost / row.found : 0.0);
+        }
+
+        // Terrain edits: drop a rock, re-sync, then remove it again.
+        const int rebuilt0 = world.hpa.clustersRebuilt();
+        int edits = 0;
+        const double editMs = timeMs([&] {
+            for (int k = 0; k < 20; ++k) {
+                int r, c;
+                if (!randomWalkable(world.grid, rng, r, c)) break;
+                const int old = world.grid.at(r, c);
+                world.grid.set(r, c, ROCK);
+                world.hpa.sync(world.grid);
+                world.grid.set(r, c, old);
+                world.hpa.sync(world.grid);
+                edits += 2;
+            }
+        });
+        std::printf("terrain edits: %d, clusters rebuilt=%d, %.3f ms/edit\n",
+            edits, world.hpa.clustersRebuilt() - rebuilt0, edits ? editMs / edits : 0.0);
+
+        // Component labels: full build, incremental edits (checked against a
+        // fresh build), and rejecting a walled-in goal.
+        {
+            Connectivity fresh;
+            const double fullMs = timeMs([&] { fresh.sync(world.grid); });
+
+            auto samePartition = [&](const Connectivity& a, const Connectivity& b) {
+                std::vector<int> ab(GRID_SIZE * GRID_SIZE + 1, 0), ba(GRID_SIZE * GRID_SIZE + 1, 0);
+                for (int r = 0; r < GRID_SIZE; ++r)
+                    for (int c = 0; c < GRID_SIZE; ++c) {
+                        const int la = a.label(r, c), lb = b.label(r, c);
+                        if ((la == 0) != (lb == 0)) return false;
+                        if (la == 0) continue;
+                        if (la >= (int)ab.size()) ab.resize(la + 1, 0);
+                        if (lb >= (int)ba.size()) ba.resize(lb + 1, 0);
+                        if (ab[la] == 0) ab[la] = lb;
+                        if (ba[lb] == 0) ba[lb] = la;
+                        if (ab[la] != lb || ba[lb] != la) return false;
+                    }
+                return true;
+            };
+
+            world.connectivity.sync(world.grid);
+            const uint64_t relabelled0 = world.connectivity.cellsRelabelled();
+            int mismatches = 0, cedits = 0;
+            double syncMs = 0.0;
+            for (int k = 0; k < 20; ++k) {
+                int r, c;
+                if (!randomWalkable(world.grid, rng, r, c)) break;
+                const int old = world.grid.at(r, c);
+                for (int pass = 0; pass < 2; ++pass) {
+                    world.grid.set(r, c, pass == 0 ? ROCK : old);
+                    syncMs += timeMs([&] { world.connectivity.sync(world.grid); });
+                    ++cedits;
+                    Connectivity check;
+                    check.sync(world.grid);
+                    if (!samePartition(world.connectivity, check)) ++mismatches;
+                }
+            }
+
+            int gr = -1, gc = -1;
+            for (int tries = 0; tries < 1000 && gr < 0; ++tries) {
+                int r, c;
+                if (!randomWalkable(world.grid, rng, r, c)) break;
+                if (r < 2 || c < 2 || r >= GRID_SIZE - 2 || c >= GRID_SIZE - 2) continue;
+                gr = r; gc = c;
+            }
+            const int dr[4] = { +1,-1,0,0 };
+            const int dc[4] = { 0,0,+1,-1 };
+            std::vector<int> saved;
+            for (int k = 0; k < 4; ++k) {
+                saved.push_back(world.grid.at(gr + dr[k], gc + dc[k]));
+                world.grid.set(gr + dr[k], gc + dc[k], ROCK);
+            }
+            world.connectivity.sync(world.grid);
+            const AI::Pathfinding::Cell from = pairs.empty() ? AI::Pathfinding::Cell{ unit->row, unit->col } : pairs[0].first;
+            Path p;
+            const double floodMs = timeMs([&] {
+                AStar_FindPath(ctx, &world.occupancy, unit->id, world.grid, world.smap, from, { gr, gc }, w, p);
+            });
+            bool rejected = false;
+            const double rejectMs = timeMs([&] {
+                rejected = !FindPath(ctx, unit, world.grid, world.smap, from, { gr, gc }, w, p, Planner::Grid);
+            });
+            for (int k = 0; k < 4; ++k) world.grid.set(gr + dr[k], gc + dc[k], saved[k]);
+            world.connectivity.sync(world.grid);
+
+            std::printf("components: %d (main %d cells), full label %.3f ms\n",
+                fresh.componentCount(), fresh.componentSize(fresh.mainLabel()), fullMs);
+            std::printf("incremental: %d edits, %.3f ms/edit, %llu cells re-flooded, %d mismatches vs full\n",
+                cedits, cedits ? syncMs / cedits : 0.0,
+                (unsigned long long)(world.connectivity.cellsRelabelled() - relabelled0), mismatches);
+            std::printf("walled-in goal: A* %.3f ms to fail, label check %.4f ms (%s)\n",
+                floodMs, rejectMs, rejected ? "rejected" : "not rejected");
+            if (mismatches || !rejected) return verdict(false, "labels match a full build, walled-in goal rejected");
+        }
+
+        return verdict(rows[0].found == rows[1].found && rows[0].invalid == 0 && rows[1].invalid == 0,
+            "A* and HPA* find the same goals, all paths valid");
+    }
+
+    int BenchFlowField(uint32_t seed, int units)
+    {
+        using namespace AI::Pathfinding;
+        using Cell = AI::Pathfinding::Cell;
+
+        std::unique_ptr<Match> match = warmedMatch(seed);
+        World& world = match->world();
+
+        const Models::Unit* unit = world.units.front();
+        const float w = ASTAR_RISK_WEIGHT;
+        const Models::ivec2 depot = world.grid.landmarks().ammoBlue;
+        const Cell goal{ depot.first, depot.second };
+        Rng rng(seed, 98);
+
+        std::vector<Cell> starts;
+        for (int k = 0; k < units; ++k) {
+            int r, c;
+            if (!randomWalkable(world.grid, rng, r, c)) break;
+            starts.push_back({ r, c });
+        }
+
+        PathfinderContext& ctx = PathfinderContext::local();
+        Path path;
+        const int n = (int)starts.size();
+
+        struct Row { const char* name; Planner planner; double ms = 0; int found = 0; int invalid = 0; double cost = 0; };
+        Row rows[3] = { { "A*", Planner::Grid }, { "HPA*", Planner::Hierarchical }, { "flow", Planner::FlowField } };
+        world.flow.clear();
+        const int built0 = world.flow.fieldsBuilt();
+        for (Row& row : rows) {
+            row.ms = timeMs([&] {
+                for (const Cell& s : starts) {
+                    if (FindPath(ctx, unit, world.grid, world.smap, s, goal, w, path, row.planner)) {
+                        ++row.found;
+                        if (!pathValid(world.grid, path, s, goal)) ++row.invalid;
+                        row.cost += pathCost(world.smap, path, w);
+                    }
+                }
+            });
+        }
+
+        std::printf("flow-field bench: seed=%u units=%d goal=(%d,%d) fields built=%d\n",
+            seed, n, goal.first, goal.second, world.flow.fieldsBuilt() - built0);
+        std::printf("%-6s %10s %10s %8s %8s %10s\n", "", "total ms", "us/unit", "found", "invalid", "avg cost");
+        for (const Row& row : rows) {
+            std::printf("%-6s %10.2f %10.1f %8d %8d %10.1f\n", row.name, row.ms,
+                n ? row.ms * 1000.0 / n : 0.0, row.found, row.invalid, row.found ? row.cost / row.found : 0.0);
+        }
+
+        int r = starts.empty() ? 0 : starts[0].first, c = starts.empty() ? 0 : starts[0].second;
+        const int lookups = 100000;
+        int moved = 0;
+        const double lookupMs = timeMs([&] {
+            for (int i = 0; i < lookups; ++i) {
+                int nr, nc;
+                if (!world.flow.nextStep(world.grid, world.smap, goal, r, c, nr, nc)) { r = starts[0].first; c = starts[0].second; continue; }
+                r = nr; c = nc; ++moved;
+                if (r == goal.first && c == goal.second) { r = starts[0].first; c = starts[0].second; }
+            }
+        });
+        std::printf("nextStep: %.1f ns/lookup (%d steps)\n", lookupMs * 1e6 / lookups, moved);
+
+        return verdict(rows[0].found == rows[2].found && rows[2].invalid == 0,
+            "flow field reaches every goal A* does, all paths valid");
+    }
+
+    int BenchPathJobs(uint32_t seed, int requests, int workers)
+    {
+        using namespace AI::Pathfinding;
+        using Cell = AI::Pathfinding::Cell;
+
+        std::unique_ptr<Match> match = warmedMatch(seed);
+        World& world = match->world();
+
+        const Models::Unit* unit = world.units.front();
+        const float w = RiskWeightForUnit(unit);
+        Rng rng(seed, 97);
+
+        std::vector<std::pair<Cell, Cell>> queries;
+        for (int tries = 0; (int)queries.size() < requests && tries < requests * 50; ++tries) {
+            int sr, sc, gr, gc;
+            if (!randomWalkable(world.grid, rng, sr, sc) || !randomWalkable(world.grid, rng, gr, gc)) break;
+            if (std::abs(sr - gr) + std::abs(sc - gc) < HPA_MIN_DISTANCE) continue;
+            if (world.isSharedGoal(gr, gc)) continue;
+            queries.push_back({ { sr, sc }, { gr, gc } });
+        }
+        const int n = (int)queries.size();
+
+        std::vector<Path> direct(n);
+        const double directMs = timeMs([&] {
+            for (int i = 0; i < n; ++i)
+                FindPath(PathfinderContext::local(), unit, world.grid, world.smap,
+                    queries[i].first, queries[i].second, w, direct[i], Planner::Hierarchical);
+        });
+
+        PathJobQueue& jobs = world.paths;
+        jobs.clear();
+        jobs.setWorkers(workers);
+        std::vector<Ticket> tickets(n);
+        std::vector<Path> queued(n);
+        std::vector<bool> doneFlags(n);
+        double submitMs = 0.0, worstMs = 0.0;
+        int ticks = 0, found = 0;
+        // The first round also builds each thread's HPA* graph; time the second.
+        for (int round = 0; round < 2; ++round) {
+            submitMs = timeMs([&] {
+                for (int i = 0; i < n; ++i)
+                    tickets[i] = jobs.request(unit, queries[i].first, queries[i].second, Planner::Hierarchical);
+                jobs.dispatch(world.grid, world.smap, world.occupancy);
+            });
+
+            std::fill(doneFlags.begin(), doneFlags.end(), false);
+            worstMs = 0.0;
+            ticks = 0;
+            found = 0;
+            for (int left = n; left > 0 && ticks < 1000; ) {
+                worstMs = std::max(worstMs, timeMs([&] {
+                    if (ticks > 0) jobs.dispatch(world.grid, world.smap, world.occupancy);
+                    jobs.deliver();
+                }));
+                ++ticks;
+                for (int i = 0; i < n; ++i) {
+                    if (doneFlags[i]) continue;
+                    const JobStatus st = jobs.take(tickets[i], queued[i]);
+                    if (st == JobStatus::Pending) continue;
+                    doneFlags[i] = true;
+                    --left;
+                    if (st == JobStatus::Ready) ++found;
+                }
+            }
+        }
+        int same = 0;
+        for (int i = 0; i < n; ++i) if (queued[i] == direct[i]) ++same;
+
+        std::printf("path-job bench: seed=%u requests=%d workers=%d node budget=%d/tick\n",
+            seed, n, jobs.workers(), jobs.nodeBudget());
+        std::printf("in place:   %8.2f ms on the simulation thread\n", directMs);
+        std::printf("queued:     %8.2f ms to submit + snapshot, then %d ticks, worst tick %.2f ms\n",
+            submitMs, ticks, worstMs);
+        std::printf("results:    %d found, %d/%d identical to the in-place paths\n", found, same, n);
+
+        // An unreachable goal: walled in, so A* drains its whole open set.
+        int gr = -1, gc = -1;
+        for (int tries = 0; tries < 1000 && gr < 0; ++tries) {
+            int r, c;
+            if (!randomWalkable(world.grid, rng, r, c)) break;
+            if (r < 2 || c < 2 || r >= GRID_SIZE - 2 || c >= GRID_SIZE - 2 || world.isSharedGoal(r, c)) continue;
+            gr = r; gc = c;
+        }
+        if (gr < 0) return verdict(false, "found a goal to wall in");
+        const int dr[4] = { +1,-1,0,0 };
+        const int dc[4] = { 0,0,+1,-1 };
+        for (int k = 0; k < 4; ++k) world.grid.set(gr + dr[k], gc + dc[k], ROCK);
+        const Cell start = queries.empty() ? Cell{ unit->row, unit->col } : queries[0].first;
+        Path path;
+
+        bool directFound = false;
+        const double walledMs = timeMs([&] {
+            directFound = AStar_FindPath(PathfinderContext::local(), unit, world.grid, world.smap,
+                start, { gr, gc }, w, path);
+        });
+
+        const auto before = jobs.stats();
+        const Ticket t = jobs.request(unit, start, { gr, gc }, Planner::Grid);
+        worstMs = 0.0;
+        ticks = 0;
+        JobStatus st = JobStatus::Pending;
+        while (st == JobStatus::Pending && ticks < 4 * PATH_MAX_SLICES) {
+            worstMs = std::max(worstMs, timeMs([&] {
+                jobs.dispatch(world.grid, world.smap, world.occupancy);
+                jobs.deliver();
+            }));
+            ++ticks;
+            st = jobs.take(t, path);
+        }
+        const char* outcome = st == JobStatus::Partial ? "partial" : st == JobStatus::Ready ? "found"
+            : st == JobStatus::Failed ? "failed" : "pending";
+        std::printf("walled-in goal (%d,%d):\n", gr, gc);
+        std::printf("in place:   %8.2f ms, %s\n", walledMs, directFound ? "found" : "no path");
+        std::printf("queued:     %d ticks, worst tick %.2f ms, %llu suspensions, result %s (%d cells)\n",
+            ticks, worstMs, (unsigned long long)(jobs.stats().suspended - before.suspended), outcome, (int)path.size());
+
+        return verdict(same == n && !directFound && st == JobStatus::Partial,
+            "queued paths match in-place ones, walled-in goal ends partial");
+    }
+
+    int BenchOpenSet(uint32_t seed, int queries)
+    {
+        std::printf("open set bench: seed=%u queries=%d per map, 3 maps, cost step 1/%d\n", seed, queries, PATH_COST_SCALE);
+        std::printf("%-8s %-7s %12s %12s\n", "search", "queue", "us/search", "pushes");
+
+        double ms[2][2] = {};
+        long long pushes[2][2] = {};
+        double costSum[2] = {}, worstExcess = 0.0, worstDist = 0.0;
+        int searches = 0, fields = 0, overBound = 0;
+        HeapOpen heap;
+        BucketOpen bucket;
+        std::vector<float> dist[2];
+        std::vector<uint8_t> closed;
+
+        for (int m = 0; m < 3; ++m) {
+            std::unique_ptr<Match> match = warmedMatch(seed + m);
+            World& world = match->world();
+            const float w = ASTAR_RISK_WEIGHT;
+            Rng rng(seed + m, 96);
+
+            for (int q = 0; q < queries; ++q) {
+                int sr, sc, gr, gc;
+                if (!randomWalkable(world.grid, rng, sr, sc) || !randomWalkable(world.grid, rng, gr, gc)) break;
+                if (world.connectivity.unreachable(sr, sc, gr, gc)) continue;
+                const int s0 = sr * GRID_SIZE + sc, g0 = gr * GRID_SIZE + gc;
+                int p = 0;
+                float a = 0.0f, b = 0.0f;
+                ms[0][0] += timeMs([&] { a = gridSearch(heap, world.grid, world.smap, s0, g0, w, dist[0], closed, p); });
+                pushes[0][0] += p; p = 0;
+                ms[0][1] += timeMs([&] { b = gridSearch(bucket, world.grid, world.smap, s0, g0, w, dist[1], closed, p); });
+                pushes[0][1] += p;
+                costSum[0] += a; costSum[1] += b;
+                worstExcess = std::max(worstExcess, (double)(b - a));
+                // Every step costs at least 1, so the path has at most `a`
+                // steps, and the bucket queue may settle each one up to one
+                // cost step late.
+                if (b - a > a / PATH_COST_SCALE) ++overBound;
+                ++searches;
+            }
+
+            // Whole-map Dijkstra, as a flow field is built.
+            for (int k = 0; k < 4; ++k) {
+                int r, c;
+                if (!randomWalkable(world.grid, rng, r, c)) break;
+                for (int v = 0; v < 2; ++v) {
+                    int p = 0;
+                    ms[1][v] += timeMs([&] {
+                        if (v == 0) gridSearch(heap, world.grid, world.smap, r * GRID_SIZE + c, -1, w, dist[0], closed, p);
+                        else        gridSearch(bucket, world.grid, world.smap, r * GRID_SIZE + c, -1, w, dist[1], closed, p);
+                    });
+                    pushes[1][v] += p;
+                }
+                for (size_t i = 0; i < dist[0].size(); ++i)
+                    if (dist[0][i] < std::numeric_limits<float>::infinity())
+                        worstDist = std::max(worstDist, (double)std::abs(dist[1][i] - dist[0][i]));
+                ++fields;
+            }
+        }
+
+        const char* names[2] = { "heap", "bucket" };
+        for (int v = 0; v < 2; ++v)
+            std::printf("%-8s %-7s %12.1f %12.1f\n", "A*", names[v],
+                searches ? ms[0][v] * 1000.0 / searches : 0.0,
+                searches ? (double)pushes[0][v] / searches : 0.0);
+        for (int v = 0; v < 2; ++v)
+            std::printf("%-8s %-7s %12.1f %12.1f\n", "Dijkstra", names[v],
+                fields ? ms[1][v] * 1000.0 / fields : 0.0,
+                fields ? (double)pushes[1][v] / fields : 0.0);
+        std::printf("A*: avg cost heap %.3f bucket %.3f, worst excess %.4f, %d over path cost/%d; Dijkstra: worst cost gap %.4f\n",
+            searches ? costSum[0] / searches : 0.0, searches ? costSum[1] / searches : 0.0, worstExcess,
+            overBound, PATH_COST_SCALE, worstDist);
+        std::printf("speedup: A* %.2fx, Dijkstra %.2fx\n", speedup(ms[0][0], ms[0][1]), speedup(ms[1][0], ms[1][1]));
+        return verdict(searches > 0 && fields > 0 && overBound == 0 && worstDist == 0.0,
+            "bucket queue costs within the quantization bound");
+    }
+
+    int BenchGridKernels(uint32_t seed, int queries)
+    {
+        using namespace AI::Pathfinding;
+        using Cell = AI::Pathfinding::Cell;
+
+        std::unique_ptr<Match> match = warmedMatch(seed);
+        World& world = match->world();
+
+        const Models::Unit* unit = world.units.front();
+        const float w = RiskWeightForUnit(unit);
+        Rng rng(seed, 95);
+        std::vector<std::pair<Cell, Cell>> pairs;
+        for (int tries = 0; (int)pairs.size() < queries && tries < queries * 50; ++tries) {
+            int sr, sc, gr, gc;
+            if (!randomWalkable(world.grid, rng, sr, sc) || !randomWalkable(world.grid, rng, gr, gc)) break;
+            if (world.connectivity.unreachable(sr, sc, gr, gc)) continue;
+            pairs.push_back({ { sr, sc }, { gr, gc } });
+        }
+        if (pairs.empty()) return verdict(false, "found reachable query pairs");
+
+        PathfinderContext ctx;
+        Path a, b;
+        double ms[2][2] = {};
+        int same[2] = {};
+        for (const auto& q : pairs) {
+            ms[0][0] += timeMs([&] { legacyAStar(ctx, &world.occupancy, unit->id, world.grid, world.smap, q.first, q.second, w, a); });
+            ms[0][1] += timeMs([&] { AStar_FindPath(ctx, &world.occupancy, unit->id, world.grid, world.smap, q.first, q.second, w, b); });
+            if (a == b) ++same[0];
+
+            ms[1][0] += timeMs([&] { legacyBFS(ctx, world.grid, q.first, q.second, a); });
+            ms[1][1] += timeMs([&] { BFS_FindPath(ctx, world.grid, q.first, q.second, b); });
+            if (a == b) ++same[1];
+        }
+
+        const int n = (int)pairs.size();
+        std::printf("grid kernel bench: seed=%u queries=%d\n", seed, n);
+        std::printf("%-6s %14s %14s %9s %12s\n", "search", "bounds us/q", "padded us/q", "speedup", "same path");
+        const char* names[2] = { "A*", "BFS" };
+        for (int k = 0; k < 2; ++k)
+            std::printf("%-6s %14.1f %14.1f %8.2fx %8d/%d\n", names[k],
+                ms[k][0] * 1000.0 / n, ms[k][1] * 1000.0 / n,
+                speedup(ms[k][0], ms[k][1]), same[k], n);
+        return verdict(same[0] == n && same[1] == n, "padded kernels return the same paths");
+    }
+
+    int BenchTerrain(uint32_t seed, int rounds)
+    {
+        using Models::Plane;
+
+        std::unique_ptr<Match> match = testMatch(seed);
+        const Models::Grid& grid = match->world().grid;
+        const int N = GRID_SIZE;
+
+        // The old representation: one int per cell, predicates switching
+        // on the raw value.
+        std::vector<int> cells((size_t)N * N);
+        for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c) cells[(size_t)r * N + c] = grid.at(r, c);
+        auto legacyWalkable = [](int v) { return v != ROCK && v != WATER; };
+        auto legacyBlocksExplosive = [](int v) {
+            return v == ROCK || v == TREE || v == DEPOT_AMMO || v == DEPOT_MED;
+        };
+
+        int counts[2][4] = {};
+        const double scanMs = timeMs([&] {
+            for (int k = 0; k < rounds; ++k) {
+                int rock = 0, tree = 0, water = 0, depot = 0;
+                for (int v : cells) {
+                    switch (v) {
+                    case ROCK: ++rock; break;
+                    case TREE: ++tree; break;
+                    case WATER: ++water; break;
+                    case DEPOT_AMMO: case DEPOT_MED: ++depot; break;
+                    default: break;
+                    }
+                }
+                counts[0][0] += rock; counts[0][1] += tree; counts[0][2] += water; counts[0][3] += depot;
+            }
+        });
+
+        const double planeMs = timeMs([&] {
+            for (int k = 0; k < rounds; ++k) {
+                const int rock = grid.plane(Plane::BlocksLOS).count();
+                const int depot = grid.plane(Plane::Depot).count();
+                counts[1][0] += rock;
+                counts[1][1] += grid.plane(Plane::BlocksExplosive).count() - rock - depot;
+                counts[1][2] += N * N - grid.plane(Plane::Walkable).count() - rock;
+                counts[1][3] += depot;
+            }
+        });
+
+        // Random probes of the two predicates with the most cases.
+        Rng rng(seed, 94);
+        std::vector<std::pair<int, int>> probes(1 << 18);
+        for (auto& p : probes) {
+            p.first = rng.range(0, N - 1);
+            p.second = rng.range(0, N - 1);
+        }
+        int hits[2] = {};
+        const double switchMs = timeMs([&] {
+            for (int k = 0; k < rounds; ++k) {
+                for (const auto& p : probes) {
+                    const int v = cells[(size_t)p.first * N + p.second];
+                    hits[0] += legacyWalkable(v) + legacyBlocksExplosive(v);
+                }
+            }
+        });
+        const double bitMs = timeMs([&] {
+            for (int k = 0; k < rounds; ++k) {
+                for (const auto& p : probes)
+                    hits[1] += grid.walkable(p.first, p.second) + grid.blocksExplosive(p.first, p.second);
+            }
+        });
+
+        const bool same = std::equal(counts[0], counts[0] + 4, counts[1]) && hits[0] == hits[1];
+        std::printf("terrain bench: seed=%u rounds=%d\n", seed, rounds);
+        std::printf("cell storage: %zu bytes as int, %zu bytes as uint8 (padded)\n",
+            cells.size() * sizeof(int), (size_t)Models::Grid::PADDED_CELLS * sizeof(Models::CellT));
+        std::printf("%-14s %12s %12s %9s\n", "op", "int ms", "planes ms", "speedup");
+        std::printf("%-14s %12.3f %12.3f %8.2fx\n", "map counts", scanMs, planeMs, speedup(scanMs, planeMs));
+        std::printf("%-14s %12.3f %12.3f %8.2fx\n", "probes", switchMs, bitMs, speedup(switchMs, bitMs));
+        return verdict(same, "planes match the int cells");
+    }
+
+    int BenchCoverField(uint32_t seed, int scans)
+    {
+        using AI::Pathfinding::CoverField;
+
+        std::unique_ptr<Match> match = testMatch(seed);
+        const Models::Grid& grid = match->world().grid;
+        const int N = GRID_SIZE;
+        const int RADIUS = 35;  // State_RetreatingToCover's search window
+
+        CoverField field;
+        const double buildMs = timeMs([&] { field.sync(grid); });
+
+        // Retreat-style scans: a window around a random cell, each cell
+        // classified as rock-adjacent and, if so, tested for LOS to a
+        // random threat.
+        Rng rng(seed, 93);
+        struct Scan { int r, c, er, ec; };
+        std::vector<Scan> jobs;
+        for (int k = 0; k < scans; ++k) {
+            Scan s;
+            if (!randomWalkable(grid, rng, s.r, s.c) || !randomWalkable(grid, rng, s.er, s.ec)) break;
+            jobs.push_back(s);
+        }
+        if (jobs.empty()) return verdict(false, "found walkable scan centres");
+
+        auto legacyAdjacentToRock = [&](int r, int c) {
+            static const int dr[] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+            static const int dc[] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+            for (int i = 0; i < 8; ++i) {
+                const int nr = r + dr[i], nc = c + dc[i];
+                if (nr >= 0 && nr < N && nc >= 0 && nc < N && grid.at(nr, nc) == ROCK) return true;
+            }
+            return false;
+        };
+
+        long long tally[2][2] = {};     // [probe|field][adjacent, seen]
+        long long rays[2] = {};
+        double ms[2] = {};
+        for (int mode = 0; mode < 2; ++mode) {
+            ms[mode] = timeMs([&] {
+                for (const Scan& s : jobs) {
+                    for (int r = std::max(0, s.r - RADIUS); r <= std::min(N - 1, s.r + RADIUS); ++r) {
+                        for (int c = std::max(0, s.c - RADIUS); c <= std::min(N - 1, s.c + RADIUS); ++c) {
+                            if (!grid.walkable(r, c)) continue;
+                            const bool adjacent = mode == 0 ? legacyAdjacentToRock(r, c) : field.rockAdjacent(r, c);
+                            if (!adjacent) continue;
+                            ++tally[mode][0];
+                            bool seen;
+                            if (mode == 1 && field.coveredFrom(r, c, s.er, s.ec)) seen = false;
+                            else { ++rays[mode]; seen = AI::Visibility::HasLineOfSight(grid, r, c, s.er, s.ec); }
+                            if (seen) ++tally[mode][1];
+                        }
+                    }
+                }
+            });
+        }
+
+        const bool same = tally[0][0] == tally[1][0] && tally[0][1] == tally[1][1];
+        const int n = (int)jobs.size();
+        std::printf("cover field bench: seed=%u scans=%d build=%.3f ms\n", seed, n, buildMs);
+        std::printf("%-10s %12s %14s %12s\n", "", "ms/scan", "rock-adjacent", "LOS rays");
+        std::printf("%-10s %12.3f %14lld %12lld\n", "probes", ms[0] / n, tally[0][0], rays[0]);
+        std::printf("%-10s %12.3f %14lld %12lld\n", "field", ms[1] / n, tally[1][0], rays[1]);
+        std::printf("speedup %.2fx\n", speedup(ms[0], ms[1]));
+        return verdict(same, "field matches the per-cell probes");
+    }
+
+    int BenchFieldOfView(uint32_t seed, int viewpoints)
+    {
+        using AI::Visibility;
+        using AI::VisMask;
+
+        std::unique_ptr<Match> match = crowdedMatch(seed);
+        const World& world = match->world();
+        const Models::Grid& grid = world.grid;
+
+        // Per viewpoint: the Rays mask is one HasLineOfSight ray per cell
+        // in range, so diffing against it checks the shadowcaster against
+        // the ray test cell by cell. The two disagree on some cells along
+        // wall edges (Bresenham rays are not symmetric), never by much: a
+        // few percent of one unit's cells, less over many. The shadowcaster
+        // never misses a cell a ray reaches, so only[0] must stay 0.
+        const double BOUND = 0.02;
+        const double VIEWPOINT_BOUND = 0.05;
+        Rng rng(seed, 91);
+        VisMask rays, cast;
+        double ms[2] = {};
+        long long seen[2] = {}, only[2] = {};
+        double worst = 0.0;
+        int n = 0;
+        for (; n < viewpoints; ++n) {
+            int r = 0, c = 0;
+            if (!randomWalkable(grid, rng, r, c)) break;
+            ms[0] += timeMs([&] { Visibility::BuildUnitVisibility(grid, r, c, SIGHT_RANGE, rays, Visibility::Mode::Rays); });
+            ms[1] += timeMs([&] { Visibility::BuildUnitVisibility(grid, r, c, SIGHT_RANGE, cast, Visibility::Mode::Shadowcast); });
+            const int a = rays.count(), b = cast.count();
+            const int ra = VisMask::countAndNot(rays, cast), cb = VisMask::countAndNot(cast, rays);
+            seen[0] += a; seen[1] += b;
+            only[0] += ra; only[1] += cb;
+            if (a > 0) worst = std::max(worst, double(ra + cb) / a);
+        }
+
+        // The GUI overlay: rebuildVisibility builds one team's mask on every
+        // toggle. Averaged over both teams of the crowded world.
+        const int rebuilds = 10;
+        double overlayMs[2] = {};
+        VisMask team;
+        for (int mode = 0; mode < 2; ++mode) {
+            const Visibility::Mode m = mode == 0 ? Visibility::Mode::Rays : Visibility::Mode::Shadowcast;
+            overlayMs[mode] = timeMs([&] {
+                for (int k = 0; k < rebuilds; ++k) {
+                    Visibility::BuildTeamVisibility(grid, world.units, Team::Blue, SIGHT_RANGE, team, m);
+                    Visibility::BuildTeamVisibility(grid, world.units, Team::Orange, SIGHT_RANGE, team, m);
+                }
+            }) / (2 * rebuilds);
+        }
+
+        const double disagree = seen[0] > 0 ? double(only[0] + only[1]) / seen[0] : 0.0;
+        std::printf("field-of-view bench: seed=%u viewpoints=%d sight=%d units=%zu\n",
+            seed, n, SIGHT_RANGE, world.units.size());
+        std::printf("%-11s %12s %14s %12s\n", "", "us/unit", "cells/unit", "only here");
+        std::printf("%-11s %12.1f %14.1f %12lld\n", "rays", n ? ms[0] * 1000.0 / n : 0.0,
+            n ? (double)seen[0] / n : 0.0, only[0]);
+        std::printf("%-11s %12.1f %14.1f %12lld\n", "shadowcast", n ? ms[1] * 1000.0 / n : 0.0,
+            n ? (double)seen[1] / n : 0.0, only[1]);
+        std::printf("team overlay rebuild: rays %.2f ms, shadowcast %.2f ms (%.2fx)\n",
+            overlayMs[0], overlayMs[1], speedup(overlayMs[0], overlayMs[1]));
+        std::printf("cells in disagreement: %.3f%% overall (bound %.1f%%), %.3f%% worst viewpoint (bound %.1f%%)\n",
+            disagree * 100.0, BOUND * 100.0, worst * 100.0, VIEWPOINT_BOUND * 100.0);
+        return verdict(n > 0 && only[0] == 0 && disagree <= BOUND && worst <= VIEWPOINT_BOUND,
+            "shadowcast agrees with the ray test");
+    }
+
+    int BenchSpatialHash(uint32_t seed, int units)
+    {
+        using Simulation::SpatialHash;
+
+        Rng rng(seed, 92);
+        std::unique_ptr<World> world = scatteredWorld(rng, units);
+
+        const float aoe2 = 2.8f * 2.8f, friend2 = 2.2f * 2.2f, range2 = float(FIRE_RANGE * FIRE_RANGE);
+        const int K = 4;
+        const int frames = 20;
+
+        // The full scans the call sites used to run.
+        auto scanCount = [&](uint8_t teams, int r, int c, float rad2) {
+            int n = 0;
+            for (const auto* o : world->units) {
+                if (!o->isAlive || !(teams & SpatialHash::only(o->team))) continue;
+                const int dr = o->row - r, dc = o->col - c;
+                if (float(dr * dr + dc * dc) <= rad2) ++n;
+            }
+            return n;
+        };
+        auto scanNearest = [&](uint8_t teams, int r, int c) {
+            const Models::Unit* best = nullptr;
+            float bestD2 = std::numeric_limits<float>::infinity();
+            for (const auto* o : world->units) {
+                if (!o->isAlive || !(teams & SpatialHash::only(o->team))) continue;
+                const int dr = o->row - r, dc = o->col - c;
+                const float d2 = float(dr * dr + dc * dc);
+                if (d2 < bestD2) { bestD2 = d2; best = o; }
+            }
+            return best;
+        };
+        auto scanNearestK = [&](uint8_t teams, int r, int c, std::vector<std::pair<float, int>>& out) {
+            out.clear();
+            for (const auto* o : world->units) {
+                if (!o->isAlive || !(teams & SpatialHash::only(o->team))) continue;
+                const int dr = o->row - r, dc = o->col - c;
+                out.push_back({ float(dr * dr + dc * dc), o->id });
+            }
+            std::sort(out.begin(), out.end());
+            if ((int)out.size() > K) out.resize(K);
+        };
+
+        double ms[2] = {};
+        long long checks = 0, mismatches = 0;
+        std::vector<std::pair<float, int>> scanK;
+        Models::Unit* idxK[K];
+        for (int f = 0; f < frames; ++f) {
+            for (auto* u : world->units) {
+                const int r = std::max(0, std::min(GRID_SIZE - 1, u->row + rng.range(-1, 1)));
+                const int c = std::max(0, std::min(GRID_SIZE - 1, u->col + rng.range(-1, 1)));
+                u->moveTo(r, c);
+            }
+
+            long long sum[2] = {};
+            ms[0] += timeMs([&] {
+                for (const auto* u : world->units) {
+                    const uint8_t enemies = SpatialHash::enemiesOf(u->team);
+                    sum[0] += scanCount(enemies, u->row, u->col, aoe2);
+                    sum[0] += scanCount(SpatialHash::only(u->team), u->row, u->col, friend2) > 0;
+                    sum[0] += scanCount(enemies, u->row, u->col, range2) > 0;
+                    const Models::Unit* n = scanNearest(enemies, u->row, u->col);
+                    sum[0] += n ? n->id : 0;
+                    scanNearestK(enemies, u->row, u->col, scanK);
+                    for (const auto& h : scanK) sum[0] += h.second;
+                }
+            });
+
+            ms[1] += timeMs([&] {
+                for (const auto* u : world->units) {
+                    const uint8_t enemies = SpatialHash::enemiesOf(u->team);
+                    const SpatialHash& idx = world->proximity;
+                    sum[1] += idx.countWithin(enemies, u->row, u->col, aoe2);
+                    sum[1] += idx.anyWithin(SpatialHash::only(u->team), u->row, u->col, friend2);
+                    sum[1] += idx.anyWithin(enemies, u->row, u->col, range2);
+                    const Models::Unit* n = idx.nearest(enemies, u->row, u->col);
+                    sum[1] += n ? n->id : 0;
+                    const int k = idx.nearestK(enemies, u->row, u->col, K, idxK);
+                    for (int i = 0; i < k; ++i) sum[1] += idxK[i]->id;
+                }
+            });
+            ++checks;
+            if (sum[0] != sum[1]) ++mismatches;
+        }
+
+        const double perFrame[2] = { ms[0] / frames, ms[1] / frames };
+        std::printf("spatial hash bench: seed=%u units=%d frames=%d (5 queries per unit per frame)\n",
+            seed, units, frames);
+        std::printf("%-8s %12s\n", "", "ms/frame");
+        std::printf("%-8s %12.3f\n", "scan", perFrame[0]);
+        std::printf("%-8s %12.3f\n", "index", perFrame[1]);
+        std::printf("speedup %.2fx, %lld/%lld frames differ\n", speedup(perFrame[0], perFrame[1]), mismatches, checks);
+        return verdict(mismatches == 0, "index answers match the scans");
+    }
+
+    int BenchProjectiles(uint32_t seed, int bullets)
+    {
+        using Combat::ProjectilePool;
+
+        const int frames = 300;
+        const int sweep = 16;       // ticks per fast-forward call
+        bullets = std::min(bullets, ProjectilePool::CAPACITY);
+
+        // Two copies of the test world with a crowd of extra units, so the
+        // swept hits have something to find.
+        std::unique_ptr<Match> matches[2] = { crowdedMatch(seed), crowdedMatch(seed) };
+        const Models::Grid& grid = matches[0]->world().grid;
+        const uint8_t* props = grid.paddedProps();
+
+        // The same swept walk over an array of structs, one struct per
+        // bullet with its GridRay inline, against the pool. Neither side
+        // has units to hit, so both do exactly the same work: walk the
+        // cells crossed this tick, deposit risk in each, stop on terrain.
+        struct Bullet { float r, c, orgR, orgC, dr, dc; Combat::GridRay ray; int steps; Team team; uint8_t flags; bool alive; };
+        std::vector<Bullet> legacy;
+        legacy.reserve(bullets);
+        Combat::System swept;
+        swept.hitscan = false;
+        const float speed = swept.bulletSpeed;
+        Simulation::SecurityMap smap, legacySmap;
+
+        // Both sides are topped up to `bullets` every frame from the same
+        // stream of random muzzles and headings.
+        Rng rngA(seed, 94), rngB(seed, 94);
+        auto muzzle = [&](Rng& rng, float& r, float& c, float& dr, float& dc) {
+            int ir = 0, ic = 0;
+            randomWalkable(grid, rng, ir, ic);
+            const float a = (float)rng.range(0, 359) * 0.0174533f;
+            r = (float)ir; c = (float)ic;
+            dr = std::sin(a); dc = std::cos(a);
+        };
+
+        double ms[2] = {};
+        long long steps = 0, differ = 0;
+        for (int f = 0; f < frames; ++f) {
+            while ((int)legacy.size() < bullets) {
+                Bullet b{};
+                float r, c, dr, dc;
+                muzzle(rngA, r, c, dr, dc);
+                // Aimed at (r+dr, c+dc) and normalised as fireBulletTowards does.
+                b.dr = (r + dr) - r; b.dc = (c + dc) - c;
+                const float L = std::sqrt(b.dr * b.dr + b.dc * b.dc);
+                b.dr /= L; b.dc /= L;
+                b.r = b.orgR = r + 0.5f; b.c = b.orgC = c + 0.5f;
+                b.team = Team::Blue;
+                b.alive = b.ray.start(b.r, b.c, b.dr, b.dc);
+                legacy.push_back(b);
+            }
+            while ((int)swept.bulletsCount() < bullets) {
+                float r, c, dr, dc;
+                muzzle(rngB, r, c, dr, dc);
+                swept.fireBulletTowards(r, c, r + dr, c + dc, Team::Blue);
+            }
+            steps += (long long)legacy.size();
+
+            ms[0] += timeMs([&] {
+                for (auto& b : legacy) {
+                    if (!b.alive) continue;
+                    const float tEnd = float(++b.steps) * speed;
+                    float t;
+                    for (;;) {
+                        const int p = b.ray.enterNext(tEnd, props, &t);
+                        if (p == Combat::GridRay::NOT_YET) break;
+                        if (p == Combat::GridRay::STOPPED) { b.alive = false; break; }
+                        legacySmap.add(b.ray.row, b.ray.col, swept.secmIncrement);
+                    }
+                    b.r = b.orgR + b.dr * tEnd;
+                    b.c = b.orgC + b.dc * tEnd;
+                }
+                legacy.erase(std::remove_if(legacy.begin(), legacy.end(),
+                    [](const Bullet& x) { return !x.alive; }), legacy.end());
+            });
+
+            ms[1] += timeMs([&] { swept.advanceBullets(grid, smap, 1); });
+
+            differ += legacy.size() != swept.bulletsCount();
+        }
+        for (int r = 0; r < GRID_SIZE; ++r)
+            for (int c = 0; c < GRID_SIZE; ++c)
+                differ += legacySmap.at(r, c) != smap.at(r, c);
+
+        // Fast-forward: the same volley flown `sweep` single ticks in one
+        // world and one `sweep`-tick call in the other.
+        Combat::System volley[2];
+        Rng fire[2] = { Rng(seed, 97), Rng(seed, 97) };
+        for (int k = 0; k < 2; ++k) {
+            World& w = matches[k]->world();
+            volley[k].hitscan = false;
+            volley[k].bindUnits(&w.proximity);
+            for (int i = 0; i < bullets; ++i) {
+                float r, c, dr, dc;
+                muzzle(fire[k], r, c, dr, dc);
+                volley[k].fireBulletTowards(r, c, r + dr, c + dc, (i & 1) ? Team::Orange : Team::Blue);
+            }
+        }
+        double ffMs[2] = {};
+        int rounds = 0;
+        while (volley[0].bulletsCount() > 0 && rounds < 20) {
+            ffMs[0] += timeMs([&] {
+                for (int s = 0; s < sweep; ++s)
+                    volley[0].advanceBullets(matches[0]->world().grid, matches[0]->world().smap, 1);
+            });
+            ffMs[1] += timeMs([&] {
+                volley[1].advanceBullets(matches[1]->world().grid, matches[1]->world().smap, sweep);
+            });
+            ++rounds;
+        }
+        long long hurt = 0;
+        const World& w0 = matches[0]->world();
+        const World& w1 = matches[1]->world();
+        for (size_t i = 0; i < w0.units.size(); ++i) {
+            hurt += w0.units[i]->stats.hp != HP_MAX;
+            differ += w0.units[i]->stats.hp != w1.units[i]->stats.hp ||
+                      w0.units[i]->isAlive != w1.units[i]->isAlive;
+        }
+        for (int r = 0; r < GRID_SIZE; ++r)
+            for (int c = 0; c < GRID_SIZE; ++c)
+                differ += w0.smap.at(r, c) != w1.smap.at(r, c);
+        differ += volley[0].bulletsCount() != volley[1].bulletsCount();
+        for (int i = 0; i < (int)std::min(volley[0].bulletsCount(), volley[1].bulletsCount()); ++i)
+            differ += volley[0].projectiles.r(i) != volley[1].projectiles.r(i) ||
+                      volley[0].projectiles.c(i) != volley[1].projectiles.c(i);
+
+        std::printf("projectile bench: seed=%u bullets=%d frames=%d (%lld bullet steps, swept cells, terrain only)\n",
+            seed, bullets, frames, steps);
+        std::printf("%-8s %12s\n", "", "us/frame");
+        std::printf("%-8s %12.2f\n", "structs", ms[0] * 1000.0 / frames);
+        std::printf("%-8s %12.2f\n", "pool", ms[1] * 1000.0 / frames);
+        std::printf("speedup %.2fx\n", speedup(ms[0], ms[1]));
+        std::printf("fast-forward %d ticks x %d rounds: %.2f ms as single ticks, %.2f ms swept, %lld units hit, %lld differences\n",
+            sweep, rounds, ffMs[0], ffMs[1], hurt, differ);
+        return verdict(differ == 0, "pool matches the structs, one swept call matches single ticks");
+    }
+
+    int BenchBulletHits(uint32_t seed, int bullets)
+    {
+        using Simulation::SpatialHash;
+
+        const int units = std::max(1, bullets / 2);
+        Rng rng(seed, 95);
+        std::unique_ptr<World> world = scatteredWorld(rng, units);
+        const SpatialHash& idx = world->proximity;
+
+        const float radius = 0.35f, hit2 = radius * radius;   // Combat::System defaults
+        const int frames = 50;
+        struct Shot { float r, c; int p; Team team; };
+        std::vector<Shot> shots(bullets);
+        std::vector<int> hits[3];
+        for (auto& h : hits) h.resize(bullets);
+        std::vector<Models::Unit*> nearby;
+        Combat::UnitBins bins;
+
+        double ms[3] = {};
+        long long hitCount = 0, mismatches = 0;
+        for (int f = 0; f < frames; ++f) {
+            for (auto* u : world->units) {
+                const int r = std::max(0, std::min(GRID_SIZE - 1, u->row + rng.range(-1, 1)));
+                const int c = std::max(0, std::min(GRID_SIZE - 1, u->col + rng.range(-1, 1)));
+                u->moveTo(r, c);
+            }
+            for (auto& s : shots) {
+                s.r = rng.range(0, GRID_SIZE * 64 - 1) / 64.f;
+                s.c = rng.range(0, GRID_SIZE * 64 - 1) / 64.f;
+                s.p = Models::Grid::padIndex(int(s.r), int(s.c));
+                s.team = rng.range(0, 1) ? Team::Orange : Team::Blue;
+            }
+
+            // Every bullet against every unit, teammates skipped in the loop.
+            ms[0] += timeMs([&] {
+                for (int i = 0; i < bullets; ++i) {
+                    const Shot& s = shots[i];
+                    int best = 0;
+                    for (const auto* u : world->units) {
+                        if (!u->isAlive || u->team == s.team) continue;
+                        const float dr = s.r + 0.5f - (u->row + 0.5f), dc = s.c + 0.5f - (u->col + 0.5f);
+                        if (dr * dr + dc * dc <= hit2) { best = u->id; break; }
+                    }
+                    hits[0][i] = best;
+                }
+            });
+
+            // One spatial-hash gather per bullet.
+            ms[1] += timeMs([&] {
+                for (int i = 0; i < bullets; ++i) {
+                    const Shot& s = shots[i];
+                    int best = 0;
+                    idx.gather(SpatialHash::enemiesOf(s.team), s.r, s.c, radius, nearby);
+                    for (const auto* u : nearby) {
+                        const float dr = s.r + 0.5f - (u->row + 0.5f), dc = s.c + 0.5f - (u->col + 0.5f);
+                        if (dr * dr + dc * dc <= hit2) { best = u->id; break; }
+                    }
+                    hits[1][i] = best;
+                }
+            });
+
+            // Bin once, then 3x3 cells per bullet.
+            ms[2] += timeMs([&] {
+                bins.build(idx);
+                for (int i = 0; i < bullets; ++i) {
+                    const Shot& s = shots[i];
+                    const Models::Unit* u = bins.firstHit(SpatialHash::enemiesOf(s.team), s.p,
+                        s.r + 0.5f, s.c + 0.5f, hit2);
+                    hits[2][i] = u ? u->id : 0;
+                }
+            });
+
+            for (int i = 0; i < bullets; ++i) {
+                hitCount += hits[0][i] != 0;
+                if (hits[1][i] != hits[0][i] || hits[2][i] != hits[0][i]) ++mismatches;
+            }
+        }
+
+        const double perFrame[3] = { ms[0] / frames, ms[1] / frames, ms[2] / frames };
+        std::printf("bullet hit bench: seed=%u bullets=%d units=%d frames=%d (%lld hits)\n",
+            seed, bullets, units, frames, hitCount);
+        std::printf("%-8s %12s\n", "", "us/frame");
+        std::printf("%-8s %12.2f\n", "scan", perFrame[0] * 1000.0);
+        std::printf("%-8s %12.2f\n", "gather", perFrame[1] * 1000.0);
+        std::printf("%-8s %12.2f\n", "bins", perFrame[2] * 1000.0);
+        std::printf("bins vs scan %.1fx, vs gather %.2fx, %lld bullets differ\n",
+            speedup(perFrame[0], perFrame[2]), speedup(perFrame[1], perFrame[2]), mismatches);
+        return verdict(mismatches == 0, "bins and gather find the scan's hits");
+    }
+
+    int BenchHitscan(uint32_t seed, int shots)
+    {
+        const int frames = 300;
+        const char* names[2] = { "flying", "hitscan" };
+        double ms[2] = {};
+        size_t peak[2] = {};
+        long long damage[2] = {};
+        uint64_t dropped = 0;
+        // No unit moves, so hitscan lands each shot on the tick the
+        // projectile would: every unit's hp must match frame for frame, up
+        // to the last frame before the flying pool filled and dropped one.
+        int clean = frames;
+        std::vector<int> hp[2];
+        for (int k = 0; k < 2; ++k) {
+            std::unique_ptr<Match> match = crowdedMatch(seed);
+            World& w = match->world();
+            Combat::System combat;
+            combat.hitscan = k == 1;
+            combat.bindUnits(&w.proximity);
+            auto snapshot = [&]() {
+                hp[k].clear();
+                for (const auto* u : w.units) hp[k].push_back(u->stats.hp);
+            };
+            if (k == 0 || clean == 0) snapshot();
+
+            // The same volley every frame in both modes: `shots` bullets from
+            // random crowd members, a grenade burst every tenth frame.
+            Rng rng(seed, 98);
+            for (int f = 0; f < frames; ++f) {
+                for (int i = 0; i < shots; ++i) {
+                    const Models::Unit* u = w.units[rng.below((int)w.units.size())];
+                    const float a = (float)rng.range(0, 359) * 0.0174533f;
+                    combat.fireBulletTowards((float)u->row, (float)u->col,
+                        u->row + std::sin(a), u->col + std::cos(a), u->team);
+                }
+                if (f % 10 == 0) {
+                    const Models::Unit* u = w.units[rng.below((int)w.units.size())];
+                    combat.dropGrenade((float)u->row, (float)u->col, w.grid, u->team);
+                }
+                ms[k] += timeMs([&] { combat.tickBullets(w.grid, w.smap); });
+                peak[k] = std::max(peak[k], combat.bulletsCount());
+                if (k == 0 && clean == frames) {
+                    if (combat.droppedShots() > 0) clean = f;
+                    else snapshot();
+                }
+                else if (k == 1 && f + 1 == clean) snapshot();
+            }
+            for (const auto* u : w.units) damage[k] += HP_MAX - u->stats.hp;
+            if (k == 0) dropped = combat.droppedShots();
+        }
+
+        long long hpDiffer = 0;
+        for (size_t i = 0; i < hp[0].size(); ++i) hpDiffer += hp[0][i] != hp[1][i];
+
+        std::printf("hitscan bench: seed=%u shots/frame=%d frames=%d (crowded test world)\n",
+            seed, shots, frames);
+        std::printf("%-8s %12s %12s %12s\n", "", "us/frame", "peak live", "damage");
+        for (int k = 0; k < 2; ++k)
+            std::printf("%-8s %12.2f %12zu %12lld\n", names[k], ms[k] * 1000.0 / frames, peak[k], damage[k]);
+        std::printf("speedup %.2fx\n", speedup(ms[0], ms[1]));
+        std::printf("hp compared after %d of %d frames: %lld of %zu units differ", clean, frames, hpDiffer, hp[0].size());
+        if (dropped) std::printf(" (the flying pool then dropped %llu shots)", (unsigned long long)dropped);
+        std::printf("\n");
+        return verdict(clean > 0 && hp[0].size() == hp[1].size() && hpDiffer == 0,
+            "both modes leave every unit the same hp");
+    }
+
+    int BenchExplosions(uint32_t seed, int blasts)
+    {
+        using Simulation::SpatialHash;
+
+        std::unique_ptr<Match> matches[2] = { crowdedMatch(seed), crowdedMatch(seed) };
+        Combat::Explosions::Params blast;   // Combat::System defaults
+        Combat::Explosions service;
+
+        // Blasts land on a few dozen hot spots most of the time, like
+        // grenades thrown at the same defended cells, and on any walkable
+        // cell otherwise. Every 250 blasts a cell turns to rock.
+        Rng rng(seed, 99);
+        struct Blast { int r, c; Team team; bool edit; };
+        std::vector<Blast> plan;
+        std::vector<std::pair<int, int>> hot;
+        for (int i = 0; i < 48; ++i) {
+            int r = 0, c = 0;
+            randomWalkable(matches[0]->world().grid, rng, r, c);
+            hot.push_back({ r, c });
+        }
+        for (int i = 0; i < blasts; ++i) {
+            Blast b;
+            if (rng.below(4) != 0) { const auto& h = hot[rng.below((int)hot.size())]; b.r = h.first; b.c = h.second; }
+            else randomWalkable(matches[0]->world().grid, rng, b.r, b.c);
+            b.team = rng.below(2) ? Team::Orange : Team::Blue;
+            b.edit = i > 0 && i % 250 == 0;
+            plan.push_back(b);
+        }
+
+        double ms[2] = {};
+        for (int k = 0; k < 2; ++k) {
+            World& w = matches[k]->world();
+            Rng edits(seed, 100);
+            for (const Blast& b : plan) {
+                if (b.edit) {
+                    int r = 0, c = 0;
+                    randomWalkable(w.grid, edits, r, c);
+                    w.grid.set(r, c, ROCK);
+                }
+                const uint8_t teams = SpatialHash::enemiesOf(b.team);
+                ms[k] += timeMs([&] {
+                    if (k == 0) {
+                        // The loop applyGrenadeAoE used to run: every unit, a
+                        // raycast for each one in range.
+                        const float R2 = blast.radius * blast.radius;
+                        for (auto* u : w.units) {
+                            if (!u->isAlive || !(teams & SpatialHash::only(u->team))) continue;
+                            const float dr = float(b.r - u->row), dc = float(b.c - u->col);
+                            const float d2 = dr * dr + dc * dc;
+                            if (d2 > R2) continue;
+                            const float t = std::max(0.f, std::min(1.f, 1.0f - (std::sqrt(d2) / blast.radius)));
+                            float dmgf = float(blast.dmgEdge) + (float(blast.dmgCenter) - float(blast.dmgEdge)) * t;
+                            if (blast.cover && w.grid.blastBlocked(b.r, b.c, u->row, u->col)) dmgf *= blast.coverFactor;
+                            const int dmg = int(std::round(dmgf));
+                            if (dmg <= 0) continue;
+                            u->stats.hp -= dmg;
+                            if (u->stats.hp <= 0) { u->stats.hp = 0; u->kill(); }
+                        }
+                    }
+                    else {
+                        service.detonate(w.grid, w.proximity, b.r, b.c, teams, blast);
+                    }
+                });
+            }
+        }
+
+        long long differ = 0, damage = 0;
+        const World& w0 = matches[0]->world();
+        const World& w1 = matches[1]->world();
+        for (size_t i = 0; i < w0.units.size(); ++i) {
+            damage += HP_MAX - w0.units[i]->stats.hp;
+            differ += w0.units[i]->stats.hp != w1.units[i]->stats.hp ||
+                      w0.units[i]->isAlive != w1.units[i]->isAlive;
+        }
+
+        std::printf("explosion bench: seed=%u blasts=%d units=%zu (damage dealt %lld)\n",
+            seed, blasts, w0.units.size(), damage);
+        std::printf("%-8s %12s\n", "", "us/blast");
+        std::printf("%-8s %12.3f\n", "scan", ms[0] * 1000.0 / blasts);
+        std::printf("%-8s %12.3f   %lld cover masks built\n", "service", ms[1] * 1000.0 / blasts, service.coverBuilds());
+        std::printf("speedup %.2fx, %lld units differ\n", speedup(ms[0], ms[1]), differ);
+        return verdict(differ == 0, "service deals the scan's damage");
+    }
+
+} // namespace Simulation
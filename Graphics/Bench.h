@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+namespace Simulation {
+
+    // Micro-benchmarks for the headless runner. Each one builds the usual
+    // test world from `seed`, prints a small table and returns 0 on success.
+
+    // Random cross-map queries (Manhattan >= 60) with flat A* and with the
+    // hierarchical planner, plus the cost of re-syncing after terrain edits.
+    // Also checks incremental component labels against a full rebuild and
+    // times rejecting a walled-in goal.
+    int BenchPathfinding(uint32_t seed, int queries);
+
+    // `units` random start cells all heading for Blue's ammo depot: one
+    // search each (A*, HPA*) against one flow field shared by all of them.
+    int BenchFlowField(uint32_t seed, int units);
+
+    // A burst of `requests` cross-map replans in one tick: solved in place
+    // with FindPath, and through the PathJobQueue with `workers` threads
+    // (time the simulation thread spends submitting, then collecting).
+    // Then one walled-in goal, in place and time-sliced by the node budget.
+    int BenchPathJobs(uint32_t seed, int requests, int workers);
+
+    // The grid-search open set on its own: a binary heap against
+    // BucketQueue, for `queries` random A* queries and a few whole-map
+    // Dijkstra builds on three maps (seed, seed+1, seed+2). Reports time,
+    // pushes and how far the quantized ordering moves the costs. Fails if
+    // a Dijkstra cost differs at all, or if an A* cost exceeds the heap's
+    // by more than path cost / PATH_COST_SCALE.
+    int BenchOpenSet(uint32_t seed, int queries);
+
+    // Flat A* and BFS_FindPath on the padded grid against copies of the
+    // bounds-checked kernels they replaced, on the same `queries` pairs.
+    // Fails unless both produce identical paths.
+    int BenchGridKernels(uint32_t seed, int queries);
+
+    // Terrain counts and predicate probes on an int-per-cell copy of the
+    // map (switching on the raw value) against the property byte and
+    // bitplanes, `rounds` times each. Fails unless the results agree.
+    int BenchTerrain(uint32_t seed, int rounds);
+
+    // `scans` retreat-style cover scans (a 71x71 window, rock-adjacency
+    // plus line of sight to a threat) probing neighbours and walking every
+    // ray, against the CoverField masks. Fails unless the counts agree.
+    int BenchCoverField(uint32_t seed, int scans);
+
+    // Field of view from `viewpoints` random walkable cells, built with a
+    // line-of-sight ray per cell and with the shadowcaster, plus the time
+    // to rebuild both teams' overlay masks in each mode. Fails if the
+    // shadowcaster misses a cell a ray reaches, or if the cells seen by
+    // only one of the two pass 2% of the ray cells overall or 5% from
+    // any single viewpoint.
+    int BenchFieldOfView(uint32_t seed, int viewpoints);
+
+    // `units` units on an empty world take a random step per frame, then
+    // each runs the proximity queries the AI asks (enemies in blast
+    // radius, friend nearby, enemy in range, nearest, nearest 4) by full
+    // scan and through SpatialHash. Fails unless the answers agree.
+    int BenchSpatialHash(uint32_t seed, int units);
+
+    // `bullets` projectiles, topped up every frame from random muzzles,
+    // flown for a few hundred frames through terrain by the same swept
+    // cell walk over an array of structs and over the ProjectilePool. Then
+    // one volley into a crowded copy of the test world, flown 16 single
+    // ticks at a time in one copy and 16 ticks per call in the other.
+    // Fails unless both layouts leave the same risk deposits and bullet
+    // counts, and unless hits, deposits and survivors agree after the
+    // fast-forward.
+    int BenchProjectiles(uint32_t seed, int bullets);
+
+    // `bullets` random shots per frame against bullets/2 wandering units:
+    // every bullet against every unit, one spatial-hash gather per bullet,
+    // and UnitBins built once per frame. Fails unless all three pick the
+    // same unit for every bullet.
+    int BenchBulletHits(uint32_t seed, int bullets);
+
+    // `shots` bullets a frame (and a grenade every tenth frame) into a
+    // crowded test world, flown as projectiles and resolved as hitscan.
+    // Reports combat time per frame, the most shots live at once and the
+    // damage dealt. No unit moves, so it fails unless every unit has the
+    // same hp in both modes after the last frame before the flying pool
+    // first dropped a shot (after every frame if it never did).
+    int BenchHitscan(uint32_t seed, int shots);
+
+    // `blasts` grenade blasts, mostly on a few dozen hot spots, into a
+    // crowded test world whose terrain changes every 250 blasts: the old
+    // every-unit loop with a raycast per unit in range, against the
+    // Explosions service. Fails unless every unit ends with the same hp.
+    int BenchExplosions(uint32_t seed, int blasts);
+
+} // namespace Simulation
@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Definitions.h"
+
+namespace AI {
+    namespace Pathfinding {
+
+        // Monotone bucket queue (Dial's algorithm) for grid searches whose
+        // keys never drop below the last one popped: BFS rings, Dijkstra and
+        // A* with a consistent heuristic. Keys are integers, so float costs
+        // go through CostKey(); push and pop are O(1) amortized instead of
+        // O(log n), and equal keys come out first-in first-out.
+        //
+        // The buckets form a ring over [minKey, minKey + span). A key past
+        // the ring doubles it; a key below minKey (rounding in the caller)
+        // is treated as minKey. Bucket storage is kept between searches.
+        template <typename T>
+        class BucketQueue {
+        public:
+            explicit BucketQueue(uint32_t span = 64) { grow(span); }
+
+            bool   empty() const { return m_count == 0; }
+            size_t size() const { return m_count; }
+            uint32_t minKey() const { return m_cur; }
+
+            // Buckets behind the cursor are already empty, so only the live
+            // range ahead of it is touched.
+            void clear() {
+                for (uint32_t k = m_cur; ; ++k) {
+                    Bucket& b = m_ring[k & m_mask];
+                    m_count -= b.items.size() - b.head;
+                    b.items.clear();
+                    b.head = 0;
+                    if (m_count == 0) break;
+                }
+                m_cur = 0;
+            }
+
+            void push(uint32_t key, const T& value) {
+                if (key < m_cur) key = m_cur;
+                if (key - m_cur >= (uint32_t)m_ring.size()) grow(key - m_cur + 1);
+                m_ring[key & m_mask].items.push_back(value);
+                ++m_count;
+            }
+
+            // Oldest entry with the smallest key; the queue must not be empty.
+            T pop() {
+                Bucket* b = &m_ring[m_cur & m_mask];
+                while (b->head == b->items.size()) {
+                    b->items.clear();
+                    b->head = 0;
+                    b = &m_ring[++m_cur & m_mask];
+                }
+                --m_count;
+                return b->items[b->head++];
+            }
+
+        private:
+            struct Bucket {
+                std::vector<T> items;
+                size_t head = 0;
+            };
+
+            void grow(uint32_t span) {
+                size_t n = 1;
+                while (n < span) n <<= 1;
+                if (n <= m_ring.size()) return;
+                std::vector<Bucket> ring(n);
+                // Re-home the live buckets; their keys lie in [m_cur, m_cur + old size).
+                for (size_t k = 0; k < m_ring.size(); ++k) {
+                    const uint32_t key = m_cur + (uint32_t)k;
+                    ring[key & (n - 1)].items.swap(m_ring[key & m_mask].items);
+                    ring[key & (n - 1)].head = m_ring[key & m_mask].head;
+                }
+                m_ring.swap(ring);
+                m_mask = (uint32_t)n - 1;
+            }
+
+            std::vector<Bucket> m_ring;
+            uint32_t m_mask = 0;
+            uint32_t m_cur = 0;
+            size_t   m_count = 0;
+        };
+
+        // Integer key for a non-negative path cost.
+        inline uint32_t CostKey(float cost) {
+            return (uint32_t)(cost * (float)Definitions::PATH_COST_SCALE);
+        }
+
+    } // namespace Pathfinding
+} // namespace AI
@@ -1,54 +1,34 @@
 #include "Combat.h"
-#include "glut.h"
+#include "Profiler.h"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 
 using namespace Definitions;
 
-namespace {
-    inline bool blocksShot(int cell) { return (cell == ROCK); }
+namespace Combat {
 
-    inline float dist2(float r1, float c1, float r2, float c2) {
-        float dr = r1 - r2, dc = c1 - c2; return dr * dr + dc * dc;
+    namespace {
+        bool s_defaultHitscan = false;
     }
 
-    inline float clampf(float v, float lo, float hi) { return std::max(lo, std::min(hi, v)); }
+    void System::SetDefaultHitscan(bool on) { s_defaultHitscan = on; }
+    bool System::DefaultHitscan() { return s_defaultHitscan; }
 
-    inline bool blocksExplosive(const Models::Grid& grid, int r, int c) {
-        int cell = grid.at(r, c);
-        return (cell == TREE || cell == ROCK || cell == DEPOT_AMMO || cell == DEPOT_MED);
+    void System::launch(float r, float c, float dr, float dc, Definitions::Team team, uint8_t flags) {
+        if (hitscan) m_shots.push_back({ r, c, dr, dc, team });
+        else if (!projectiles.spawn(r, c, dr, dc, team, flags) && projectiles.size() == ProjectilePool::CAPACITY)
+            ++m_dropped;
     }
 
-    bool raycastBlocked(const Models::Grid& grid, int r0, int c0, int r1, int c1) {
-        int dr = std::abs(r1 - r0), dc = std::abs(c1 - c0);
-        int sr = (r0 < r1) ? 1 : -1;
-        int sc = (c0 < c1) ? 1 : -1;
-        int err = dr - dc;
-        int r = r0, c = c0;
-
-        while (!(r == r1 && c == c1)) {
-            if (blocksExplosive(grid, r, c)) return true;
-            int e2 = 2 * err;
-            if (e2 > -dc) { err -= dc; r += sr; }
-            if (e2 < dr) { err += dr; c += sc; }
-        }
-        return false;
-    }
-}
-
-namespace Combat {
-
     void System::fireBulletTowards(float r0, float c0, float rT, float cT, Definitions::Team shooterTeam) {
         float dr = rT - r0, dc = cT - c0;
         float L = std::sqrt(dr * dr + dc * dc);
         if (L < 1e-4f) return;
         dr /= L; dc /= L;
 
-        bullets.emplace_back(r0, c0, dr, dc, bulletTTL);
-        bullets.back().team = shooterTeam;
-
-        bullets.back().isShrapnel = false;
-        bullets.back().colR = 0.f; bullets.back().colG = 0.f; bullets.back().colB = 0.f;
+        // Rays start from the centre of the shooter's cell.
+        launch(r0 + 0.5f, c0 + 0.5f, dr, dc, shooterTeam, 0);
     }
 
 
@@ -89,40 +69,118 @@ namespace Combat {
             float a = i * dAlpha;
             float dr = std::cos(a);
             float dc = std::sin(a);
-            bullets.emplace_back(r0, c0, dr, dc, bulletTTL);
-            bullets.back().team = shooterTeam;
-
-            bullets.back().isShrapnel = true;
-            bullets.back().colR = 1.f; bullets.back().colG = 0.f; bullets.back().colB = 0.f;
+            launch(r0 + 0.5f, c0 + 0.5f, dr, dc, shooterTeam, ProjectilePool::SHRAPNEL);
         }
     }
 
 
-    void System::tickBullets(const Models::Grid& grid, Simulation::SecurityMap& smap) {
-        auto& risk = smap.data();
-
-        for (auto& b : bullets) {
-            if (!b.alive) continue;
-
-            float nr = b.r + bulletSpeed * b.dr;
-            float nc = b.c + bulletSpeed * b.dc;
-
-            if (nr < 0 || nr >= GRID_SIZE || nc < 0 || nc >= GRID_SIZE) { b.alive = false; continue; }
+    void System::advanceBullets(const Models::Grid& grid, Simulation::SecurityMap& smap, int steps) {
+        const int n = projectiles.size();
+        if (n == 0 || steps <= 0) return;
+        const uint8_t* props = grid.paddedProps();
+        m_binned = proximity && proximity->size() > 0;
+        if (m_binned) m_bins.build(*proximity);
+
+        // Sweep every projectile to its first unit, then settle the hits in
+        // the order single ticks would: by tick, then by slot. A bullet
+        // whose target went down first flies on and may queue another.
+        m_pending.clear();
+        std::fill(m_keep.begin(), m_keep.begin() + n, (uint8_t)1);
+        // Every moving projectile enters its next cell in one batch; only
+        // those that may meet a unit or cross another cell walk on.
+        const int moving = projectiles.enterCrossing(steps, bulletSpeed, props,
+            m_crossing.data(), m_entered.data(), m_tEntry.data());
+        m_deposits.clear();
+        for (int k = 0; k < moving; ++k) {
+            const int slot = m_crossing[k];
+            if (m_entered[k] == ProjectilePool::STOPPED) { m_keep[slot] = 0; continue; }
+            m_deposits.push_back(m_entered[k]);
+            if (m_binned || projectiles.crossesBy(slot, float(projectiles.steps(slot) + steps) * bulletSpeed))
+                sweepBullet(slot, steps, props, m_tEntry[k]);
+        }
+        while (!m_pending.empty()) {
+            std::pop_heap(m_pending.begin(), m_pending.end(), laterHit);
+            const PendingHit h = m_pending.back();
+            m_pending.pop_back();
+            if (!h.unit->isAlive) { sweepBullet(h.slot, steps, props, h.tEntry); continue; }
+            h.unit->stats.hp -= Definitions::DAMAGE_BULLET;
+            if (h.unit->stats.hp <= 0) { h.unit->stats.hp = 0; h.unit->kill(); }
+            m_keep[h.slot] = 0;
+        }
 
-            // Map collision
-            int cell = grid.at(int(nr), int(nc));
-            if (blocksShot(cell)) { b.alive = false; continue; }
+        // Every deposit is the same amount, so the order they land in
+        // does not change the sums.
+        smap.addPadded(m_deposits.data(), (int)m_deposits.size(), secmIncrement);
+        projectiles.advanceSteps(steps, bulletSpeed);
+        projectiles.compact(m_keep.data());
+    }
 
-            b.r = nr; b.c = nc;
-            risk[int(b.r)][int(b.c)] += secmIncrement;
+    void System::resolveShots(const Models::Grid& grid, Simulation::SecurityMap& smap) {
+        const uint8_t* props = grid.paddedProps();
+        bool binsBuilt = false;
+        auto buildBins = [&]() {
+            if (binsBuilt) return;
+            m_binned = proximity && proximity->size() > 0;
+            if (m_binned) m_bins.build(*proximity);
+            binsBuilt = true;
+        };
+
+        if (!m_shots.empty()) {
+            buildBins();
+            for (const Shot& shot : m_shots) {
+                Strike s;
+                if (!s.ray.start(shot.r, shot.c, shot.dr, shot.dc)) continue;
+                s.r = shot.r; s.c = shot.c;
+                s.t = 0.f;
+                s.teams = friendlyFire ? Simulation::SpatialHash::ANY
+                                       : Simulation::SpatialHash::enemiesOf(shot.team);
+                // A projectile would reach the unit in tick ceil(t / speed),
+                // counting this one as the first.
+                if (walkShot(s, props, smap, false))
+                    m_strikes.schedule((uint32_t)(strikeTicks(s.t) - 1), s);
+            }
+            m_shots.clear();
+        }
 
-            applyBulletHitUnits(b);
+        m_strikes.advance([&](const Strike& due) {
+            Strike s = due;
+            const int landed = strikeTicks(s.t);
+            while (!s.unit->isAlive) {
+                buildBins();
+                if (!walkShot(s, props, smap, true)) return;
+                const int later = strikeTicks(s.t) - landed;
+                if (later > 0) { m_strikes.schedule((uint32_t)later, s); return; }
+            }
+            s.unit->stats.hp -= Definitions::DAMAGE_BULLET;
+            if (s.unit->stats.hp <= 0) { s.unit->stats.hp = 0; s.unit->kill(); }
+        });
+    }
 
+    bool System::walkShot(Strike& s, const uint8_t* props, Simulation::SecurityMap& smap, bool retest) {
+        const float hit2 = bulletHitRadiusCells * bulletHitRadiusCells;
+        const float never = std::numeric_limits<float>::infinity();
+        for (bool first = true; ; first = false) {
+            int p;
+            if (first && retest) {
+                p = Models::Grid::padIndex(s.ray.row, s.ray.col);
+            }
+            else {
+                p = s.ray.enterNext(never, props, &s.t);
+                if (p == GridRay::STOPPED) return false;
+                smap.add(s.ray.row, s.ray.col, secmIncrement);
+            }
+            if (!m_binned) continue;
+            Models::Unit* u = m_bins.firstOnLine(s.teams, p, s.r, s.c, s.ray.dr, s.ray.dc, hit2);
+            if (!u) continue;
+            s.unit = u;
+            return true;
         }
+    }
 
-        bullets.erase(std::remove_if(bullets.begin(), bullets.end(),
-            [](const Bullet& x) { return !x.alive; }),
-            bullets.end());
+    void System::tickBullets(const Models::Grid& grid, Simulation::SecurityMap& smap) {
+        SIM_PROFILE_ZONE(TickBullets);
+        if (hitscan) resolveShots(grid, smap);
+        else advanceBullets(grid, smap, 1);
 
         for (auto& g : grenades) {
             if (!g.alive) continue;
@@ -152,8 +210,7 @@ namespace Combat {
 
         int rr = (int)std::floor(nr);
         int cc = (int)std::floor(nc);
-        int cell = grid.at(rr, cc);
-        if (blocksShot(cell) && nz <= 0.25f) {
+        if (grid.blocksShot(rr, cc) && nz <= 0.25f) {
             g.alive = false; return true; 
         }
 
@@ -167,138 +224,55 @@ namespace Combat {
         return false;
     }
 
-    void System::applyBulletHitUnits(Bullet& b) {
-        if (!b.alive) return;
-        if (!units || units->empty()) return;
-
-        const float br = b.r + 0.5f;
-        const float bc = b.c + 0.5f;
+    void System::sweepBullet(int slot, int steps, const uint8_t* props, float t)
+    {
+        const int s0 = projectiles.steps(slot);
+        const float tEnd = float(s0 + steps) * bulletSpeed;
         const float hit2 = bulletHitRadiusCells * bulletHitRadiusCells;
-
-        for (auto* u : *units) {
-            if (!u->isAlive) continue;
-            if (!friendlyFire && u->team == b.team) continue;
-
-            const float ur = u->row + 0.5f;
-            const float uc = u->col + 0.5f;
-            if (dist2(br, bc, ur, uc) <= hit2) {
-                u->stats.hp -= Definitions::DAMAGE_BULLET;
-                if (u->stats.hp <= 0) { u->stats.hp = 0; u->isAlive = false; }
-                b.alive = false;
-                return;
+        const uint8_t teams = friendlyFire ? Simulation::SpatialHash::ANY
+                                           : Simulation::SpatialHash::enemiesOf(projectiles.team(slot));
+        for (bool first = true; ; first = false) {
+            int p;
+            if (first) {
+                p = projectiles.cell(slot);
+            }
+            else {
+                p = projectiles.enterNext(slot, tEnd, props, &t);
+                if (p == ProjectilePool::NOT_YET) return;
+                if (p == ProjectilePool::STOPPED) { m_keep[slot] = 0; return; }
+                m_deposits.push_back(p);
             }
+            if (!m_binned) continue;
+
+            Models::Unit* u = m_bins.firstOnLine(teams, p,
+                projectiles.originR(slot), projectiles.originC(slot),
+                projectiles.dirR(slot), projectiles.dirC(slot), hit2);
+            if (!u) continue;
+
+            // The first tick whose end distance reaches the cell entry.
+            int k = std::max(s0 + 1, std::min(s0 + steps, (int)std::ceil(t / bulletSpeed)));
+            while (k > s0 + 1 && float(k - 1) * bulletSpeed >= t) --k;
+            while (float(k) * bulletSpeed < t) ++k;
+            m_pending.push_back({ k, slot, t, u });
+            std::push_heap(m_pending.begin(), m_pending.end(), laterHit);
+            return;
         }
     }
 
     void System::applyGrenadeAoE(const Models::Grid& grid,
         float r0, float c0,
         Definitions::Team shooterTeam) {
-        if (!units || units->empty()) return;
-
-        const float R = grenadeRadiusCells;
-        const float R2 = R * R;
-
-        const float cx = r0 + 0.5f;
-        const float cy = c0 + 0.5f;
-        const int   cr = int(std::floor(r0));
-        const int   cc = int(std::floor(c0));
-
-        for (auto* u : *units) {
-            if (!u->isAlive) continue;
-            if (!friendlyFire && u->team == shooterTeam) continue;
-
-            const float ur = u->row + 0.5f, uc = u->col + 0.5f;
-            float d2 = dist2(cx, cy, ur, uc);
-            if (d2 > R2) continue;
-
-            float d = std::sqrt(d2);
-            float t = clampf(1.0f - (d / R), 0.f, 1.f);
-            float dmgf = float(grenadeDmgEdge) +
-                (float(grenadeDmgCenter) - float(grenadeDmgEdge)) * t;
-
-            if (grenadeRaycastCover) {
-                int tr = int(std::floor(ur));
-                int tc = int(std::floor(uc));
-                if (raycastBlocked(grid, cr, cc, tr, tc)) {
-                    dmgf *= grenadeCoverBlockFactor;
-                }
-            }
-
-            int dmg = int(std::round(dmgf));
-            if (dmg <= 0) continue;
-
-            u->stats.hp -= dmg;
-            if (u->stats.hp <= 0) { u->stats.hp = 0; u->isAlive = false; }
-        }
-    }
-
-    void System::draw() const {
-        glPushAttrib(GL_ENABLE_BIT | GL_POINT_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_LINE_BIT);
-        glDisable(GL_TEXTURE_2D);
-        glDisable(GL_DEPTH_TEST);
-
-        glMatrixMode(GL_PROJECTION);
-        glPushMatrix();
-        glLoadIdentity();
-        gluOrtho2D(0.0, GRID_SIZE * 1.0, 0.0, GRID_SIZE * 1.0);
-
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glLoadIdentity();
-
-        glPointSize(6.f);
-        glBegin(GL_POINTS);
-        for (const auto& b : bullets) {
-            if (!b.alive) continue;
-
-            glColor3f(b.colR, b.colG, b.colB);
-
-            float x = b.c + 0.5f;
-            float y = b.r + 0.5f;
-            glVertex2f(x, y);
-        }
-        glEnd();
-
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-        for (const auto& g : grenades) {
-            if (!g.alive) continue;
-
-            float sx = g.c;
-            float sy = g.r;
-            float srad = 0.20f; 
-            glColor4f(0.f, 0.f, 0.f, 0.35f); 
-            glBegin(GL_TRIANGLE_FAN);
-            glVertex2f(sx, sy);
-            for (int i = 0; i <= 16; ++i) {
-                float a = (2.f * PI) * (i / 16.f);
-                glVertex2f(sx + srad * std::cos(a), sy + srad * std::sin(a));
-            }
-            glEnd();
-
-            float gx = g.c;
-            float gy = g.r + std::min(0.4f, g.z * 0.35f); 
-            float grad = 0.15f;
-
-            glColor3f(g.colR, g.colG, g.colB);
-
-            glBegin(GL_TRIANGLE_FAN);
-            glVertex2f(gx, gy);
-            for (int i = 0; i <= 16; ++i) {
-                float a = (2.f * PI) * (i / 16.f);
-                glVertex2f(gx + grad * std::cos(a), gy + grad * std::sin(a));
-            }
-            glEnd();
-        }
-
-        glDisable(GL_BLEND); 
-
-        glPopMatrix();             
-        glMatrixMode(GL_PROJECTION);
-        glPopMatrix();               
-        glMatrixMode(GL_MODELVIEW);
-        glPopAttrib();
+        if (!proximity || proximity->size() == 0) return;
+
+        Explosions::Params blast;
+        blast.radius = grenadeRadiusCells;
+        blast.dmgCenter = grenadeDmgCenter;
+        blast.dmgEdge = grenadeDmgEdge;
+        blast.coverFactor = grenadeCoverBlockFactor;
+        blast.cover = grenadeRaycastCover;
+        const uint8_t teams = friendlyFire ? Simulation::SpatialHash::ANY
+                                           : Simulation::SpatialHash::enemiesOf(shooterTeam);
+        m_explosions.detonate(grid, *proximity, int(std::floor(r0)), int(std::floor(c0)), teams, blast);
     }
 
 } // namespace Combat
\ No newline at end of file
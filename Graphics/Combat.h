@@ -6,26 +6,14 @@
 #include "Grid.h"
 #include "SecurityMap.h"
 #include "Units.h"
+#include "SpatialHash.h"
+#include "ProjectilePool.h"
+#include "UnitBins.h"
+#include "TimingWheel.h"
+#include "Explosions.h"
 
 namespace Combat {
 
-    struct Bullet {
-        float r, c;
-        float dr, dc;
-        int   ttl;
-        bool  alive = true;
-
-        Definitions::Team team = Definitions::Team::Blue;
-
-        float colR = 0.f, colG = 0.f, colB = 0.f;
-        bool  isShrapnel = false;
-
-        Bullet(float r0, float c0, float dr_, float dc_, int ttl_)
-            : r(r0), c(c0), dr(dr_), dc(dc_), ttl(ttl_) {
-        }
-    };
-
-
     struct Grenade {
         float r = 0.f, c = 0.f, z = 0.f;
         float vr = 0.f, vc = 0.f, vz = 0.f;
@@ -37,12 +25,11 @@ namespace Combat {
 
     struct System {
         float bulletSpeed = 0.55f;       
-        int   bulletTTL = 140;          
         int   grenadeRays = 8;        
         float secmIncrement = 0.0015f;  
 
         int   bulletDamage = 25;
-        float bulletHitRadiusCells = 0.35f;
+        float bulletHitRadiusCells = 0.35f;  // under half a cell: hits are found per cell entered
 
         float grenadeRadiusCells = 2.5f;
         int   grenadeDmgCenter = 50;
@@ -56,10 +43,30 @@ namespace Combat {
         int   throwMinFrames = 10;       
         int   throwMaxFrames = 90;       
 
-        std::vector<Bullet>  bullets;
+        // Hitscan: bullets and shrapnel are resolved along their whole ray
+        // instead of flying as projectiles. Nothing is drawn in flight.
+        bool  hitscan = DefaultHitscan();
+
+        // Mode for systems created afterwards (the headless runner turns
+        // hitscan on).
+        //
+        // Shots fired during a frame are walked in the next tickBullets,
+        // the same call that gives a projectile fired then its first move,
+        // so both modes see the units where they stand at that point. The
+        // unit hit takes its damage after the travel time at bulletSpeed.
+        // If it has died by then, the shot walks on from where it hit to
+        // the next unit on its line, as a projectile would. The modes can
+        // still differ: a target that moves off the line before the damage
+        // lands is hit anyway.
+        static void SetDefaultHitscan(bool on);
+        static bool DefaultHitscan();
+
+        ProjectilePool       projectiles;
         std::vector<Grenade> grenades;   
 
-        void bindUnits(std::vector<Models::Unit*>* unitsRef) { units = unitsRef; }
+        // Hits are looked up in the world's unit index.
+        void bindUnits(const Simulation::SpatialHash* index) { proximity = index; }
+        void clear() { projectiles.clear(); grenades.clear(); m_shots.clear(); m_strikes.clear(); m_dropped = 0; }
         void fireBulletTowards(float r0, float c0, float rT, float cT,
             Definitions::Team shooterTeam = Definitions::Team::Blue);
 
@@ -72,13 +79,64 @@ namespace Combat {
 
         void tickBullets(const Models::Grid& grid, Simulation::SecurityMap& smap);
 
+        // Flies every projectile `steps` ticks in one sweep. With the units
+        // standing still, the outcome (hits, deposits, survivors) is the
+        // same as `steps` calls with one.
+        void advanceBullets(const Models::Grid& grid, Simulation::SecurityMap& smap, int steps);
+
         void draw() const;
 
-        size_t bulletsCount() const { return bullets.size(); }
+        // Projectiles in flight, or in hitscan mode shots not yet resolved
+        // plus hits not yet landed.
+        size_t bulletsCount() const { return (size_t)projectiles.size() + m_shots.size() + m_strikes.size(); }
+
+        // Bullets and shrapnel never spawned because the pool was full.
+        uint64_t droppedShots() const { return m_dropped; }
 
     private:
         void explode(float r0, float c0, Definitions::Team shooterTeam);
-        void applyBulletHitUnits(Bullet& b);
+        // Spawns a projectile, or queues a hitscan shot.
+        void launch(float r, float c, float dr, float dc, Definitions::Team team, uint8_t flags);
+
+        struct Shot {
+            float r, c, dr, dc;
+            Definitions::Team team;
+        };
+        // A hitscan hit in flight: the unit, and the ray stopped in the
+        // cell where it was found, to walk on if that unit dies first.
+        struct Strike {
+            Models::Unit* unit;
+            GridRay ray;
+            float r, c;         // ray origin
+            float t;            // distance along the ray to the hit cell
+            uint8_t teams;
+        };
+        // Walks every queued shot's ray to its first blocking cell or unit,
+        // then lands the hits due this tick.
+        void resolveShots(const Models::Grid& grid, Simulation::SecurityMap& smap);
+        // Walks `s` on to the next unit on its line, depositing risk in each
+        // cell it enters; `retest` checks the current cell again first.
+        // False if the ray stops before it finds one.
+        bool walkShot(Strike& s, const uint8_t* props, Simulation::SecurityMap& smap, bool retest);
+        int  strikeTicks(float t) const { return std::max(1, (int)std::ceil(t / bulletSpeed)); }
+
+        // A unit a projectile reaches, and the tick it gets there in.
+        struct PendingHit {
+            int tick;
+            int slot;
+            float tEntry;
+            Models::Unit* unit;
+        };
+        // Heap order for m_pending: the earliest tick, then the lowest slot, on top.
+        static bool laterHit(const PendingHit& a, const PendingHit& b) {
+            return a.tick > b.tick || (a.tick == b.tick && a.slot > b.slot);
+        }
+
+        // Walks projectile `slot` on towards the end of the sweep from the
+        // cell it entered at distance `t`, testing that cell first, and
+        // queues a risk deposit for each cell it enters after it, until it
+        // stops, runs out of time or reaches a unit (queued in m_pending).
+        void sweepBullet(int slot, int steps, const uint8_t* props, float t);
 
         void applyGrenadeAoE(const Models::Grid& grid,
             float r0, float c0,
@@ -86,7 +144,19 @@ namespace Combat {
 
         bool stepGrenade(Grenade& g, const Models::Grid& grid);
 
-        std::vector<Models::Unit*>* units = nullptr;
+        const Simulation::SpatialHash* proximity = nullptr;
+        UnitBins m_bins;                        // per-tick broadphase for bullet hits
+        bool m_binned = false;
+        std::vector<PendingHit> m_pending;
+        std::vector<int32_t> m_deposits;        // cells swept this call, added to the smap at the end
+        std::vector<Shot> m_shots;
+        TimingWheel<Strike> m_strikes;          // hitscan damage still travelling
+        Explosions m_explosions;
+        uint64_t m_dropped = 0;
+        std::vector<int32_t> m_crossing = std::vector<int32_t>(ProjectilePool::CAPACITY);
+        std::vector<int32_t> m_entered = std::vector<int32_t>(ProjectilePool::CAPACITY);
+        std::vector<float>   m_tEntry = std::vector<float>(ProjectilePool::CAPACITY);
+        std::vector<uint8_t> m_keep = std::vector<uint8_t>(ProjectilePool::CAPACITY);
     };
 
 } // namespace Combat
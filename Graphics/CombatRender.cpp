@@ -0,0 +1,79 @@
+#include "Combat.h"
+#include "glut.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace Definitions;
+
+namespace Combat {
+
+    void System::draw() const {
+        glPushAttrib(GL_ENABLE_BIT | GL_POINT_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_LINE_BIT);
+        glDisable(GL_TEXTURE_2D);
+        glDisable(GL_DEPTH_TEST);
+
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        gluOrtho2D(0.0, GRID_SIZE * 1.0, 0.0, GRID_SIZE * 1.0);
+
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glPointSize(6.f);
+        glBegin(GL_POINTS);
+        for (int i = 0; i < projectiles.size(); ++i) {
+            // Shrapnel red, rifle rounds black.
+            if (projectiles.isShrapnel(i)) glColor3f(1.f, 0.f, 0.f);
+            else                           glColor3f(0.f, 0.f, 0.f);
+
+            float x = projectiles.c(i);
+            float y = projectiles.r(i);
+            glVertex2f(x, y);
+        }
+        glEnd();
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        for (const auto& g : grenades) {
+            if (!g.alive) continue;
+
+            float sx = g.c;
+            float sy = g.r;
+            float srad = 0.20f; 
+            glColor4f(0.f, 0.f, 0.f, 0.35f); 
+            glBegin(GL_TRIANGLE_FAN);
+            glVertex2f(sx, sy);
+            for (int i = 0; i <= 16; ++i) {
+                float a = (2.f * PI) * (i / 16.f);
+                glVertex2f(sx + srad * std::cos(a), sy + srad * std::sin(a));
+            }
+            glEnd();
+
+            float gx = g.c;
+            float gy = g.r + std::min(0.4f, g.z * 0.35f); 
+            float grad = 0.15f;
+
+            glColor3f(g.colR, g.colG, g.colB);
+
+            glBegin(GL_TRIANGLE_FAN);
+            glVertex2f(gx, gy);
+            for (int i = 0; i <= 16; ++i) {
+                float a = (2.f * PI) * (i / 16.f);
+                glVertex2f(gx + grad * std::cos(a), gy + grad * std::sin(a));
+            }
+            glEnd();
+        }
+
+        glDisable(GL_BLEND); 
+
+        glPopMatrix();             
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();               
+        glMatrixMode(GL_MODELVIEW);
+        glPopAttrib();
+    }
+
+} // namespace Combat
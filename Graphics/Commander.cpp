@@ -20,10 +20,12 @@
 #include "State_Healing.h"
 #include "State_Supplying.h"
 #include "State_RefillAtDepot.h"
-#include "Globals.h"
+#include "World.h"
 #include "Visibility.h"
 #include "Pathfinding.h"
 #include "Definitions.h"
+#include "Log.h"
+#include "Profiler.h"
 
 using namespace AI;
 using Definitions::Team;
@@ -31,18 +33,8 @@ using Definitions::Role;
 
 static constexpr int ENEMY_TTL_FRAMES = 360;
 static constexpr int MERGE_DIST2 = 2 * 2;
-static int s_frameCounter = 0;
 static constexpr int SUPPORT_LOCK_FRAMES = 480; 
 
-static bool s_announcedCommanderDownBlue = false;
-static bool s_announcedCommanderDownOrange = false;
-
-static inline Models::Unit* findUnitById(int uid) {
-    if (uid <= 0) return nullptr;
-    auto it = std::find_if(g_units.begin(), g_units.end(),
-        [uid](const Models::Unit* u) { return u->id == uid; });
-    return (it != g_units.end()) ? (*it) : nullptr;
-}
 
 static inline bool isOurHalf(int , int c, int gridSize, Team team) {
     return (team == Team::Blue) ? (c < gridSize / 2) : (c >= gridSize / 2);
@@ -61,11 +53,11 @@ static inline bool isPoisonPtr(const void* p) {
 #endif
 }
 
-static inline bool isPointerIntoGUnits(const Models::Unit* p) {
+static inline bool isPointerIntoUnits(const std::vector<Models::Unit*>& units, const Models::Unit* p) {
     if (!p) return false;
-    if (g_units.empty()) return false;
-    auto it = std::find(g_units.begin(), g_units.end(), p);
-    return (it != g_units.end());
+    if (units.empty()) return false;
+    auto it = std::find(units.begin(), units.end(), p);
+    return (it != units.end());
 }
 
 static inline char roleChar(const Models::Unit* u) {
@@ -113,16 +105,31 @@ static inline void maybeExpireLock(Models::Unit* u, int nowFrame) {
     }
 }
 
+void Commander::reset() {
+    unitId = -1;
+    anchorR = anchorC = -1;
+    lastReanchorFrame = -REANCHOR_COOLDOWN_FRAMES;
+    m_frameCounter = 0;
+    m_announcedDown = false;
+    knownEnemies.clear();
+    lowAmmoUnits.clear();
+    injuredUnits.clear();
+    underFireUnits.clear();
+    m_teamVis.clear();
+    m_teamVisFrame = -1;
+    m_lastOrders.clear();
+}
+
 void Commander::initSubscriptions() {
-    EventBus::instance().subscribe(-1, [this](const Message& m) { onMessage(m); });
+    m_world->bus.subscribe(-1, [this](const Message& m) { onMessage(m); });
     if (unitId > 0) {
-        EventBus::instance().subscribe(unitId, [this](const Message& m) { onMessage(m); });
+        m_world->bus.subscribe(unitId, [this](const Message& m) { onMessage(m); });
     }
 }
 
 void Commander::onMessage(const Message& m) {
     if (m.fromUnitId > 0) {
-        if (auto* src = findUnitById(m.fromUnitId)) {
+        if (auto* src = m_world->findUnit(m.fromUnitId)) {
             if (src->team != myTeam) return;
         }
         else {
@@ -137,14 +144,14 @@ void Commander::onMessage(const Message& m) {
             int d2 = dr * dr + dc * dc;
             if (d2 <= MERGE_DIST2) {
                 s.row = m.row; s.col = m.col;
-                s.lastSeenFrame = s_frameCounter;
+                s.lastSeenFrame = m_frameCounter;
                 merged = true;
                 break;
             }
         }
         if (!merged) {
-            knownEnemies.push_back({ m.row, m.col, s_frameCounter });
-            std::printf("[CMD/%s] New EnemySighted at (%d,%d)\n", teamTag(myTeam), m.row, m.col);
+            knownEnemies.push_back({ m.row, m.col, m_frameCounter });
+            SIM_LOG("[CMD/%s] New EnemySighted at (%d,%d)\n", teamTag(myTeam), m.row, m.col);
         }
         return;
     }
@@ -152,7 +159,7 @@ void Commander::onMessage(const Message& m) {
     if (m.type == EventType::UnderFire) {
         if (std::find(underFireUnits.begin(), underFireUnits.end(), m.fromUnitId) == underFireUnits.end()) {
             underFireUnits.push_back(m.fromUnitId);
-            std::printf("[CMD/%s] Unit %d reports UNDER FIRE.\n", teamTag(myTeam), m.fromUnitId);
+            SIM_LOG("[CMD/%s] Unit %d reports UNDER FIRE.\n", teamTag(myTeam), m.fromUnitId);
         }
         return;
     }
@@ -160,7 +167,7 @@ void Commander::onMessage(const Message& m) {
     if (m.type == EventType::LowAmmo) {
         if (std::find(lowAmmoUnits.begin(), lowAmmoUnits.end(), m.fromUnitId) == lowAmmoUnits.end()) {
             lowAmmoUnits.push_back(m.fromUnitId);
-            std::printf("[CMD/%s] Unit %d reports LOW AMMO.\n", teamTag(myTeam), m.fromUnitId);
+            SIM_LOG("[CMD/%s] Unit %d reports LOW AMMO.\n", teamTag(myTeam), m.fromUnitId);
         }
         return;
     }
@@ -168,7 +175,7 @@ void Commander::onMessage(const Message& m) {
     if (m.type == EventType::Injured) {
         if (std::find(injuredUnits.begin(), injuredUnits.end(), m.fromUnitId) == injuredUnits.end()) {
             injuredUnits.push_back(m.fromUnitId);
-            std::printf("[CMD/%s] Unit %d reports INJURED (HP: %d).\n", teamTag(myTeam), m.fromUnitId, m.extra);
+            SIM_LOG("[CMD/%s] Unit %d reports INJURED (HP: %d).\n", teamTag(myTeam), m.fromUnitId, m.extra);
         }
         return;
     }
@@ -197,27 +204,27 @@ void Commander::rememberIssued(const Models::Unit* u, const Order& o, int frameC
 void Commander::issueOrder(Models::Unit* u, const Order& o, int frameCounter) {
     if (!u || !u->isAlive) return;
 
-    if (!isPointerIntoGUnits(u) || !isSaneUnit(u)) {
-        std::printf("[CMD/%s] SKIP order to UnitPtr=%p: invalid/suspect unit.\n",
+    if (!isPointerIntoUnits(m_world->units, u) || !isSaneUnit(u)) {
+        SIM_LOG("[CMD/%s] SKIP order to UnitPtr=%p: invalid/suspect unit.\n",
             teamTag(myTeam), reinterpret_cast<void*>(u));
         return;
     }
 
     auto* fsm = u->m_fsm;
     if (!fsm || isPoisonPtr(fsm)) {
-        std::printf("[CMD/%s] SKIP order to Unit#%d: FSM invalid.\n", teamTag(myTeam), u->id);
+        SIM_LOG("[CMD/%s] SKIP order to Unit#%d: FSM invalid.\n", teamTag(myTeam), u->id);
         return;
     }
 
     if (u->team != myTeam) {
-        std::printf("[CMD/%s] ERROR: Tried to issue order to enemy Unit#%d!\n", teamTag(myTeam), u->id);
+        SIM_LOG("[CMD/%s] ERROR: Tried to issue order to enemy Unit#%d!\n", teamTag(myTeam), u->id);
         return;
     }
 
     AI::State* currentState = fsm->GetCurrentState();
     if (currentState && !isPoisonPtr(currentState) && !currentState->CanReport()) {
         if (o.type == OrderType::AttackTo || o.type == OrderType::DefendAt || o.type == OrderType::MoveTo) {
-            std::printf("[CMD/%s] SKIP order %d for Unit#%d, unit is busy (cannot report).\n",
+            SIM_LOG("[CMD/%s] SKIP order %d for Unit#%d, unit is busy (cannot report).\n",
                 teamTag(myTeam), (int)o.type, u->id);
             return;
         }
@@ -229,17 +236,16 @@ void Commander::issueOrder(Models::Unit* u, const Order& o, int frameCounter) {
     const char roleCh = roleChar(u);
     const int tr = o.row, tc = o.col, tu = o.targetUnitId, ot = (int)o.type;
 
-    std::printf("[CMD/%s] -> Unit#%d (%c) Order=%d Target=(%d,%d) TargetUnit=%d\n",
+    SIM_LOG("[CMD/%s] -> Unit#%d (%c) Order=%d Target=(%d,%d) TargetUnit=%d\n",
         teamTag(myTeam), uid, roleCh, ot, tr, tc, tu);
 
-    EventBus::instance().publish(Message{
+    m_world->bus.publish(Message{
         EventType::OrderIssued, -1, uid, tr, tc, ot
         });
 
-    extern Combat::System g_combat;
     switch (o.type) {
     case OrderType::AttackTo:
-        fsm->ChangeState(new State_Attacking(tr, tc, &g_combat));
+        fsm->ChangeState(new State_Attacking(tr, tc, &m_world->combat));
         break;
     case OrderType::DefendAt:
         fsm->ChangeState(new State_Defending(tr, tc));
@@ -255,45 +261,29 @@ void Commander::issueOrder(Models::Unit* u, const Order& o, int frameCounter) {
     rememberIssued(u, o, frameCounter);
 }
 
-bool Commander::pickLiveVisibleTarget(const std::vector<Models::Unit*>& enemies,
-    int& outR, int& outC) const
+const AI::VisMask& Commander::teamVisibility() const
+{
+    if (m_teamVisFrame != m_frameCounter) {
+        AI::Visibility::BuildTeamVisibility(m_world->grid, m_world->units, myTeam,
+            Definitions::SIGHT_RANGE, m_teamVis, AI::Visibility::Mode::Shadowcast);
+        m_teamVisFrame = m_frameCounter;
+    }
+    return m_teamVis;
+}
+
+bool Commander::pickLiveVisibleTarget(int& outR, int& outC) const
 {
     outR = -1; outC = -1;
-    Models::Unit* self = findUnitById(this->unitId);
+    Models::Unit* self = m_world->findUnit(this->unitId);
     if (!self || !self->isAlive) return false;
-
-    float bestScore = std::numeric_limits<float>::infinity();
-
-    for (const auto* enemy : enemies) {
-        if (!enemy || !enemy->isAlive) continue;
-        if (AI::Visibility::HasLineOfSight(g_grid, self->row, self->col, enemy->row, enemy->col)) {
-            int dr = enemy->row - self->row;
-            int dc = enemy->col - self->col;
-            float distSq = float(dr * dr + dc * dc);
-
-            float score = distSq;
-
-            int enemyCell = g_grid.at(enemy->row, enemy->col);
-            if (enemyCell == Definitions::Cell::TREE) {
-                score *= Definitions::TREE_COVER_PENALTY_MULTIPLIER;
-            }
-
-            if (score < bestScore) {
-                bestScore = score;
-                outR = enemy->row;
-                outC = enemy->col;
-            }
-        }
-    }
-    return (outR != -1 && outC != -1);
+    return m_world->perception.bestVisibleEnemy(*self, outR, outC, AI::Perception::Pick::PreferOpen);
 }
 
-void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs,
-    std::vector<Models::Unit*>& enemies,
-    int frameCounter)
+void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs, int frameCounter)
 {
+    SIM_PROFILE_ZONE(DecideOrders);
     int targetR = -1, targetC = -1;
-    if (!pickLiveVisibleTarget(enemies, targetR, targetC)) {
+    if (!pickLiveVisibleTarget(targetR, targetC)) {
         if (!knownEnemies.empty()) {
             int mostRecent = -1;
             for (const auto& e : knownEnemies) {
@@ -308,8 +298,8 @@ void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs,
     std::unordered_set<int> reservedIds;
 
     auto removeInvalid = [&](std::vector<int>& list) {
-        list.erase(std::remove_if(list.begin(), list.end(), [](int id) {
-            Models::Unit* u = findUnitById(id);
+        list.erase(std::remove_if(list.begin(), list.end(), [this](int id) {
+            Models::Unit* u = m_world->findUnit(id);
             return !u || !u->isAlive;
             }), list.end());
         };
@@ -322,7 +312,7 @@ void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs,
         auto it = std::find(underFireUnits.begin(), underFireUnits.end(), uid);
         if (it == underFireUnits.end()) continue;
 
-        Models::Unit* u = findUnitById(uid);
+        Models::Unit* u = m_world->findUnit(uid);
         if (u && isInterruptible(u) && reservedIds.find(u->id) == reservedIds.end()) {
             issueOrder(u, Order{ OrderType::DefendAt, u->row, u->col }, frameCounter);
             reservedIds.insert(u->id);
@@ -344,7 +334,7 @@ void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs,
         auto injIt = std::find(injuredUnits.begin(), injuredUnits.end(), injId);
         if (injIt == injuredUnits.end()) continue;
 
-        Models::Unit* inj = findUnitById(injId);
+        Models::Unit* inj = m_world->findUnit(injId);
         if (inj && inj->isAlive) {
 
             Models::Unit* medic = nullptr;
@@ -361,12 +351,12 @@ void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs,
 
             if (medic->roleData.currentHealPool < Definitions::MEDIC_REFILL_THRESHOLD) {
                 medic->m_fsm->ChangeState(new State_RefillAtDepot(Role::Medic, injId));
-                std::printf("[CMD/%s] -> Unit#%d (M) REFILL then heal Unit#%d (handled inside state)\n",
+                SIM_LOG("[CMD/%s] -> Unit#%d (M) REFILL then heal Unit#%d (handled inside state)\n",
                     teamTag(myTeam), medic->id, injId);
             }
             else {
                 medic->m_fsm->ChangeState(new State_Healing(injId));
-                std::printf("[CMD/%s] -> Unit#%d (M) HEAL Unit#%d\n",
+                SIM_LOG("[CMD/%s] -> Unit#%d (M) HEAL Unit#%d\n",
                     teamTag(myTeam), medic->id, injId);
             }
 
@@ -388,7 +378,7 @@ void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs,
         auto needyIt = std::find(lowAmmoUnits.begin(), lowAmmoUnits.end(), needyId);
         if (needyIt == lowAmmoUnits.end()) continue;
 
-        Models::Unit* needy = findUnitById(needyId);
+        Models::Unit* needy = m_world->findUnit(needyId);
         if (needy && needy->isAlive) {
 
             Models::Unit* supplier = nullptr;
@@ -405,12 +395,12 @@ void Commander::decideAndIssueOrders(std::vector<Models::Unit*>& myTeamPtrs,
 
             if (supplier->roleData.currentAmmo < Definitions::SUPPLIER_REFILL_THRESHOLD) {
                 supplier->m_fsm->ChangeState(new State_RefillAtDepot(Role::Supplier, needyId));
-                std::printf("[CMD/%s] -> Unit#%d (P) REFILL then resupply Unit#%d (handled inside state)\n",
+                SIM_LOG("[CMD/%s] -> Unit#%d (P) REFILL then resupply Unit#%d (handled inside state)\n",
                     teamTag(myTeam), supplier->id, needyId);
             }
             else {
                 supplier->m_fsm->ChangeState(new State_Supplying(needyId));
-                std::printf("[CMD/%s] -> Unit#%d (P) SUPPLY Unit#%d\n",
+                SIM_LOG("[CMD/%s] -> Unit#%d (P) SUPPLY Unit#%d\n",
                     teamTag(myTeam), supplier->id, needyId);
             }
 
@@ -459,16 +449,16 @@ void Commander::tick(Models::Grid& map,
     std::vector<Models::Unit*>& enemyPtrs,
     int frameCounter)
 {
-    s_frameCounter = frameCounter;
+    SIM_PROFILE_ZONE(CommanderTick);
+    m_frameCounter = frameCounter;
 
-    Models::Unit* self = findUnitById(this->unitId);
+    Models::Unit* self = m_world->findUnit(this->unitId);
 
     if (!self || !self->isAlive) {
-        bool& announced = (myTeam == Team::Blue) ? s_announcedCommanderDownBlue : s_announcedCommanderDownOrange;
-        if (!announced) {
-            EventBus::instance().publish(Message{ EventType::CommanderDown, /*from*/ unitId, /*to*/ -1 });
-            std::printf("[CMD/%s] Commander is DOWN  switching units to autonomy.\n", teamTag(myTeam));
-            announced = true;
+        if (!m_announcedDown) {
+            m_world->bus.publish(Message{ EventType::CommanderDown, /*from*/ unitId, /*to*/ -1 });
+            SIM_LOG("[CMD/%s] Commander is DOWN  switching units to autonomy.\n", teamTag(myTeam));
+            m_announcedDown = true;
         }
         return;
     }
@@ -495,18 +485,11 @@ void Commander::tick(Models::Grid& map,
         {
             const float PROXIMITY_THREAT_RADIUS_SQ = 15.0f * 15.0f;
             const float PROXIMITY_WEIGHT = 1.0f;
-            const float SMAP_NORMALIZATION = std::max(0.001f, g_smap.maxValue());
-
-            float smapRisk = g_smap.at(r, c) / SMAP_NORMALIZATION;
+            float smapRisk = m_world->smap.normAt(r, c);
             float proxRisk = 0.0f;
             float minEnemyDistSq = std::numeric_limits<float>::infinity();
-
-            for (const auto* en : enemyPtrs) {
-                if (!en || !en->isAlive) continue;
-                float dr = (float)en->row - r;
-                float dc = (float)en->col - c;
-                minEnemyDistSq = std::min(minEnemyDistSq, dr * dr + dc * dc);
-            }
+            m_world->proximity.nearest(Simulation::SpatialHash::enemiesOf(myTeam), r, c,
+                PROXIMITY_THREAT_RADIUS_SQ, &minEnemyDistSq);
 
             if (minEnemyDistSq <= PROXIMITY_THREAT_RADIUS_SQ) {
                 float dist = std::sqrt(minEnemyDistSq);
@@ -522,49 +505,22 @@ void Commander::tick(Models::Grid& map,
     }
 
     if (frameCounter % 30 == 0) {
-        decideAndIssueOrders(myTeamPtrs, enemyPtrs, frameCounter);
+        decideAndIssueOrders(myTeamPtrs, frameCounter);
     }
 }
 
 void Commander::FightAsWarrior() {
-    Models::Unit* self = findUnitById(this->unitId);
+    Models::Unit* self = m_world->findUnit(this->unitId);
     if (!self || !self->isAlive) return;
 
-    extern Combat::System g_combat;
     AI::StateMachine* fsm = self->m_fsm;
     if (!fsm || isPoisonPtr(fsm)) return;
 
     int vis_er = -1, vis_ec = -1;
-    float nearest_vis_d2 = std::numeric_limits<float>::infinity();
-    const int SIGHT_RANGE_SQ = Definitions::SIGHT_RANGE * Definitions::SIGHT_RANGE;
-
-    for (const auto* other : g_units) {
-        if (!other->isAlive || other->team == self->team) continue;
-        int dr = other->row - self->row;
-        int dc = other->col - self->col;
-        float d2 = float(dr * dr + dc * dc);
-        if (d2 > SIGHT_RANGE_SQ || d2 >= nearest_vis_d2) continue;
-
-        if (AI::Visibility::HasLineOfSight(g_grid, self->row, self->col, other->row, other->col)) {
-
-            float score = d2;
-            int enemyCell = g_grid.at(other->row, other->col);
-            if (enemyCell == Definitions::Cell::TREE) {
-                score *= Definitions::TREE_COVER_PENALTY_MULTIPLIER;
-            }
-
-            if (score < nearest_vis_d2) {
-                nearest_vis_d2 = score;
-                vis_er = other->row;
-                vis_ec = other->col;
-            }
-        }
-    }
-
-    if (vis_er != -1) {
+    if (m_world->perception.bestVisibleEnemy(*self, vis_er, vis_ec, AI::Perception::Pick::PreferOpen)) {
         AI::State* currentState = fsm->GetCurrentState();
         if (dynamic_cast<State_Attacking*>(currentState) == nullptr) {
-            fsm->ChangeState(new State_Attacking(vis_er, vis_ec, &g_combat));
+            fsm->ChangeState(new State_Attacking(vis_er, vis_ec, &m_world->combat));
         }
         return;
     }
@@ -572,14 +528,14 @@ void Commander::FightAsWarrior() {
     int nearest_er = -1, nearest_ec = -1;
     float nearest_d2 = std::numeric_limits<float>::infinity();
 
-    for (const auto* other : g_units) {
+    for (const auto* other : m_world->units) {
         if (!other->isAlive || other->team == self->team) continue;
         int dr = other->row - self->row;
         int dc = other->col - self->col;
 
         float d2 = float(dr * dr + dc * dc);
         float score = d2;
-        int enemyCell = g_grid.at(other->row, other->col);
+        int enemyCell = m_world->grid.at(other->row, other->col);
         if (enemyCell == Definitions::Cell::TREE) {
             score *= Definitions::TREE_COVER_PENALTY_MULTIPLIER;
         }
@@ -597,7 +553,7 @@ void Commander::FightAsWarrior() {
 
     if (nearest_er != -1) {
         AI::Pathfinding::Path path_check = AI::Pathfinding::AStar_FindPath(
-            self, g_grid, g_smap,
+            self, m_world->grid, m_world->smap,
             { self->row, self->col },
             { nearest_er, nearest_ec },
             AI::Pathfinding::RiskWeightForUnit(self)
@@ -606,7 +562,7 @@ void Commander::FightAsWarrior() {
 
         if (target_reachable) {
             if (isIdle) {
-                fsm->ChangeState(new State_Attacking(nearest_er, nearest_ec, &g_combat));
+                fsm->ChangeState(new State_Attacking(nearest_er, nearest_ec, &m_world->combat));
             }
         }
         else {
@@ -630,12 +586,22 @@ bool Commander::selectDefensiveAnchor(const Models::Grid& map,
     const int gridSize = Definitions::GRID_SIZE;
     int bestR = -1, bestC = -1; float bestRisk = std::numeric_limits<float>::infinity();
 
+    // Only anchors the commander can walk to (the main region without one).
+    const AI::Pathfinding::Connectivity& reach = m_world->connectivity;
+    const Models::Unit* self = m_world->findUnit(unitId);
+    const int region = self ? reach.label(self->row, self->col) : 0;
+    const int wanted = region != 0 ? region : reach.mainLabel();
+
     for (int k = 0; k < ANCHOR_RETRIES; ++k) {
-        int r = std::rand() % gridSize;
-        int c = std::rand() % gridSize;
+        int r = m_world->rng.ai.below(gridSize);
+        int c = m_world->rng.ai.below(gridSize);
         if (!AI::Pathfinding::inPlayfield(r, c)) continue;
         if (!isOurHalf(r, c, gridSize, myTeam)) continue;
-        if (!AI::Pathfinding::IsWalkableForMovement(map.at(r, c))) continue;
+        if (!map.walkable(r, c)) continue;
+        if (reach.label(r, c) != wanted) continue;
+        // Defenders sent here look for cover around the anchor; skip spots
+        // with no rock or tree in that range.
+        if (!m_world->cover.coverWithin(r, c, Definitions::DEFEND_COVER_RADIUS)) continue;
 
         float risk = riskAt(r, c);
         if (risk <= SAFE_RISK_MAX && risk < bestRisk) {
@@ -647,11 +613,12 @@ bool Commander::selectDefensiveAnchor(const Models::Grid& map,
     if (bestR < 0) {
         bestRisk = std::numeric_limits<float>::infinity();
         for (int k = 0; k < ANCHOR_RETRIES; ++k) {
-            int r = std::rand() % gridSize;
-            int c = std::rand() % gridSize;
+            int r = m_world->rng.ai.below(gridSize);
+            int c = m_world->rng.ai.below(gridSize);
             if (!AI::Pathfinding::inPlayfield(r, c)) continue;
             if (!isOurHalf(r, c, gridSize, myTeam)) continue;
-            if (!AI::Pathfinding::IsWalkableForMovement(map.at(r, c))) continue;
+            if (!map.walkable(r, c)) continue;
+            if (reach.label(r, c) != wanted) continue;
 
             float risk = riskAt(r, c);
             if (risk < bestRisk) {
@@ -662,7 +629,7 @@ bool Commander::selectDefensiveAnchor(const Models::Grid& map,
 
     if (bestR >= 0) {
         anchorR = bestR; anchorC = bestC;
-        std::printf("[CMD/%s] Selected new anchor at (%d,%d), Risk=%.3f\n",
+        SIM_LOG("[CMD/%s] Selected new anchor at (%d,%d), Risk=%.3f\n",
             teamTag(myTeam), anchorR, anchorC, bestRisk);
         return true;
     }
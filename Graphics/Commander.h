@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <functional>
+#include <cstdlib>
 #include <unordered_map>
 #include "Orders.h"
 #include "AIEvents.h"
@@ -11,6 +12,8 @@
 #include "Visibility.h"
 #include <limits>
 
+namespace Simulation { class World; }
+
 namespace AI {
 
     struct EnemyInfo {
@@ -20,12 +23,15 @@ namespace AI {
 
     class Commander {
     public:
-        explicit Commander(Definitions::Team team = Definitions::Team::Blue)
-            : myTeam(team) {
+        Commander(Simulation::World& world, Definitions::Team team)
+            : m_world(&world), myTeam(team) {
         }
 
         void initSubscriptions();
 
+        // Forgets everything learned in the previous match.
+        void reset();
+
         void tick(Models::Grid& map,
             std::vector<Models::Unit*>& myTeamPtrs,
             std::vector<Models::Unit*>& enemyPtrs,
@@ -55,29 +61,29 @@ namespace AI {
 
         inline Definitions::Team team() const { return myTeam; }
 
-        inline const AI::Visibility::BArray& teamVisibility() const { return m_teamVis; }
+        // Cells this team can see, built on the first read in a frame.
+        const AI::VisMask& teamVisibility() const;
 
     private:
+        Simulation::World* m_world;
         Definitions::Team myTeam; 
         int unitId = -1;        
+        int m_frameCounter = 0;
+        bool m_announcedDown = false;
 
         std::vector<EnemyInfo> knownEnemies; 
         std::vector<int> lowAmmoUnits;   
         std::vector<int> injuredUnits;   
         std::vector<int> underFireUnits; 
 
-        AI::Visibility::BArray m_teamVis{}; 
-        void rebuildTeamVisibility(const Models::Grid& map,
-            const std::vector<Models::Unit*>& units);
+        mutable AI::VisMask m_teamVis{}; 
+        mutable int m_teamVisFrame = -1;
 
         void onMessage(const AI::Message& m);
 
-        void decideAndIssueOrders(std::vector<Models::Unit*>& myTeam,
-            std::vector<Models::Unit*>& enemies,
-            int frameCounter);
+        void decideAndIssueOrders(std::vector<Models::Unit*>& myTeam, int frameCounter);
 
-        bool pickLiveVisibleTarget(const std::vector<Models::Unit*>& enemies,
-            int& outR, int& outC) const;
+        bool pickLiveVisibleTarget(int& outR, int& outC) const;
 
         struct CachedOrder {
             Order order{};          
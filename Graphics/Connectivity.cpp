@@ -0,0 +1,255 @@
+#include "Connectivity.h"
+#include <algorithm>
+#include "Pathfinding.h"
+
+namespace AI {
+    namespace Pathfinding {
+
+        static const int DR[4] = { -1, 0, +1, 0 };   // N, E, S, W
+        static const int DC[4] = { 0, +1, 0, -1 };
+
+        Connectivity::Connectivity()
+            : m_label(CELLS, 0)
+            , m_walkable(CELLS, 0)
+            , m_stamp(CELLS, 0)
+        {
+            m_queue.reserve(CELLS);
+        }
+
+        int Connectivity::newLabel() {
+            // Labels retired by merges and splits are not reused until the
+            // next full relabel compacts them.
+            m_size.push_back(0);
+            return (int)m_size.size() - 1;
+        }
+
+        int Connectivity::flood(int seed, int lbl, int only) {
+            ++m_pass;
+            int changed = 0;
+            m_queue.clear();
+            m_queue.push_back(seed);
+            m_stamp[seed] = m_pass;
+            for (size_t head = 0; head < m_queue.size(); ++head) {
+                const int i = m_queue[head];
+                const int old = m_label[i];
+                if (old != lbl) {
+                    if (old > 0) --m_size[old];
+                    ++m_size[lbl];
+                    m_label[i] = lbl;
+                    ++changed;
+                }
+                const int r = i / N, c = i % N;
+                for (int k = 0; k < 4; ++k) {
+                    const int nr = r + DR[k], nc = c + DC[k];
+                    if (nr < 0 || nr >= N || nc < 0 || nc >= N) continue;
+                    const int n = nr * N + nc;
+                    if (!m_walkable[n] || m_stamp[n] == m_pass) continue;
+                    if (only >= 0 && m_label[n] != only) continue;
+                    m_stamp[n] = m_pass;
+                    m_queue.push_back(n);
+                }
+            }
+            return changed;
+        }
+
+        void Connectivity::relabelAll(const Models::Grid& grid) {
+            for (int i = 0; i < CELLS; ++i) {
+                m_walkable[i] = grid.walkable(i / N, i % N) ? 1 : 0;
+                m_label[i] = 0;
+            }
+            m_size.assign(1, 0);
+            for (int i = 0; i < CELLS; ++i) {
+                if (!m_walkable[i] || m_label[i] != 0) continue;
+                flood(i, newLabel());
+            }
+            m_walkPlane = grid.plane(Models::Plane::Walkable);
+            m_built = true;
+        }
+
+        void Connectivity::open(int i) {
+            m_walkable[i] = 1;
+            const int r = i / N, c = i % N;
+            int labels[4];
+            int count = 0, target = 0;
+            for (int k = 0; k < 4; ++k) {
+                const int nr = r + DR[k], nc = c + DC[k];
+                const int l = label(nr, nc);
+                if (l == 0 || std::find(labels, labels + count, l) != labels + count) continue;
+                labels[count++] = l;
+                if (target == 0 || m_size[l] > m_size[target]) target = l;
+            }
+            if (target == 0) target = newLabel();
+            m_label[i] = target;
+            ++m_size[target];
+
+            for (int k = 0; k < count; ++k) {
+                if (labels[k] == target) continue;
+                for (int d = 0; d < 4; ++d) {
+                    const int nr = r + DR[d], nc = c + DC[d];
+                    if (label(nr, nc) != labels[k]) continue;
+                    m_relabelled += flood(nr * N + nc, target, labels[k]);
+                    break;
+                }
+            }
+        }
+
+        // True unless the walkable 4-neighbours of i are chained together
+        // through walkable corner cells of the surrounding 3x3 ring.
+        bool Connectivity::mayHaveSplit(int i) const {
+            const int r = i / N, c = i % N;
+            bool side[4];
+            int sides = 0;
+            for (int k = 0; k < 4; ++k) {
+                side[k] = label(r + DR[k], c + DC[k]) != 0;
+                if (side[k]) ++sides;
+            }
+            if (sides <= 1) return false;
+
+            // Corner between side k and side k+1 (N-E, E-S, S-W, W-N).
+            int groups = 0;
+            for (int k = 0; k < 4; ++k) {
+                if (!side[k]) continue;
+                const int prev = (k + 3) & 3;
+                const bool linkedToPrev = side[prev] &&
+                    label(r + DR[prev] + DR[k], c + DC[prev] + DC[k]) != 0;
+                if (!linkedToPrev) ++groups;
+            }
+            // A full ring of linked sides counts zero "starts".
+            return groups > 1;
+        }
+
+        void Connectivity::block(int i) {
+            const int old = m_label[i];
+            const bool split = mayHaveSplit(i);
+            m_walkable[i] = 0;
+            m_label[i] = 0;
+            if (old > 0) --m_size[old];
+            if (!split || old <= 0) return;
+
+            // Search outwards from every neighbour in lockstep, merging the
+            // searches that meet. As soon as a single search is still going,
+            // the others have enumerated pieces that were cut off; they get
+            // new labels and the open-ended piece keeps the old one. Cost is
+            // proportional to the smaller pieces, not the component.
+            const int r = i / N, c = i % N;
+            int seed[4], parent[4], head[4];
+            int pieces = 0;
+            const uint32_t base = m_pass + 1;
+            m_pass += 4;
+            for (int k = 0; k < 4; ++k) {
+                const int nr = r + DR[k], nc = c + DC[k];
+                if (label(nr, nc) != old) continue;
+                const int n = nr * N + nc;
+                seed[pieces] = n;
+                parent[pieces] = pieces;
+                head[pieces] = 0;
+                m_pieceQueue[pieces].clear();
+                m_pieceQueue[pieces].push_back(n);
+                m_stamp[n] = base + pieces;
+                ++pieces;
+            }
+            auto root = [&](int p) { while (parent[p] != p) p = parent[p]; return p; };
+            auto active = [&](int p) { return head[p] < (int)m_pieceQueue[p].size(); };
+
+            for (;;) {
+                // A group is still going while any of its searches is.
+                bool going[4] = { false, false, false, false };
+                int goingCount = 0;
+                for (int p = 0; p < pieces; ++p) {
+                    const int g = root(p);
+                    if (active(p) && !going[g]) { going[g] = true; ++goingCount; }
+                }
+                int groups = 0;
+                for (int p = 0; p < pieces; ++p) if (root(p) == p) ++groups;
+                if (groups == 1 || goingCount <= 1) break;
+
+                for (int p = 0; p < pieces; ++p) {
+                    if (!active(p)) continue;
+                    const int cell = m_pieceQueue[p][head[p]++];
+                    const int cr = cell / N, cc = cell % N;
+                    for (int k = 0; k < 4; ++k) {
+                        const int nr = cr + DR[k], nc = cc + DC[k];
+                        if (label(nr, nc) != old) continue;
+                        const int n = nr * N + nc;
+                        const uint32_t st = m_stamp[n];
+                        if (st >= base && st < base + 4) {
+                            const int a = root(p), b = root((int)(st - base));
+                            if (a != b) parent[b] = a;
+                            continue;
+                        }
+                        m_stamp[n] = base + p;
+                        m_pieceQueue[p].push_back(n);
+                    }
+                }
+            }
+
+            int groups = 0;
+            for (int p = 0; p < pieces; ++p) if (root(p) == p) ++groups;
+            if (groups <= 1) return;
+
+            // Relabel every finished group; if all finished, the last one
+            // keeps the old label.
+            int keep = -1;
+            for (int p = 0; p < pieces; ++p) {
+                if (root(p) != p) continue;
+                bool finished = true;
+                for (int q = 0; q < pieces; ++q) if (root(q) == p && active(q)) finished = false;
+                if (!finished) keep = p;
+            }
+            if (keep < 0) {
+                for (int p = pieces - 1; p >= 0; --p) if (root(p) == p) { keep = p; break; }
+            }
+            for (int p = 0; p < pieces; ++p) {
+                if (root(p) != p || p == keep) continue;
+                m_relabelled += flood(seed[p], newLabel(), old);
+            }
+        }
+
+        void Connectivity::sync(const Models::Grid& grid) {
+            if (m_built && grid.revision() == m_gridRevision) return;
+            m_gridRevision = grid.revision();
+
+            if (!m_built || (int)m_size.size() > 2 * CELLS) {
+                relabelAll(grid);
+                refreshMain();
+                return;
+            }
+
+            // Diff the walkable bitplane a word at a time; only words that
+            // differ are walked cell by cell, in the same row-major order.
+            const uint64_t* now = grid.plane(Models::Plane::Walkable).data();
+            const uint64_t* was = m_walkPlane.data();
+            bool changed = false;
+            for (int w = 0; w < AI::VisMask::WORDS; ++w) {
+                if (now[w] == was[w]) continue;
+                const int r = w / AI::VisMask::WORDS_PER_ROW;
+                const int c0 = (w % AI::VisMask::WORDS_PER_ROW) * 64;
+                const int c1 = std::min(N, c0 + 64);
+                for (int c = c0; c < c1; ++c) {
+                    const int i = r * N + c;
+                    const uint8_t on = (now[w] >> (c & 63)) & 1u;
+                    if (on == m_walkable[i]) continue;
+                    if (on) open(i); else block(i);
+                    changed = true;
+                }
+            }
+            m_walkPlane = grid.plane(Models::Plane::Walkable);
+            if (changed) refreshMain();
+        }
+
+        void Connectivity::refreshMain() {
+            m_main = 0;
+            int best = 0;
+            for (int l = 1; l < (int)m_size.size(); ++l) {
+                if (m_size[l] > best) { best = m_size[l]; m_main = l; }
+            }
+        }
+
+        int Connectivity::componentCount() const {
+            int n = 0;
+            for (size_t l = 1; l < m_size.size(); ++l) if (m_size[l] > 0) ++n;
+            return n;
+        }
+
+    } // namespace Pathfinding
+} // namespace AI
@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+
+namespace AI {
+    namespace Pathfinding {
+
+        // Connected components of the walkable cells (4-neighbour, same rule
+        // as IsWalkableForMovement). Two cells are mutually reachable iff
+        // they carry the same non-zero label, so path requests and candidate
+        // filters can reject enclosed targets without searching.
+        //
+        // Labels follow Grid::revision(). sync() diffs walkability against
+        // the last grid it saw (word-wise, on the walkable bitplane) and applies the changed cells one by one. An
+        // opened cell joins its largest neighbouring component and the
+        // smaller ones are relabelled into it. A blocked cell whose remaining
+        // neighbours are not joined around it through the 3x3 ring may have
+        // been a cut; the pieces are then searched in lockstep and only the
+        // ones found to be closed off are relabelled. Queries are const and
+        // read the last synced state.
+        class Connectivity {
+        public:
+            static constexpr int N = Definitions::GRID_SIZE;
+            static constexpr int CELLS = N * N;
+
+            Connectivity();
+
+            void sync(const Models::Grid& grid);
+
+            // Component label, 0 for blocked or out-of-grid cells.
+            inline int label(int r, int c) const {
+                if (r < 0 || r >= N || c < 0 || c >= N) return 0;
+                return m_label[r * N + c];
+            }
+
+            inline bool connected(int r0, int c0, int r1, int c1) const {
+                const int a = label(r0, c0);
+                return a != 0 && a == label(r1, c1);
+            }
+
+            // A path request from (r0,c0) to (r1,c1) can be turned down:
+            // the goal is blocked, or both ends are walkable but apart. A
+            // start on a blocked cell is given the benefit of the doubt.
+            inline bool unreachable(int r0, int c0, int r1, int c1) const {
+                const int b = label(r1, c1);
+                if (b == 0) return true;
+                const int a = label(r0, c0);
+                return a != 0 && a != b;
+            }
+
+            // Label of the largest component (where spawns and anchors go).
+            int mainLabel() const { return m_main; }
+            int componentCount() const;
+            int componentSize(int lbl) const {
+                return (lbl > 0 && lbl < (int)m_size.size()) ? m_size[lbl] : 0;
+            }
+
+            // Cells re-flooded by incremental updates since start-up.
+            uint64_t cellsRelabelled() const { return m_relabelled; }
+
+        private:
+            void relabelAll(const Models::Grid& grid);
+            // Relabels the cells reachable from `seed` (only those labelled
+            // `only`, if given) to `lbl`; returns how many changed label.
+            int  flood(int seed, int lbl, int only = -1);
+            int  newLabel();
+            void open(int i);
+            void block(int i);
+            bool mayHaveSplit(int i) const;
+            void refreshMain();
+
+            std::vector<int>      m_label;
+            std::vector<uint8_t>  m_walkable;
+            AI::VisMask           m_walkPlane;  // walkable plane at last sync
+            std::vector<int>      m_size;      // cells per label, 0 = retired
+            std::vector<uint32_t> m_stamp;     // cell flooded in pass m_pass
+            std::vector<int>      m_queue;
+            std::vector<int>      m_pieceQueue[4];   // block(): one search per neighbour
+            uint32_t m_pass = 0;
+            uint32_t m_gridRevision = 0;
+            int      m_main = 0;
+            bool     m_built = false;
+            uint64_t m_relabelled = 0;
+        };
+
+    } // namespace Pathfinding
+} // namespace AI
@@ -0,0 +1,69 @@
+#include "CoverField.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace AI {
+    namespace Pathfinding {
+
+        int ThreatOctant(int r, int c, int tr, int tc) {
+            // Index by (step row + 1) * 3 + (step col + 1).
+            static const int8_t OCTANT[9] = { 7, 1, 6, 3, -1, 2, 5, 0, 4 };
+            const int dr = std::abs(tr - r), dc = std::abs(tc - c);
+            const int err = (dc > dr ? dc : -dr) / 2;
+            const int sr = (err < dr) ? (r < tr ? 1 : -1) : 0;
+            const int sc = (err > -dc) ? (c < tc ? 1 : -1) : 0;
+            return OCTANT[(sr + 1) * 3 + (sc + 1)];
+        }
+
+        CoverField::CoverField()
+            : m_dist(CELLS, FAR)
+            , m_rockDirs(CELLS, 0)
+        {
+        }
+
+        void CoverField::sync(const Models::Grid& grid) {
+            if (m_built && grid.revision() == m_gridRevision) return;
+            m_gridRevision = grid.revision();
+            rebuild(grid);
+            m_built = true;
+            ++m_rebuilds;
+        }
+
+        void CoverField::rebuild(const Models::Grid& grid) {
+            using namespace Definitions;
+
+            // Two-pass L1 distance transform: forward pass pulls from above
+            // and the left, backward pass from below and the right.
+            for (int r = 0; r < N; ++r) {
+                for (int c = 0; c < N; ++c) {
+                    const int v = grid.at(r, c);
+                    int d = (v == ROCK || v == TREE) ? 0 : FAR;
+                    if (r > 0) d = std::min(d, m_dist[(r - 1) * N + c] + 1);
+                    if (c > 0) d = std::min(d, m_dist[r * N + c - 1] + 1);
+                    m_dist[r * N + c] = (uint8_t)d;
+                }
+            }
+            for (int r = N - 1; r >= 0; --r) {
+                for (int c = N - 1; c >= 0; --c) {
+                    int d = m_dist[r * N + c];
+                    if (r < N - 1) d = std::min(d, m_dist[(r + 1) * N + c] + 1);
+                    if (c < N - 1) d = std::min(d, m_dist[r * N + c + 1] + 1);
+                    m_dist[r * N + c] = (uint8_t)std::min(d, (int)FAR);
+                }
+            }
+
+            for (int r = 0; r < N; ++r) {
+                for (int c = 0; c < N; ++c) {
+                    uint8_t dirs = 0;
+                    for (int k = 0; k < 8; ++k) {
+                        const int nr = r + OctantDR[k], nc = c + OctantDC[k];
+                        if (nr < 0 || nr >= N || nc < 0 || nc >= N) continue;
+                        if (grid.at(nr, nc) == ROCK) dirs |= (uint8_t)(1u << k);
+                    }
+                    m_rockDirs[r * N + c] = dirs;
+                }
+            }
+        }
+
+    } // namespace Pathfinding
+} // namespace AI
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+
+namespace AI {
+    namespace Pathfinding {
+
+        // Directions in Neighbourhood<8> order: +row, -row, +col, -col, then
+        // (+row,+col), (+row,-col), (-row,+col), (-row,-col).
+        constexpr int OctantDR[8] = { +1, -1, 0, 0, +1, +1, -1, -1 };
+        constexpr int OctantDC[8] = { 0, 0, +1, -1, +1, -1, +1, -1 };
+
+        // Octant of a threat at (tr,tc) seen from (r,c): the neighbour the
+        // line-of-sight walk (Bresenham, as in Visibility::HasLineOfSight)
+        // steps onto first. -1 for the same cell.
+        int ThreatOctant(int r, int c, int tr, int tc);
+
+        // Terrain-derived cover data, rebuilt whenever Grid::revision()
+        // changes (terrain edits are rare, queries are per candidate cell):
+        //  - distance in 4-neighbour steps to the nearest ROCK or TREE, the
+        //    obstacles that make a cell cover-adjacent;
+        //  - per cell, one bit per octant whose neighbour is a ROCK, which
+        //    blocks both sight and shots from that side.
+        // The cover-adjacency mask itself is Grid's CoverAdjacent plane.
+        class CoverField {
+        public:
+            static constexpr int N = Definitions::GRID_SIZE;
+            static constexpr int CELLS = N * N;
+            static constexpr int FAR = 255;     // distances saturate here
+
+            CoverField();
+
+            void sync(const Models::Grid& grid);
+
+            // 0 on a rock or tree, FAR when there is none (or out of grid).
+            inline int obstacleDistance(int r, int c) const {
+                if (r < 0 || r >= N || c < 0 || c >= N) return FAR;
+                return m_dist[r * N + c];
+            }
+
+            // Whether any cell within Manhattan `radius` of (r,c) can be
+            // cover-adjacent; when false a cover search there will fail.
+            inline bool coverWithin(int r, int c, int radius) const {
+                return obstacleDistance(r, c) <= radius + 1;
+            }
+
+            // Bit k set: the neighbour in octant k is a rock.
+            inline uint8_t rockDirs(int r, int c) const {
+                if (r < 0 || r >= N || c < 0 || c >= N) return 0;
+                return m_rockDirs[r * N + c];
+            }
+            inline bool rockAdjacent(int r, int c) const { return rockDirs(r, c) != 0; }
+
+            // A rock sits on the first step toward (tr,tc), so there is no
+            // line of sight between the two cells. False does not imply
+            // the opposite; the ray has to be walked.
+            inline bool coveredFrom(int r, int c, int tr, int tc) const {
+                const int k = ThreatOctant(r, c, tr, tc);
+                return k >= 0 && ((rockDirs(r, c) >> k) & 1u);
+            }
+
+            uint64_t rebuilds() const { return m_rebuilds; }
+
+        private:
+            void rebuild(const Models::Grid& grid);
+
+            std::vector<uint8_t> m_dist;
+            std::vector<uint8_t> m_rockDirs;
+            uint32_t m_gridRevision = 0;
+            bool     m_built = false;
+            uint64_t m_rebuilds = 0;
+        };
+
+    } // namespace Pathfinding
+} // namespace AI
@@ -76,10 +76,28 @@ namespace Definitions {
     constexpr int   REPLAN_COOLDOWN_FRAMES = 12;
 
     constexpr int   LOCAL_COVER_RADIUS = 2;
+    // How far around its anchor a defender looks for a cover cell.
+    constexpr int   DEFEND_COVER_RADIUS = 6;
     constexpr float LOCAL_COVER_DELTA = 0.22f;
 
     constexpr float ASTAR_RISK_WEIGHT = 5.5f;
 
+    // Hierarchical pathfinding: cluster edge in cells, and the Manhattan
+    // distance from which Planner::Auto stops using flat A*.
+    constexpr int   HPA_CLUSTER_SIZE = 10;
+    constexpr int   HPA_MIN_DISTANCE = 24;
+
+    // Path job queue: A* nodes all queued searches may expand per tick, the
+    // smallest slice one search is given, and the ticks a search may run
+    // before its best partial path is handed back.
+    constexpr int   PATH_NODE_BUDGET = 6000;
+    constexpr int   PATH_MIN_SLICE = 500;
+    constexpr int   PATH_MAX_SLICES = 8;
+
+    // Grid searches order their open set by cost in steps of
+    // 1/PATH_COST_SCALE (BucketQueue); costs within a step tie.
+    constexpr int   PATH_COST_SCALE = 16;
+
     constexpr float DETOUR_MAX_RATIO = 1.8f;
     constexpr float DETOUR_MIN_RISK_DROP = 0.15f;
 
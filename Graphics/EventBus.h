@@ -10,15 +10,13 @@ namespace AI {
     public:
         using Handler = std::function<void(const Message&)>;
 
-        static EventBus& instance() {
-            static EventBus bus; return bus;
-        }
-
         int subscribe(int key, Handler h) {
             handlers[key].push_back(std::move(h));
             return (int)handlers[key].size();
         }
 
+        void clear() { handlers.clear(); }
+
         void publish(const Message& m) {
             if (m.toUnitId != -1) {
                 auto it = handlers.find(m.toUnitId);
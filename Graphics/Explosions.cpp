@@ -0,0 +1,107 @@
+#include "Explosions.h"
+#include <algorithm>
+#include <cmath>
+#include "SpatialHash.h"
+#include "Units.h"
+
+using namespace Definitions;
+
+namespace Combat {
+
+    void Explosions::setParams(const Params& params) {
+        const bool sameStencil = m_haveParams && params.radius == m_params.radius;
+        m_params = params;
+        m_haveParams = true;
+
+        const float R = params.radius;
+        const float R2 = R * R;
+        if (!sameStencil) {
+            m_reach = std::max(0, (int)std::floor(R));
+            const int side = 2 * m_reach + 1;
+            m_slot.assign(side * side, -1);
+            m_offR.clear();
+            m_offC.clear();
+            for (int dr = -m_reach; dr <= m_reach; ++dr)
+                for (int dc = -m_reach; dc <= m_reach; ++dc) {
+                    if (float(dr * dr + dc * dc) > R2) continue;
+                    m_slot[(dr + m_reach) * side + (dc + m_reach)] = (int16_t)m_offR.size();
+                    m_offR.push_back((int8_t)dr);
+                    m_offC.push_back((int8_t)dc);
+                }
+            m_words = std::max(1, ((int)m_offR.size() + 63) / 64);
+            m_cover.assign((size_t)GRID_SIZE * GRID_SIZE * m_words, 0);
+            m_stamp.assign((size_t)GRID_SIZE * GRID_SIZE, 0);
+            m_epoch = 0;    // forces a rebuild on the next blast
+        }
+
+        // The same float steps the per-unit formula takes, so the table
+        // matches it exactly.
+        const int n = (int)m_offR.size();
+        m_dmgOpen.resize(n);
+        m_dmgCovered.resize(n);
+        for (int k = 0; k < n; ++k) {
+            const float d = std::sqrt(float(m_offR[k] * m_offR[k] + m_offC[k] * m_offC[k]));
+            const float t = std::max(0.f, std::min(1.f, 1.0f - (d / R)));
+            const float dmgf = float(params.dmgEdge) + (float(params.dmgCenter) - float(params.dmgEdge)) * t;
+            m_dmgOpen[k] = (int)std::round(dmgf);
+            m_dmgCovered[k] = (int)std::round(dmgf * params.coverFactor);
+        }
+    }
+
+    const uint64_t* Explosions::coverMask(const Models::Grid& grid, int r, int c) {
+        if (m_epoch == 0 || grid.revision() != m_gridRevision) {
+            m_gridRevision = grid.revision();
+            if (++m_epoch == 0) {
+                std::fill(m_stamp.begin(), m_stamp.end(), 0);
+                m_epoch = 1;
+            }
+        }
+        const int cell = r * GRID_SIZE + c;
+        uint64_t* mask = &m_cover[(size_t)cell * m_words];
+        if (m_stamp[cell] == m_epoch) return mask;
+
+        std::fill(mask, mask + m_words, 0);
+        for (int k = 0; k < (int)m_offR.size(); ++k) {
+            const int tr = r + m_offR[k], tc = c + m_offC[k];
+            if (tr < 0 || tr >= GRID_SIZE || tc < 0 || tc >= GRID_SIZE) continue;
+            if (grid.blastBlocked(r, c, tr, tc)) mask[k >> 6] |= uint64_t(1) << (k & 63);
+        }
+        m_stamp[cell] = m_epoch;
+        ++m_coverBuilds;
+        return mask;
+    }
+
+    int Explosions::detonate(const Models::Grid& grid, const Simulation::SpatialHash& units,
+        int r, int c, uint8_t teams, const Params& params)
+    {
+        if (units.size() == 0) return 0;
+        if (!m_haveParams || params.radius != m_params.radius || params.dmgCenter != m_params.dmgCenter ||
+            params.dmgEdge != m_params.dmgEdge || params.coverFactor != m_params.coverFactor)
+            setParams(params);
+
+        const bool onGrid = r >= 0 && r < GRID_SIZE && c >= 0 && c < GRID_SIZE;
+        const uint64_t* cover = (params.cover && onGrid) ? coverMask(grid, r, c) : nullptr;
+        const int side = 2 * m_reach + 1;
+
+        units.gather(teams, (float)r, (float)c, params.radius, m_nearby);
+        m_batch.clear();
+        for (auto* u : m_nearby) {
+            const int dr = u->row - r, dc = u->col - c;
+            if (std::abs(dr) > m_reach || std::abs(dc) > m_reach) continue;
+            const int k = m_slot[(dr + m_reach) * side + (dc + m_reach)];
+            if (k < 0) continue;
+            bool covered = false;
+            if (cover) covered = (cover[k >> 6] >> (k & 63)) & 1;
+            else if (params.cover) covered = grid.blastBlocked(r, c, u->row, u->col);
+            const int dmg = covered ? m_dmgCovered[k] : m_dmgOpen[k];
+            if (dmg > 0) m_batch.push_back({ u, dmg });
+        }
+
+        for (const Blow& b : m_batch) {
+            b.unit->stats.hp -= b.dmg;
+            if (b.unit->stats.hp <= 0) { b.unit->stats.hp = 0; b.unit->kill(); }
+        }
+        return (int)m_batch.size();
+    }
+
+} // namespace Combat
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+
+namespace Models { class Unit; }
+namespace Simulation { class SpatialHash; }
+
+namespace Combat {
+
+    // Grenade blasts. Damage falls off linearly from the centre of the
+    // blast cell to the radius, and is scaled down for units with
+    // explosive-blocking terrain between them and the blast (a Bresenham
+    // walk, Grid::blastBlocked).
+    //
+    // Every offset within the radius is a fixed stencil, so falloff damage
+    // is tabulated once per set of parameters, and which stencil cells are
+    // in cover is worked out once per blast cell and kept until the
+    // terrain or the radius changes. A blast then gathers its candidates
+    // from the unit index, looks each one up, and applies the damage as a
+    // batch.
+    class Explosions {
+    public:
+        struct Params {
+            float radius = 2.5f;
+            int   dmgCenter = 50;
+            int   dmgEdge = 10;
+            float coverFactor = 0.35f;
+            bool  cover = true;     // scale damage behind explosive-blocking terrain
+        };
+
+        // Damages the units of `teams` around cell (r,c); returns how many.
+        int detonate(const Models::Grid& grid, const Simulation::SpatialHash& units,
+            int r, int c, uint8_t teams, const Params& params);
+
+        // Blast cells whose cover mask was (re)built, for benchmarks.
+        long long coverBuilds() const { return m_coverBuilds; }
+
+    private:
+        void setParams(const Params& params);
+        // One bit per stencil offset: set where the offset is in cover from
+        // a blast in (r,c). Built on first use after a terrain change.
+        const uint64_t* coverMask(const Models::Grid& grid, int r, int c);
+
+        Params m_params;
+        bool   m_haveParams = false;
+
+        int m_reach = 0;                  // largest |offset| on either axis
+        std::vector<int16_t> m_slot;      // (2 reach + 1)^2 window -> stencil index, -1 outside
+        std::vector<int8_t>  m_offR, m_offC;
+        std::vector<int>     m_dmgOpen, m_dmgCovered;
+        int m_words = 0;
+
+        std::vector<uint64_t> m_cover;    // GRID_SIZE^2 blast cells x m_words
+        std::vector<uint32_t> m_stamp;    // a cell's mask is valid when stamp == epoch
+        uint32_t m_epoch = 0;
+        uint32_t m_gridRevision = 0;
+        long long m_coverBuilds = 0;
+
+        std::vector<Models::Unit*> m_nearby;
+        struct Blow { Models::Unit* unit; int dmg; };
+        std::vector<Blow> m_batch;
+    };
+
+} // namespace Combat
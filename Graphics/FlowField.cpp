@@ -0,0 +1,124 @@
+#include "FlowField.h"
+#include <limits>
+#include "Profiler.h"
+
+using namespace Definitions;
+
+namespace AI {
+    namespace Pathfinding {
+
+        namespace {
+            constexpr float INF = std::numeric_limits<float>::infinity();
+            const int DR[4] = { +1,-1,0,0 };
+            const int DC[4] = { 0,0,+1,-1 };
+        }
+
+        FlowFieldService::FlowFieldService()
+            : m_open(256)
+        {
+        }
+
+        void FlowFieldService::clear() {
+            for (auto& f : m_fields) f.goal = -1;
+        }
+
+        void FlowFieldService::build(Field& f, const Models::Grid& grid, const Simulation::SecurityMap& smap, int goalIdx) {
+            SIM_PROFILE_ZONE(FlowField);
+            f.goal = goalIdx;
+            f.gridRevision = grid.revision();
+            f.riskVersion = smap.version();
+            f.builtFrame = m_frame;
+            f.dist.assign(CELLS, INF);
+            f.dir.assign(CELLS, -1);
+            ++m_built;
+
+            const int gr = goalIdx / N, gc = goalIdx % N;
+            if (!grid.walkable(gr, gc)) return;
+
+            const auto& norm = smap.normalized();
+            const float w = ASTAR_RISK_WEIGHT;
+            m_open.clear();
+            f.dist[goalIdx] = 0.0f;
+            m_open.push(0, { 0.0f, 0.0f, goalIdx });
+
+            // Cells are settled in quantized order; one improved later inside
+            // the same bucket is simply pushed and relaxed again, so the
+            // distances stay exact.
+            while (!m_open.empty()) {
+                const PathfinderContext::Node cur = m_open.pop();
+                if (cur.g > f.dist[cur.idx]) continue;
+
+                const int br = cur.idx / N, bc = cur.idx % N;
+                // Anyone stepping onto b pays for entering it.
+                const float enter = 1.0f + w * norm[br][bc];
+                for (int k = 0; k < 4; ++k) {
+                    const int ar = br + DR[k], ac = bc + DC[k];
+                    if (ar < 0 || ar >= N || ac < 0 || ac >= N) continue;
+                    if (!grid.walkable(ar, ac)) continue;
+                    const int a = ar * N + ac;
+                    const float nd = cur.g + enter;
+                    if (nd < f.dist[a]) {
+                        f.dist[a] = nd;
+                        f.dir[a] = (int8_t)(k ^ 1);   // from a, step back the way we came
+                        m_open.push(CostKey(nd), { nd, nd, a });
+                    }
+                }
+            }
+        }
+
+        FlowFieldService::Field& FlowFieldService::acquire(const Models::Grid& grid, const Simulation::SecurityMap& smap, int goalIdx) {
+            Field* hit = nullptr;
+            Field* victim = &m_fields[0];
+            for (auto& f : m_fields) {
+                if (f.goal == goalIdx) { hit = &f; break; }
+                // Prefer an empty slot, then the least recently used one.
+                if (victim->goal >= 0 && (f.goal < 0 || f.lastUse < victim->lastUse)) victim = &f;
+            }
+
+            Field& f = hit ? *hit : *victim;
+            const bool stale = !hit
+                || f.gridRevision != grid.revision()
+                || (f.riskVersion != smap.version() && m_frame - f.builtFrame >= MAX_AGE_FRAMES);
+            if (stale) build(f, grid, smap, goalIdx);
+            f.lastUse = ++m_useClock;
+            return f;
+        }
+
+        bool FlowFieldService::nextStep(const Models::Grid& grid, const Simulation::SecurityMap& smap,
+            Cell goal, int r, int c, int& outR, int& outC)
+        {
+            if (goal.first < 0 || goal.first >= N || goal.second < 0 || goal.second >= N) return false;
+            if (r < 0 || r >= N || c < 0 || c >= N) return false;
+            const Field& f = acquire(grid, smap, goal.first * N + goal.second);
+            const int d = f.dir[r * N + c];
+            if (d < 0) return false;
+            outR = r + DR[d];
+            outC = c + DC[d];
+            return true;
+        }
+
+        bool FlowFieldService::extractPath(const Models::Grid& grid, const Simulation::SecurityMap& smap,
+            Cell start, Cell goal, Path& out)
+        {
+            out.clear();
+            if (goal.first < 0 || goal.first >= N || goal.second < 0 || goal.second >= N) return false;
+            if (start.first < 0 || start.first >= N || start.second < 0 || start.second >= N) return false;
+
+            const int goalIdx = goal.first * N + goal.second;
+            const Field& f = acquire(grid, smap, goalIdx);
+            int cur = start.first * N + start.second;
+            if (cur != goalIdx && f.dir[cur] < 0) return false;
+
+            out.push_back(start);
+            while (cur != goalIdx) {
+                const int d = f.dir[cur];
+                if (d < 0 || (int)out.size() > CELLS) { out.clear(); return false; }
+                const int r = cur / N + DR[d], c = cur % N + DC[d];
+                cur = r * N + c;
+                out.push_back({ r, c });
+            }
+            return true;
+        }
+
+    } // namespace Pathfinding
+} // namespace AI
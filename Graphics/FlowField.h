@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+#include "SecurityMap.h"
+#include "Pathfinding.h"
+
+namespace AI {
+    namespace Pathfinding {
+
+        // Reverse Dijkstra maps toward shared goals (depots, commander
+        // anchors). One field answers "which way from here" for every unit
+        // heading to that goal, so N units cost one search instead of N.
+        //
+        // Fields are cached per goal cell and tagged with the grid revision
+        // and SecurityMap version they were built from. Terrain changes always
+        // rebuild; risk changes rebuild once the field is MAX_AGE_FRAMES old,
+        // since bullets move the security map every frame. Step costs match
+        // A* (1 + w * normalized risk of the cell entered) with the default
+        // ASTAR_RISK_WEIGHT; occupancy is not part of the field.
+        class FlowFieldService {
+        public:
+            static constexpr int N = Definitions::GRID_SIZE;
+            static constexpr int CELLS = N * N;
+            static constexpr int SLOTS = 8;
+            static constexpr int MAX_AGE_FRAMES = 15;
+
+            FlowFieldService();
+
+            void setFrame(int frame) { m_frame = frame; }
+            void clear();
+
+            // Next cell from (r,c) toward the goal; false if unreachable.
+            bool nextStep(const Models::Grid& grid, const Simulation::SecurityMap& smap,
+                Cell goal, int r, int c, int& outR, int& outC);
+
+            // Full path start..goal by following the field (O(length)).
+            bool extractPath(const Models::Grid& grid, const Simulation::SecurityMap& smap,
+                Cell start, Cell goal, Path& out);
+
+            int fieldsBuilt() const { return m_built; }
+
+        private:
+            struct Field {
+                int      goal = -1;
+                uint32_t gridRevision = 0;
+                uint32_t riskVersion = 0;
+                int      builtFrame = 0;
+                uint64_t lastUse = 0;
+                std::vector<float>  dist;
+                std::vector<int8_t> dir;   // index into the 4-neighbour table, -1 = none
+            };
+
+            Field& acquire(const Models::Grid& grid, const Simulation::SecurityMap& smap, int goalIdx);
+            void build(Field& f, const Models::Grid& grid, const Simulation::SecurityMap& smap, int goalIdx);
+
+            std::array<Field, SLOTS> m_fields;
+            BucketQueue<PathfinderContext::Node> m_open;
+            uint64_t m_useClock = 0;
+            int m_frame = 0;
+            int m_built = 0;
+        };
+
+    } // namespace Pathfinding
+} // namespace AI
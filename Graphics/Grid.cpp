@@ -3,6 +3,7 @@
 #include <random>
 #include <algorithm>
 #include <cmath>
+#include <atomic>
 
 using namespace Definitions;
 
@@ -10,20 +11,84 @@ namespace Models {
 
     const int UI_SAFE_ZONE_ROWS = 15;
 
+    uint32_t Grid::NextRevision() {
+        static std::atomic<uint32_t> counter(0);
+        return ++counter;
+    }
+
     Grid::Grid() {
+        Simulation::Rng rng(std::random_device{}());
         clearAll();
-        placeObstacles(-1,-1, 0);
+        placeObstacles(rng);
         placeDepots(); 
     }
 
+    Grid::Grid(Simulation::Rng& rng) {
+        clearAll();
+        placeObstacles(rng);
+        placeDepots();
+    }
+
     void Grid::clearAll() {
-        for (auto& row : cells) row.fill(Cell::EMPTY);
+        terrain.fill((CellT)Cell::ROCK);
+        propBytes.fill(0);
+        for (int r = 0; r < GRID_SIZE; ++r)
+            for (int c = 0; c < GRID_SIZE; ++c)
+                terrain[padIndex(r, c)] = (CellT)Cell::EMPTY;
+        for (int r = 0; r < GRID_SIZE; ++r)
+            for (int c = 0; c < GRID_SIZE; ++c)
+                writeProps(r, c);
+    }
+
+    void Grid::writeProps(int r, int c) {
+        const int p = padIndex(r, c);
+        uint8_t props = TypeProps(terrain[p]);
+        auto coverAt = [&](int rr, int cc) {
+            if (rr < 0 || rr >= GRID_SIZE || cc < 0 || cc >= GRID_SIZE) return false;
+            const int v = terrain[padIndex(rr, cc)];
+            return v == Cell::ROCK || v == Cell::TREE;
+        };
+        if (coverAt(r + 1, c) || coverAt(r - 1, c) || coverAt(r, c + 1) || coverAt(r, c - 1))
+            props |= PlaneBit(Plane::CoverAdjacent);
+        if (props == propBytes[p]) return;
+        propBytes[p] = props;
+        for (int k = 0; k < (int)Plane::Count; ++k) {
+            if (props & (1u << k)) planes[k].set(r, c);
+            else                   planes[k].reset(r, c);
+        }
+    }
+
+    // A changed cell can change its own type properties and whether its
+    // neighbours are next to cover.
+    void Grid::refreshProps(int r, int c) {
+        writeProps(r, c);
+        if (r > 0)             writeProps(r - 1, c);
+        if (r < GRID_SIZE - 1) writeProps(r + 1, c);
+        if (c > 0)             writeProps(r, c - 1);
+        if (c < GRID_SIZE - 1) writeProps(r, c + 1);
     }
 
     static inline bool inBounds(int r, int c) {
         return r >= 0 && r < GRID_SIZE && c >= 0 && c < GRID_SIZE;
     }
 
+    bool Grid::blastBlocked(int r0, int c0, int r1, int c1) const {
+        const int dr = std::abs(r1 - r0), dc = std::abs(c1 - c0);
+        const int sr = (r0 < r1) ? 1 : -1;
+        const int sc = (c0 < c1) ? 1 : -1;
+        int err = dr - dc;
+        int r = r0, c = c0;
+
+        while (!(r == r1 && c == c1)) {
+            if (!inBounds(r, c)) break;
+            if (blocksExplosive(r, c)) return true;
+            const int e2 = 2 * err;
+            if (e2 > -dc) { err -= dc; r += sr; }
+            if (e2 < dr) { err += dr; c += sc; }
+        }
+        return false;
+    }
+
     static inline bool isRiver(int, int c) {
         const int mid = GRID_SIZE / 2;
         return c == mid;
@@ -47,18 +112,15 @@ namespace Models {
         return true;
     }
 
-    static void placeTreeCluster(Grid& g, int r0, int c0, std::mt19937& rng) {
+    static void placeTreeCluster(Grid& g, int r0, int c0, Simulation::Rng& rng) {
         if (!canPlaceHere(g, r0, c0)) return;
         g.set(r0, c0, Cell::TREE);
 
-        std::uniform_int_distribution<int> clusterSize(1, 3);
-        std::uniform_int_distribution<int> dStep(-1, 1);
-
-        int extra = clusterSize(rng);
+        int extra = rng.range(1, 3);
         int r = r0, c = c0;
         for (int k = 0; k < extra; ++k) {
-            int nr = r + dStep(rng);
-            int nc = c + dStep(rng);
+            int nr = r + rng.range(-1, 1);
+            int nc = c + rng.range(-1, 1);
             if (canPlaceHere(g, nr, nc)) {
                 g.set(nr, nc, Cell::TREE);
                 r = nr; c = nc;
@@ -66,17 +128,15 @@ namespace Models {
         }
     }
 
-    static void placeRock(Grid& g, int r0, int c0, std::mt19937& rng) {
+    static void placeRock(Grid& g, int r0, int c0, Simulation::Rng& rng) {
         if (!canPlaceHere(g, r0, c0)) return;
         g.set(r0, c0, Cell::ROCK);
 
-        std::bernoulli_distribution extend(0.35);
-        if (extend(rng)) {
-            std::uniform_int_distribution<int> dir(0, 3);
-            int d = dir(rng);
+        if (rng.chance(0.35f)) {
+            int d = rng.below(4);
             int dr[4] = { 1,-1,0,0 };
             int dc[4] = { 0,0,1,-1 };
-            int len = 1 + (rng() % 2);
+            int len = 1 + rng.below(2);
             int r = r0, c = c0;
             for (int k = 0; k < len; ++k) {
                 r += dr[d]; c += dc[d];
@@ -92,7 +152,7 @@ namespace Models {
             g.set(r, mid, Cell::WATER);
     }
 
-    void Grid::placeObstacles(int numTrees, int numRocks, unsigned seed)
+    void Grid::placeObstacles(Simulation::Rng& rng, int numTrees, int numRocks)
     {
         carveRiver(*this);
 
@@ -100,23 +160,10 @@ namespace Models {
         if (numTrees < 0) numTrees = std::max(18, area / 70);  
         if (numRocks < 0) numRocks = std::max(15, area / 90);  
 
-        std::mt19937 rng;
-        if (seed != 0) rng.seed(seed);
-        else           rng.seed(std::random_device{}());
-
-        std::uniform_int_distribution<int> rowDist(0, GRID_SIZE - 1);
-
-        auto randomColOffRiver = [&](std::mt19937& r) {
+        auto randomColOffRiver = [&](Simulation::Rng& r) {
             const int mid = GRID_SIZE / 2;
-            std::bernoulli_distribution side(0.5);
-            if (side(r)) {
-                std::uniform_int_distribution<int> cdist(0, mid - 2);         
-                return cdist(r);
-            }
-            else {
-                std::uniform_int_distribution<int> cdist(mid + 2, GRID_SIZE - 1); 
-                return cdist(r);
-            }
+            if (r.chance(0.5f)) return r.range(0, mid - 2);
+            return r.range(mid + 2, GRID_SIZE - 1);
             };
 
         {
@@ -124,7 +171,7 @@ namespace Models {
             const int maxAttempts = numTrees * 20;
             while (placed < numTrees && attempts < maxAttempts) {
                 ++attempts;
-                int r = rowDist(rng);
+                int r = rng.below(GRID_SIZE);
                 int c = randomColOffRiver(rng);
                 if (!canPlaceHere(*this, r, c)) continue;
                 placeTreeCluster(*this, r, c, rng);
@@ -137,7 +184,7 @@ namespace Models {
             const int maxAttempts = numRocks * 20;
             while (placed < numRocks && attempts < maxAttempts) {
                 ++attempts;
-                int r = rowDist(rng);
+                int r = rng.below(GRID_SIZE);
                 int c = randomColOffRiver(rng);
                 if (!canPlaceHere(*this, r, c)) continue;
                 placeRock(*this, r, c, rng);
@@ -156,16 +203,16 @@ namespace Models {
 
         for (int dr = -1; dr <= 1; ++dr)
             for (int dc = -1; dc <= 1; ++dc) {
-                cells[marks.ammoBlue.first + dr][marks.ammoBlue.second + dc] = Cell::EMPTY;
-                cells[marks.medBlue.first + dr][marks.medBlue.second + dc] = Cell::EMPTY;
-                cells[marks.ammoOrange.first + dr][marks.ammoOrange.second + dc] = Cell::EMPTY;
-                cells[marks.medOrange.first + dr][marks.medOrange.second + dc] = Cell::EMPTY;
+                set(marks.ammoBlue.first + dr, marks.ammoBlue.second + dc, Cell::EMPTY);
+                set(marks.medBlue.first + dr, marks.medBlue.second + dc, Cell::EMPTY);
+                set(marks.ammoOrange.first + dr, marks.ammoOrange.second + dc, Cell::EMPTY);
+                set(marks.medOrange.first + dr, marks.medOrange.second + dc, Cell::EMPTY);
             }
 
-        cells[marks.ammoBlue.first][marks.ammoBlue.second] = Cell::DEPOT_AMMO;
-        cells[marks.medBlue.first][marks.medBlue.second] = Cell::DEPOT_MED;
-        cells[marks.ammoOrange.first][marks.ammoOrange.second] = Cell::DEPOT_AMMO;
-        cells[marks.medOrange.first][marks.medOrange.second] = Cell::DEPOT_MED;
+        set(marks.ammoBlue.first, marks.ammoBlue.second, Cell::DEPOT_AMMO);
+        set(marks.medBlue.first, marks.medBlue.second, Cell::DEPOT_MED);
+        set(marks.ammoOrange.first, marks.ammoOrange.second, Cell::DEPOT_AMMO);
+        set(marks.medOrange.first, marks.medOrange.second, Cell::DEPOT_MED);
     }
 
 } // namespace Models
@@ -1,14 +1,40 @@
 #pragma once
 #include <array>
 #include <utility>
+#include <cstdint>
 #include "Definitions.h"
+#include "Rng.h"
+#include "VisMask.h"
 
 namespace Models {
 
-    using CellT = int;
-    using GridArray = std::array<std::array<CellT, Definitions::GRID_SIZE>, Definitions::GRID_SIZE>;
+    using CellT = uint8_t;
     using ivec2 = std::pair<int, int>;
 
+    // Terrain properties the simulation asks about per probe. Each one is a
+    // bit of the per-cell property byte and has a bitplane of its own.
+    enum class Plane : uint8_t {
+        Walkable,           // not ROCK or WATER
+        BlocksLOS,          // ROCK
+        BlocksShot,         // ROCK
+        BlocksExplosive,    // ROCK, TREE, depots
+        CoverAdjacent,      // a 4-neighbour inside the grid is ROCK or TREE
+        Depot,              // DEPOT_AMMO or DEPOT_MED
+        Count
+    };
+
+    constexpr uint8_t PlaneBit(Plane p) { return (uint8_t)(1u << (int)p); }
+
+    // Properties that follow from the cell type alone (all but CoverAdjacent).
+    constexpr uint8_t TypeProps(int cell) {
+        return (uint8_t)(
+            (cell != Definitions::ROCK && cell != Definitions::WATER ? PlaneBit(Plane::Walkable) : 0) |
+            (cell == Definitions::ROCK ? PlaneBit(Plane::BlocksLOS) | PlaneBit(Plane::BlocksShot) : 0) |
+            (cell == Definitions::ROCK || cell == Definitions::TREE ||
+             cell == Definitions::DEPOT_AMMO || cell == Definitions::DEPOT_MED ? PlaneBit(Plane::BlocksExplosive) : 0) |
+            (cell == Definitions::DEPOT_AMMO || cell == Definitions::DEPOT_MED ? PlaneBit(Plane::Depot) : 0));
+    }
+
     struct Landmarks {
         ivec2 ammoBlue{ 2, 2 };
         ivec2 medBlue{ 2, 5 };
@@ -19,20 +45,71 @@ namespace Models {
 
     class Grid {
     public:
+        // Default maps are seeded from std::random_device; pass a stream to
+        // get the same map for the same seed.
         Grid();
+        explicit Grid(Simulation::Rng& rng);
+
+        // Padded layout for search kernels: the same terrain with a one-cell
+        // ROCK border, row stride GRID_SIZE + 2. A neighbour of any grid
+        // cell is then a fixed index offset and always inside the array.
+        static constexpr int STRIDE = Definitions::GRID_SIZE + 2;
+        static constexpr int PADDED_CELLS = STRIDE * STRIDE;
+        static inline int padIndex(int r, int c) { return (r + 1) * STRIDE + (c + 1); }
+        static inline int padRow(int p) { return p / STRIDE - 1; }
+        static inline int padCol(int p) { return p % STRIDE - 1; }
 
         inline int  size() const { return Definitions::GRID_SIZE; }
-        inline CellT at(int r, int c) const { return cells[r][c]; }
-        inline void set(int r, int c, CellT v) { cells[r][c] = v; }
+        inline CellT at(int r, int c) const { return terrain[padIndex(r, c)]; }
+        inline CellT atPadded(int p) const { return terrain[p]; }
+        inline const uint8_t* paddedData() const { return terrain.data(); }
+        inline void set(int r, int c, int v) {
+            const int p = padIndex(r, c);
+            if (terrain[p] == v) return;
+            terrain[p] = (CellT)v;
+            refreshProps(r, c);
+            rev = NextRevision();
+        }
+
+        // Property byte of a cell (PlaneBit flags); the padded border has
+        // none, so it is neither walkable nor blocking.
+        inline uint8_t props(int r, int c) const { return propBytes[padIndex(r, c)]; }
+        inline const uint8_t* paddedProps() const { return propBytes.data(); }
+        inline bool has(int r, int c, Plane p) const { return (props(r, c) & PlaneBit(p)) != 0; }
+
+        inline bool walkable(int r, int c) const        { return has(r, c, Plane::Walkable); }
+        inline bool blocksLOS(int r, int c) const       { return has(r, c, Plane::BlocksLOS); }
+        inline bool blocksShot(int r, int c) const      { return has(r, c, Plane::BlocksShot); }
+        inline bool blocksExplosive(int r, int c) const { return has(r, c, Plane::BlocksExplosive); }
+        inline bool coverAdjacent(int r, int c) const   { return has(r, c, Plane::CoverAdjacent); }
+        inline bool isDepot(int r, int c) const         { return has(r, c, Plane::Depot); }
+
+        // Bresenham walk from (r0,c0) towards (r1,c1): true if a cell before
+        // the target blocks explosives (the start counts, the target does not).
+        bool blastBlocked(int r0, int c0, int r1, int c1) const;
+
+        // One bit per cell, for word-at-a-time counts and mask operations.
+        inline const AI::VisMask& plane(Plane p) const { return planes[(int)p]; }
+
+        // Changes whenever a cell changes. Revisions are unique across all
+        // grids, so a replaced grid never looks like the one it replaced.
+        inline uint32_t revision() const { return rev; }
 
         const Landmarks& landmarks() const { return marks; }
 
     private:
-        GridArray  cells{};
+        std::array<CellT, PADDED_CELLS>   terrain{};
+        std::array<uint8_t, PADDED_CELLS> propBytes{};
+        std::array<AI::VisMask, (int)Plane::Count> planes{};
         Landmarks  marks;
+        uint32_t   rev = NextRevision();
+
+        static uint32_t NextRevision();
 
+        void refreshProps(int r, int c);
+        void writeProps(int r, int c);
         void clearAll();
-        void placeObstacles(int numTrees = -1, int numRocks = -1, unsigned seed = 0);
+        void placeObstacles(Simulation::Rng& rng, int numTrees = -1, int numRocks = -1);
         void placeDepots();
     };
 
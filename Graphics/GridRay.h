@@ -0,0 +1,62 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "Definitions.h"
+#include "Grid.h"
+
+namespace Combat {
+
+    // Amanatides-Woo walk along a ray in grid space (cell (r,c) covers
+    // [r, r+1) x [c, c+1)). t is distance along the unit direction; each
+    // call crosses at most one cell boundary.
+    struct GridRay {
+        static constexpr int NOT_YET = -1;     // next boundary is beyond tEnd
+        static constexpr int STOPPED = -2;     // left the grid or hit a shot-blocking cell
+
+        int   row = 0, col = 0;
+        float dr = 0.f, dc = 0.f;
+        // Distance to the current cell's next row / column boundary, and
+        // between boundaries.
+        float tMaxR = 0.f, tMaxC = 0.f, tDeltaR = 0.f, tDeltaC = 0.f;
+
+        // `dr`,`dc` must be a unit vector; false if (r,c) is off the grid.
+        bool start(float r, float c, float dr_, float dc_) {
+            if (!(r >= 0.f && r < (float)Definitions::GRID_SIZE &&
+                  c >= 0.f && c < (float)Definitions::GRID_SIZE)) return false;
+            const float inf = std::numeric_limits<float>::infinity();
+            dr = dr_; dc = dc_;
+            row = (int)r; col = (int)c;
+            tMaxR = dr > 0.f ? (row + 1 - r) / dr : dr < 0.f ? (r - row) / -dr : inf;
+            tMaxC = dc > 0.f ? (col + 1 - c) / dc : dc < 0.f ? (c - col) / -dc : inf;
+            tDeltaR = dr != 0.f ? 1.f / std::fabs(dr) : inf;
+            tDeltaC = dc != 0.f ? 1.f / std::fabs(dc) : inf;
+            return true;
+        }
+
+        // Crosses into the next cell if the ray gets there by tEnd. Returns
+        // its padded index (and the distance in `tEntry`), NOT_YET, or
+        // STOPPED. A tie (an exact corner) steps the row first.
+        int enterNext(float tEnd, const uint8_t* props, float* tEntry) {
+            float t;
+            if (tMaxR <= tMaxC) {
+                t = tMaxR;
+                if (t > tEnd) return NOT_YET;
+                row += dr > 0.f ? 1 : -1;
+                tMaxR += tDeltaR;
+            }
+            else {
+                t = tMaxC;
+                if (t > tEnd) return NOT_YET;
+                col += dc > 0.f ? 1 : -1;
+                tMaxC += tDeltaC;
+            }
+            *tEntry = t;
+            if (row < 0 || row >= Definitions::GRID_SIZE || col < 0 || col >= Definitions::GRID_SIZE) return STOPPED;
+            const int p = Models::Grid::padIndex(row, col);
+            if (props[p] & Models::PlaneBit(Models::Plane::BlocksShot)) return STOPPED;
+            return p;
+        }
+    };
+
+} // namespace Combat
@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Definitions.h"
+#include "MatchRunner.h"
+#include "Bench.h"
+#include "PathJobs.h"
+#include "Combat.h"
+#include "Log.h"
+#include "Profiler.h"
+
+// Runs the same frame pipeline as the GLUT build without a window: builds
+// the test world, enables the commanders and steps as fast as the CPU allows
+// until game over or the frame limit. With --matches K the K matches run in
+// parallel, each on its own World.
+
+static void usage(const char* exe)
+{
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --frames N     stop a match after N frames if nobody has won (default 20000)\n"
+        "  --seed S       master seed; match i uses S+i (default: time)\n"
+        "  --matches K    play K independent matches (default 1)\n"
+        "  --threads T    worker threads for --matches (default: hardware threads)\n"
+        "  --path-workers W  path-search threads per match (default 0: inline)\n"
+        "  --path-budget N   A* nodes per tick shared by queued searches (0 = unlimited)\n"
+        "  --projectiles  fly bullets and shrapnel as projectiles (default: hitscan)\n"
+        "  --verbose      keep the per-unit AI log on stdout\n"
+        "  --bench-path Q time Q cross-map queries with A* and HPA* and exit\n"
+        "  --bench-flow U U units path to one depot: per-unit search vs flow field\n"
+        "  --bench-jobs R a burst of R replans: in place vs the path job queue\n"
+        "  --bench-queue Q Q searches per map: binary heap vs bucket queue open set\n"
+        "  --bench-kernel Q Q searches: bounds-checked vs padded-grid A* and BFS\n"
+        "  --bench-terrain R R rounds of map counts and probes: int cells vs bitplanes\n"
+        "  --bench-cover S S retreat cover scans: neighbour probes vs the cover field\n"
+        "  --bench-fov V   V viewpoints' field of view: line-of-sight rays vs shadowcasting\n"
+        "  --bench-units U U units' proximity queries: full scans vs the spatial hash\n"
+        "  --bench-bullets B B bullets in flight: array of structs vs projectile pool\n"
+        "  --bench-hits B B bullets vs B/2 units: full scan, spatial hash, per-tick bins\n"
+        "  --bench-hitscan S S shots per frame: flying projectiles vs hitscan\n"
+        "  --bench-blast N N grenade blasts: every-unit loop vs the explosion service\n"
+        "  --trace FILE   write a Chrome trace of the last events (needs SIM_PROFILE=1)\n"
+        "  --help\n", exe);
+}
+
+static void printProfile(long long frames, const char* tracePath)
+{
+#if SIM_PROFILE
+    using namespace Simulation::Profiler;
+    std::printf("%-16s %12s %12s %12s\n", "zone", "total ms", "ms/frame", "calls/frame");
+    for (int z = 0; z < ZONE_COUNT; ++z) {
+        double ms = 0.0; uint64_t calls = 0;
+        Totals((Zone)z, ms, calls);
+        if (calls == 0) continue;
+        std::printf("%-16s %12.1f %12.4f %12.2f\n", ZoneName((Zone)z), ms,
+            frames > 0 ? ms / frames : 0.0, frames > 0 ? (double)calls / frames : 0.0);
+    }
+    if (tracePath) {
+        if (WriteChromeTrace(tracePath)) std::printf("trace written to %s\n", tracePath);
+        else std::fprintf(stderr, "could not write %s\n", tracePath);
+    }
+#else
+    (void)frames;
+    if (tracePath) std::fprintf(stderr, "--trace ignored: built without SIM_PROFILE\n");
+#endif
+}
+
+static void printOutcome(const Simulation::MatchResult& r)
+{
+    if (r.decided)
+        std::printf("outcome: %s wins at frame %d (alive blue=%d orange=%d)\n",
+            r.winner == Definitions::Team::Blue ? "Blue" : "Orange", r.frames, r.aliveBlue, r.aliveOrange);
+    else
+        std::printf("outcome: no winner after %d frames (alive blue=%d orange=%d)\n", r.frames, r.aliveBlue, r.aliveOrange);
+}
+
+int main(int argc, char** argv)
+{
+    int maxFrames = 20000;
+    unsigned seed = (unsigned)std::time(nullptr);
+    int matches = 1;
+    int threads = (int)std::thread::hardware_concurrency();
+    bool verbose = false;
+    const char* tracePath = nullptr;
+    int benchPath = 0;
+    int benchFlow = 0;
+    int pathWorkers = 0;
+    int pathBudget = Definitions::PATH_NODE_BUDGET;
+    int benchJobs = 0;
+    int benchQueue = 0;
+    int benchKernel = 0;
+    int benchTerrain = 0;
+    int benchCover = 0;
+    int benchFov = 0;
+    int benchUnits = 0;
+    int benchBullets = 0;
+    int benchHits = 0;
+    int benchHitscan = 0;
+    int benchBlast = 0;
+    bool projectiles = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (!std::strcmp(a, "--frames") && i + 1 < argc)       maxFrames = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--seed") && i + 1 < argc)    seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(a, "--matches") && i + 1 < argc) matches = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--threads") && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--path-workers") && i + 1 < argc) pathWorkers = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--path-budget") && i + 1 < argc) pathBudget = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-path") && i + 1 < argc) benchPath = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-flow") && i + 1 < argc) benchFlow = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-jobs") && i + 1 < argc) benchJobs = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-queue") && i + 1 < argc) benchQueue = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-kernel") && i + 1 < argc) benchKernel = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-terrain") && i + 1 < argc) benchTerrain = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-cover") && i + 1 < argc) benchCover = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-fov") && i + 1 < argc) benchFov = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-units") && i + 1 < argc) benchUnits = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-bullets") && i + 1 < argc) benchBullets = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-hits") && i + 1 < argc) benchHits = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-hitscan") && i + 1 < argc) benchHitscan = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--bench-blast") && i + 1 < argc) benchBlast = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--projectiles"))             projectiles = true;
+        else if (!std::strcmp(a, "--trace") && i + 1 < argc)   tracePath = argv[++i];
+        else if (!std::strcmp(a, "--verbose"))                 verbose = true;
+        else if (!std::strcmp(a, "--help") || !std::strcmp(a, "-h")) { usage(argv[0]); return 0; }
+        else { std::fprintf(stderr, "Unknown option: %s\n", a); usage(argv[0]); return 2; }
+    }
+    if (maxFrames <= 0) maxFrames = 1;
+    if (matches <= 0) matches = 1;
+    if (threads <= 0) threads = 1;
+
+    Definitions::LogEnabled() = verbose;
+    AI::Pathfinding::PathJobQueue::SetDefaultWorkers(pathWorkers);
+    // Batch runs do not draw anything in flight.
+    Combat::System::SetDefaultHitscan(!projectiles);
+    AI::Pathfinding::PathJobQueue::SetDefaultNodeBudget(pathBudget);
+
+    if (benchPath > 0) return Simulation::BenchPathfinding(seed, benchPath);
+    if (benchFlow > 0) return Simulation::BenchFlowField(seed, benchFlow);
+    if (benchJobs > 0) return Simulation::BenchPathJobs(seed, benchJobs, pathWorkers);
+    if (benchQueue > 0) return Simulation::BenchOpenSet(seed, benchQueue);
+    if (benchKernel > 0) return Simulation::BenchGridKernels(seed, benchKernel);
+    if (benchTerrain > 0) return Simulation::BenchTerrain(seed, benchTerrain);
+    if (benchCover > 0) return Simulation::BenchCoverField(seed, benchCover);
+    if (benchFov > 0) return Simulation::BenchFieldOfView(seed, benchFov);
+    if (benchUnits > 0) return Simulation::BenchSpatialHash(seed, benchUnits);
+    if (benchBullets > 0) return Simulation::BenchProjectiles(seed, benchBullets);
+    if (benchHits > 0) return Simulation::BenchBulletHits(seed, benchHits);
+    if (benchHitscan > 0) return Simulation::BenchHitscan(seed, benchHitscan);
+    if (benchBlast > 0) return Simulation::BenchExplosions(seed, benchBlast);
+    if (matches == 1) {
+        const auto r = Simulation::RunMatches(1, 1, maxFrames, seed)[0];
+        std::printf("seed=%u frames=%d time=%.3fs ticks/sec=%.0f checksum=%016llx\n",
+            seed, r.frames, r.seconds, r.seconds > 0.0 ? r.frames / r.seconds : 0.0,
+            (unsigned long long)r.checksum);
+        printOutcome(r);
+        std::printf("path jobs: %llu delivered, %llu suspensions, %llu partial\n",
+            (unsigned long long)r.pathJobs, (unsigned long long)r.pathSuspended, (unsigned long long)r.pathPartial);
+        std::printf("projectiles: %llu dropped with the pool full\n", (unsigned long long)r.droppedShots);
+        printProfile(r.frames, tracePath);
+        return 0;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto results = Simulation::RunMatches(matches, threads, maxFrames, seed);
+    const auto t1 = std::chrono::steady_clock::now();
+    const double wall = std::chrono::duration<double>(t1 - t0).count();
+
+    long long totalFrames = 0;
+    unsigned long long dropped = 0;
+    int blueWins = 0, orangeWins = 0, undecided = 0;
+    for (const auto& r : results) {
+        std::printf("match %d seed=%u checksum=%016llx: ", r.index, r.seed, (unsigned long long)r.checksum);
+        printOutcome(r);
+        totalFrames += r.frames;
+        dropped += r.droppedShots;
+        if (!r.decided) ++undecided;
+        else if (r.winner == Definitions::Team::Blue) ++blueWins;
+        else ++orangeWins;
+    }
+
+    std::printf("seed=%u matches=%d threads=%d frames=%lld time=%.3fs ticks/sec=%.0f\n",
+        seed, matches, threads < matches ? threads : matches, totalFrames, wall,
+        wall > 0.0 ? totalFrames / wall : 0.0);
+    std::printf("wins: blue=%d orange=%d undecided=%d\n", blueWins, orangeWins, undecided);
+    std::printf("projectiles: %llu dropped with the pool full\n", dropped);
+    printProfile(totalFrames, tracePath);
+    return 0;
+}
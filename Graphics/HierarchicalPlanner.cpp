@@ -0,0 +1,318 @@
+#include "HierarchicalPlanner.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "Units.h"
+#include "World.h"
+#include "Profiler.h"
+
+using namespace Definitions;
+
+namespace AI {
+    namespace Pathfinding {
+
+        namespace {
+            constexpr float INF = std::numeric_limits<float>::infinity();
+
+            // Runs shorter than this get one entrance in the middle, longer
+            // ones get one at each end.
+            constexpr int LONG_ENTRANCE = 6;
+
+            struct OpenCmp {
+                bool operator()(const PathfinderContext::Node& a, const PathfinderContext::Node& b) const { return a.f > b.f; }
+            };
+
+            inline int toIdx(int r, int c) { return r * GRID_SIZE + c; }
+
+            inline float manhattan(int a, int b) {
+                return (float)(std::abs(a / GRID_SIZE - b / GRID_SIZE) + std::abs(a % GRID_SIZE - b % GRID_SIZE));
+            }
+        }
+
+        HierarchicalPlanner::HierarchicalPlanner()
+            : m_clusters(CLUSTERS),
+            m_nodeSlot(N * N, -1),
+            m_walkable(N * N, 0),
+            m_clusterRisk(CLUSTERS, 0.0f),
+            m_local(N * N, -1),
+            m_localQueue(CS * CS)
+        {
+        }
+
+        int HierarchicalPlanner::nodeCount() const {
+            int n = 0;
+            for (const auto& cl : m_clusters) n += (int)cl.nodes.size();
+            return n;
+        }
+
+        void HierarchicalPlanner::localDistances(const Models::Grid& grid, int k, int cell) {
+            const int r0 = (k / CLUSTERS_PER_SIDE) * CS, c0 = (k % CLUSTERS_PER_SIDE) * CS;
+            const int r1 = std::min(N, r0 + CS), c1 = std::min(N, c0 + CS);
+            for (int r = r0; r < r1; ++r)
+                std::fill(m_local.begin() + toIdx(r, c0), m_local.begin() + toIdx(r, c1), -1);
+
+            if (!grid.walkable(cell / N, cell % N)) return;
+
+            int head = 0, tail = 0;
+            m_localQueue[tail++] = cell;
+            m_local[cell] = 0;
+            const int dr[4] = { +1,-1,0,0 };
+            const int dc[4] = { 0,0,+1,-1 };
+            while (head < tail) {
+                const int u = m_localQueue[head++];
+                const int ur = u / N, uc = u % N;
+                for (int d = 0; d < 4; ++d) {
+                    const int nr = ur + dr[d], nc = uc + dc[d];
+                    if (nr < r0 || nr >= r1 || nc < c0 || nc >= c1) continue;
+                    const int n = toIdx(nr, nc);
+                    if (m_local[n] >= 0 || !m_walkable[n]) continue;
+                    m_local[n] = m_local[u] + 1;
+                    m_localQueue[tail++] = n;
+                }
+            }
+        }
+
+        void HierarchicalPlanner::rebuildCluster(const Models::Grid& grid, int k) {
+            Cluster& cl = m_clusters[k];
+            for (int cell : cl.nodes) m_nodeSlot[cell] = -1;
+            cl.nodes.clear();
+            cl.cross.clear();
+
+            const int r0 = (k / CLUSTERS_PER_SIDE) * CS, c0 = (k % CLUSTERS_PER_SIDE) * CS;
+            const int r1 = std::min(N, r0 + CS) - 1, c1 = std::min(N, c0 + CS) - 1;
+
+            auto addNode = [&](int cell) {
+                if (m_nodeSlot[cell] < 0) {
+                    m_nodeSlot[cell] = (int)cl.nodes.size();
+                    cl.nodes.push_back(cell);
+                }
+                return m_nodeSlot[cell];
+            };
+
+            // Walks one border; (inR,inC) is the first inside cell, (stepR,stepC)
+            // moves along the border and (outR,outC) is the offset across it.
+            // Both clusters sharing a border scan the same cell pairs in the
+            // same order, so they agree on where the entrances are.
+            auto scanBorder = [&](int inR, int inC, int stepR, int stepC, int len, int outR, int outC) {
+                int runStart = -1;
+                for (int i = 0; i <= len; ++i) {
+                    bool open = false;
+                    if (i < len) {
+                        const int r = inR + stepR * i, c = inC + stepC * i;
+                        open = m_walkable[toIdx(r, c)] && m_walkable[toIdx(r + outR, c + outC)];
+                    }
+                    if (open && runStart < 0) runStart = i;
+                    if (!open && runStart >= 0) {
+                        const int a = runStart, b = i - 1;
+                        int picks[2] = { (a + b) / 2, -1 };
+                        if (b - a + 1 >= LONG_ENTRANCE) { picks[0] = a; picks[1] = b; }
+                        for (int p : picks) {
+                            if (p < 0) continue;
+                            const int r = inR + stepR * p, c = inC + stepC * p;
+                            const int local = addNode(toIdx(r, c));
+                            cl.cross.push_back(local);
+                            cl.cross.push_back(toIdx(r + outR, c + outC));
+                        }
+                        runStart = -1;
+                    }
+                }
+                };
+
+            if (r0 > 0)     scanBorder(r0, c0, 0, 1, c1 - c0 + 1, -1, 0);
+            if (r1 < N - 1) scanBorder(r1, c0, 0, 1, c1 - c0 + 1, +1, 0);
+            if (c0 > 0)     scanBorder(r0, c0, 1, 0, r1 - r0 + 1, 0, -1);
+            if (c1 < N - 1) scanBorder(r0, c1, 1, 0, r1 - r0 + 1, 0, +1);
+
+            const int n = (int)cl.nodes.size();
+            cl.dist.assign((size_t)n * n, INF);
+            for (int i = 0; i < n; ++i) {
+                localDistances(grid, k, cl.nodes[i]);
+                for (int j = 0; j < n; ++j) {
+                    const int s = m_local[cl.nodes[j]];
+                    if (s >= 0) cl.dist[(size_t)i * n + j] = (float)s;
+                }
+            }
+            ++m_clustersRebuilt;
+        }
+
+        void HierarchicalPlanner::sync(const Models::Grid& grid) {
+            if (grid.revision() == m_gridRevision) return;
+            const bool full = (m_gridRevision == 0);
+            m_gridRevision = grid.revision();
+
+            std::vector<uint8_t> dirty(CLUSTERS, full ? 1 : 0);
+            for (int r = 0; r < N; ++r) {
+                for (int c = 0; c < N; ++c) {
+                    const uint8_t w = grid.walkable(r, c) ? 1 : 0;
+                    const int i = toIdx(r, c);
+                    if (w == m_walkable[i]) continue;
+                    m_walkable[i] = w;
+                    // A changed cell can open or close entrances on any border
+                    // of its cluster, so the neighbours are rebuilt too.
+                    const int cr = r / CS, cc = c / CS;
+                    dirty[clusterOf(r, c)] = 1;
+                    if (cr > 0)                     dirty[(cr - 1) * CLUSTERS_PER_SIDE + cc] = 1;
+                    if (cr < CLUSTERS_PER_SIDE - 1) dirty[(cr + 1) * CLUSTERS_PER_SIDE + cc] = 1;
+                    if (cc > 0)                     dirty[cr * CLUSTERS_PER_SIDE + cc - 1] = 1;
+                    if (cc < CLUSTERS_PER_SIDE - 1) dirty[cr * CLUSTERS_PER_SIDE + cc + 1] = 1;
+                }
+            }
+            for (int k = 0; k < CLUSTERS; ++k)
+                if (dirty[k]) rebuildCluster(grid, k);
+
+            m_riskVersion = 0;
+        }
+
+        void HierarchicalPlanner::refreshRisk(const Simulation::SecurityMap& smap) {
+            if (smap.version() == m_riskVersion) return;
+            m_riskVersion = smap.version();
+
+            const auto& norm = smap.normalized();
+            for (int k = 0; k < CLUSTERS; ++k) {
+                const int r0 = (k / CLUSTERS_PER_SIDE) * CS, c0 = (k % CLUSTERS_PER_SIDE) * CS;
+                const int r1 = std::min(N, r0 + CS), c1 = std::min(N, c0 + CS);
+                float sum = 0.0f; int cnt = 0;
+                for (int r = r0; r < r1; ++r)
+                    for (int c = c0; c < c1; ++c)
+                        if (m_walkable[toIdx(r, c)]) { sum += norm[r][c]; ++cnt; }
+                m_clusterRisk[k] = cnt ? sum / cnt : 0.0f;
+            }
+        }
+
+        bool HierarchicalPlanner::abstractSearch(PathfinderContext& ctx, const Models::Grid& grid,
+            int startIdx, int goalIdx, float riskWeight, Path& waypoints)
+        {
+            const int sk = clusterOf(startIdx / N, startIdx % N);
+            const int gk = clusterOf(goalIdx / N, goalIdx % N);
+
+            localDistances(grid, sk, startIdx);
+            const Cluster& sc = m_clusters[sk];
+            m_startDist.resize(sc.nodes.size());
+            for (size_t i = 0; i < sc.nodes.size(); ++i) m_startDist[i] = m_local[sc.nodes[i]];
+
+            localDistances(grid, gk, goalIdx);
+            const Cluster& gc = m_clusters[gk];
+            m_goalDist.resize(gc.nodes.size());
+            for (size_t i = 0; i < gc.nodes.size(); ++i) m_goalDist[i] = m_local[gc.nodes[i]];
+
+            auto stepCost = [&](int k) { return 1.0f + riskWeight * m_clusterRisk[k]; };
+
+            ctx.beginSearch();
+            std::vector<PathfinderContext::Node>& open = ctx.heap();
+            const OpenCmp cmp;
+
+            auto relax = [&](int from, int to, float g) {
+                if (ctx.closed(to) || g >= ctx.gScore(to)) return;
+                ctx.open(to, g, from);
+                open.push_back({ g + manhattan(to, goalIdx), g, to });
+                std::push_heap(open.begin(), open.end(), cmp);
+                };
+
+            ctx.open(startIdx, 0.0f, -1);
+            open.push_back({ manhattan(startIdx, goalIdx), 0.0f, startIdx });
+
+            bool found = false;
+            while (!open.empty()) {
+                std::pop_heap(open.begin(), open.end(), cmp);
+                const PathfinderContext::Node cur = open.back();
+                open.pop_back();
+
+                if (ctx.closed(cur.idx)) continue;
+                ctx.close(cur.idx);
+                if (cur.idx == goalIdx) { found = true; break; }
+
+                const int u = cur.idx;
+                const float g = ctx.gScore(u);
+
+                if (u == startIdx) {
+                    const float m = stepCost(sk);
+                    for (size_t i = 0; i < sc.nodes.size(); ++i)
+                        if (m_startDist[i] > 0) relax(u, sc.nodes[i], g + m_startDist[i] * m);
+                }
+
+                const int li = m_nodeSlot[u];
+                if (li < 0) continue;
+
+                const int k = clusterOf(u / N, u % N);
+                const Cluster& cl = m_clusters[k];
+                const int n = (int)cl.nodes.size();
+                const float m = stepCost(k);
+
+                for (int j = 0; j < n; ++j) {
+                    const float d = cl.dist[(size_t)li * n + j];
+                    if (j != li && d < INF) relax(u, cl.nodes[j], g + d * m);
+                }
+                for (size_t e = 0; e + 1 < cl.cross.size(); e += 2) {
+                    if (cl.cross[e] != li) continue;
+                    const int v = cl.cross[e + 1];
+                    relax(u, v, g + stepCost(clusterOf(v / N, v % N)));
+                }
+                if (k == gk && m_goalDist[li] >= 0) relax(u, goalIdx, g + m_goalDist[li] * m);
+            }
+
+            if (!found) return false;
+            return ctx.reconstruct(startIdx, goalIdx, waypoints);
+        }
+
+        bool HierarchicalPlanner::findPath(PathfinderContext& ctx,
+            const Models::Unit* pathingUnit,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out)
+        {
+            if (!pathingUnit) { out.clear(); return false; }
+            return findPath(ctx, &pathingUnit->world->occupancy, pathingUnit->id,
+                grid, smap, start, goal, riskWeight, out);
+        }
+
+        bool HierarchicalPlanner::findPath(PathfinderContext& ctx,
+            const Simulation::OccupancyGrid* occ, int pathingUnitId,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out,
+            bool flatFallback)
+        {
+            out.clear();
+            if (start.first < 0 || start.first >= N || start.second < 0 || start.second >= N) return false;
+            if (goal.first < 0 || goal.first >= N || goal.second < 0 || goal.second >= N) return false;
+            if (!grid.walkable(goal.first, goal.second)) return false;
+
+            sync(grid);
+
+            const int startIdx = toIdx(start.first, start.second);
+            const int goalIdx = toIdx(goal.first, goal.second);
+            if (clusterOf(start.first, start.second) == clusterOf(goal.first, goal.second))
+                return flatFallback && AStar_FindPath(ctx, occ, pathingUnitId, grid, smap, start, goal, riskWeight, out);
+
+            refreshRisk(smap);
+
+            bool ok;
+            {
+                SIM_PROFILE_ZONE(HpaAbstract);
+                ok = abstractSearch(ctx, grid, startIdx, goalIdx, riskWeight, m_waypoints);
+            }
+            if (ok) {
+                out.push_back(m_waypoints.front());
+                for (size_t i = 1; i < m_waypoints.size() && ok; ++i) {
+                    const Cell a = m_waypoints[i - 1], b = m_waypoints[i];
+                    if (std::abs(a.first - b.first) + std::abs(a.second - b.second) == 1) {
+                        out.push_back(b);
+                        continue;
+                    }
+                    ok = AStar_FindPath(ctx, occ, pathingUnitId, grid, smap, a, b, riskWeight, m_segment);
+                    if (ok) out.insert(out.end(), m_segment.begin() + 1, m_segment.end());
+                }
+            }
+            if (!ok) {
+                out.clear();
+                return flatFallback && AStar_FindPath(ctx, occ, pathingUnitId, grid, smap, start, goal, riskWeight, out);
+            }
+            return true;
+        }
+
+    } // namespace Pathfinding
+} // namespace AI
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+#include "SecurityMap.h"
+#include "Pathfinding.h"
+
+namespace Models { class Unit; }
+
+namespace AI {
+    namespace Pathfinding {
+
+        // HPA*: the grid is cut into square clusters; every walkable run along
+        // a cluster border gets one or two entrance cells on each side, and the
+        // walking distance between the entrances of a cluster is cached. A
+        // query plans over that small graph, then refines consecutive
+        // waypoints with the normal A* (so risk and occupancy still apply at
+        // cell level).
+        //
+        // The graph only depends on terrain. It is rebuilt lazily, for the
+        // clusters whose cells changed, the next time a query sees a new
+        // Grid::revision(). Risk enters the abstract search as a per-cluster
+        // multiplier (1 + w * mean normalized risk), refreshed whenever the
+        // SecurityMap version moves.
+        class HierarchicalPlanner {
+        public:
+            static constexpr int CS = Definitions::HPA_CLUSTER_SIZE;
+            static constexpr int N = Definitions::GRID_SIZE;
+            static constexpr int CLUSTERS_PER_SIDE = (N + CS - 1) / CS;
+            static constexpr int CLUSTERS = CLUSTERS_PER_SIDE * CLUSTERS_PER_SIDE;
+
+            HierarchicalPlanner();
+
+            // Same contract as AStar_FindPath. Falls back to flat A* when the
+            // abstract search or a refinement step fails.
+            bool findPath(PathfinderContext& ctx,
+                const Models::Unit* pathingUnit,
+                const Models::Grid& grid,
+                const Simulation::SecurityMap& smap,
+                Cell start, Cell goal,
+                float riskWeight,
+                Path& out);
+
+            // Same, with refinements checked against an explicit occupancy
+            // grid (null = ignore occupancy). With flatFallback off it
+            // returns false wherever it would otherwise run a full flat A*
+            // (same cluster, or abstract search failed), leaving that search
+            // to the caller.
+            bool findPath(PathfinderContext& ctx,
+                const Simulation::OccupancyGrid* occ, int pathingUnitId,
+                const Models::Grid& grid,
+                const Simulation::SecurityMap& smap,
+                Cell start, Cell goal,
+                float riskWeight,
+                Path& out,
+                bool flatFallback = true);
+
+            // Brings the graph up to date with `grid` (normally done on demand).
+            void sync(const Models::Grid& grid);
+
+            int nodeCount() const;
+            int clustersRebuilt() const { return m_clustersRebuilt; }
+
+        private:
+            struct Cluster {
+                std::vector<int>   nodes;  // cell index of every entrance
+                std::vector<float> dist;   // nodes.size()^2 walking distances (inf = none)
+                std::vector<int>   cross;  // pairs (local node, cell across the border)
+            };
+
+            static inline int clusterOf(int r, int c) { return (r / CS) * CLUSTERS_PER_SIDE + (c / CS); }
+
+            void rebuildCluster(const Models::Grid& grid, int k);
+            void refreshRisk(const Simulation::SecurityMap& smap);
+
+            // BFS inside cluster k from `cell`; writes steps into m_local.
+            void localDistances(const Models::Grid& grid, int k, int cell);
+
+            bool abstractSearch(PathfinderContext& ctx, const Models::Grid& grid,
+                int startIdx, int goalIdx, float riskWeight, Path& waypoints);
+
+            std::vector<Cluster> m_clusters;
+            std::vector<int>     m_nodeSlot;    // cell -> local node index in its cluster, or -1
+            std::vector<uint8_t> m_walkable;    // walkability the graph was built from
+            std::vector<float>   m_clusterRisk; // mean normalized risk per cluster
+            std::vector<int>     m_startDist;   // steps from the start to its cluster's nodes
+            std::vector<int>     m_goalDist;    // steps from the goal cluster's nodes to the goal
+            std::vector<int>     m_local;       // BFS scratch, steps per cell (-1 = unseen)
+            std::vector<int>     m_localQueue;
+            Path                 m_waypoints;
+            Path                 m_segment;
+
+            uint32_t m_gridRevision = 0;
+            uint32_t m_riskVersion = 0;
+            int      m_clustersRebuilt = 0;
+        };
+
+    } // namespace Pathfinding
+} // namespace AI
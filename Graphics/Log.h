@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdio>
+
+namespace Definitions {
+
+    // Gate for the per-unit / per-order console chatter. On by default; the
+    // headless runner turns it off unless asked to be verbose.
+    inline bool& LogEnabled() {
+        static bool enabled = true;
+        return enabled;
+    }
+
+} // namespace Definitions
+
+#define SIM_LOG(...) do { if (Definitions::LogEnabled()) std::printf(__VA_ARGS__); } while (0)
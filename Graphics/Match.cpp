@@ -0,0 +1,363 @@
+#include "Match.h"
+#include <map>
+#include <cstdlib>
+
+#include "Grid.h"
+#include "SecurityMap.h"
+#include "Combat.h"
+#include "Pathfinding.h"
+#include "Perception.h"
+#include "World.h"
+#include "Warrior.h"
+#include "EventBus.h"
+#include "AIEvents.h"
+#include "StateMachine.h"
+#include "Log.h"
+#include "Profiler.h"
+
+using namespace Definitions;
+
+namespace Simulation {
+
+    static inline const char* teamTag(Team t) {
+        return (t == Team::Blue) ? "Blue" : "Orange";
+    }
+
+    // Random & anchors respecting playfield
+    static inline bool inHalf(Definitions::Team t, int c) {
+        return (t == Definitions::Team::Blue) ? (c < GRID_SIZE / 2) : (c >= GRID_SIZE / 2);
+    }
+
+    // Spawns and anchors stay in the largest walkable region, never in a
+    // pocket enclosed by rock or water.
+    static bool isSpawnableCell(const World& world, int r, int c)
+    {
+        if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) return false;
+        if (!AI::Pathfinding::inPlayfield(r, c)) return false;
+        if (!world.grid.walkable(r, c)) return false;
+        if (world.connectivity.label(r, c) != world.connectivity.mainLabel()) return false;
+        if (AI::Pathfinding::IsOccupied(world.occupancy, r, c)) return false;
+        return true;
+    }
+
+    static bool randomFreeCellInHalf(const World& world, Rng& rng, Definitions::Team team, int& outR, int& outC)
+    {
+        const int tries = 500;
+        for (int k = 0; k < tries; ++k) {
+            int r = rng.below(GRID_SIZE);
+            int c = rng.below(GRID_SIZE);
+            if (!AI::Pathfinding::inPlayfield(r, c)) continue;
+            if (!inHalf(team, c)) continue;
+            if (!world.grid.walkable(r, c)) continue;
+            if (world.connectivity.label(r, c) != world.connectivity.mainLabel()) continue;
+            if (AI::Pathfinding::IsOccupied(world.occupancy, r, c)) continue;
+            outR = r; outC = c;
+            return true;
+        }
+        return false;
+    }
+
+    static bool selectAnchorForTeam(const World& world, Rng& rng, Definitions::Team team, int& outR, int& outC)
+    {
+        const int tries = AI::Commander::ANCHOR_RETRIES;
+        const float safeMax = AI::Commander::SAFE_RISK_MAX;
+        int bestR = -1, bestC = -1; float bestRisk = 1e9f;
+
+        for (int k = 0; k < tries; ++k) {
+            int r = rng.below(GRID_SIZE);
+            int c = rng.below(GRID_SIZE);
+            if (!isSpawnableCell(world, r, c)) continue;
+            if (!inHalf(team, c)) continue;
+            float risk = world.smap.at(r, c);
+            if (risk <= safeMax && risk < bestRisk) {
+                bestRisk = risk; bestR = r; bestC = c;
+                if (bestRisk <= 0.05f) break;
+            }
+        }
+        if (bestR < 0) {
+            for (int k = 0; k < tries; ++k) {
+                int r = rng.below(GRID_SIZE);
+                int c = rng.below(GRID_SIZE);
+                if (!isSpawnableCell(world, r, c)) continue;
+                if (!inHalf(team, c)) continue;
+                float risk = world.smap.at(r, c);
+                if (risk < bestRisk) { bestRisk = risk; bestR = r; bestC = c; }
+            }
+        }
+        if (bestR >= 0) { outR = bestR; outC = bestC; return true; }
+        return false;
+    }
+
+    static void placeFirstByRole(World& world, Definitions::Team team, Definitions::Role role, int r, int c)
+    {
+        for (auto* u : world.units) {
+            if (!u->isAlive) continue;
+            if (u->team == team && u->role == role) {
+                if (!AI::Pathfinding::IsOccupied(world.occupancy, r, c)) {
+                    u->moveTo(r, c); u->isMoving = false;
+                }
+                break;
+            }
+        }
+    }
+
+    static void sanitizeWorldOutsidePlayfield(Models::Grid& grid)
+    {
+        const int EMPTY_CELL = Definitions::Cell::EMPTY;
+        for (int r = 0; r < GRID_SIZE; ++r) {
+            for (int c = 0; c < GRID_SIZE; ++c) {
+                if (AI::Pathfinding::inPlayfield(r, c)) continue;
+                int v = grid.at(r, c);
+                if (v == ROCK || v == TREE || v == DEPOT_AMMO || v == DEPOT_MED || v == WATER) {
+                    grid.set(r, c, EMPTY_CELL);
+                }
+            }
+        }
+    }
+
+    Match::Match() {}
+
+    void Match::randomizeAllWarriorsInTeams()
+    {
+        if (!m_randomizeWarriorsSpawn) return;
+        m_randBlueWarriorId = -1;
+        m_randOrangeWarriorId = -1;
+
+        for (auto* u : m_world.units) {
+            if (!u->isAlive || u->role != Role::Warrior) continue;
+            int r, c;
+            if (randomFreeCellInHalf(m_world, m_world.rng.spawn, u->team, r, c)) {
+                u->moveTo(r, c); u->isMoving = false;
+                if (u->team == Team::Blue && m_randBlueWarriorId == -1)   m_randBlueWarriorId = u->id;
+                if (u->team == Team::Orange && m_randOrangeWarriorId == -1) m_randOrangeWarriorId = u->id;
+            }
+        }
+    }
+
+    void Match::autoEnemySightings(const std::vector<Models::Unit*>& blueTeam,
+        const std::vector<Models::Unit*>& orangeTeam)
+    {
+        if (m_frameCounter % 15 != 0) return;
+
+        auto& seen = m_seen;
+        auto reportLOS = [&](const std::vector<Models::Unit*>& mine)
+            {
+                for (auto* me : mine) {
+                    if (!me || !me->isAlive) continue;
+                    m_world.perception.visibleEnemies(*me, seen);
+                    if (seen.empty()) continue;
+
+                    m_world.bus.publish(AI::Message{
+                        AI::EventType::EnemySighted,
+                        me->id, -1, seen.front().row, seen.front().col, 0
+                        });
+                }
+            };
+
+        reportLOS(blueTeam);
+        reportLOS(orangeTeam);
+    }
+
+    void Match::buildTestWorld(uint32_t seed)
+    {
+        m_world.clearUnits();
+        m_world.seed = seed;
+        m_world.rng.seed(seed);
+        m_world.frame = 0;
+        m_world.flow.clear();
+
+        m_world.grid = Models::Grid(m_world.rng.map);
+        sanitizeWorldOutsidePlayfield(m_world.grid);
+        m_world.connectivity.sync(m_world.grid);
+        m_world.cover.sync(m_world.grid);
+
+        const int rowBlue = GRID_SIZE / 6;
+        const int startBlue = GRID_SIZE / 10;
+        const int step = 3;
+
+        m_world.commanderBlue.reset();
+        m_world.commanderOrange.reset();
+
+        m_world.units.reserve(10);
+
+        m_world.units.push_back(new Models::Unit(m_world, Team::Blue, Role::Commander, rowBlue, startBlue + step * 0));
+
+        m_world.units.push_back(new Models::Warrior(m_world, Team::Blue, rowBlue, startBlue + step * 1));
+
+        m_world.units.push_back(new Models::Unit(m_world, Team::Blue, Role::Medic, rowBlue, startBlue + step * 2));
+        m_world.units.push_back(new Models::Unit(m_world, Team::Blue, Role::Supplier, rowBlue, startBlue + step * 3));
+
+        m_world.units.push_back(new Models::Warrior(m_world, Team::Blue, rowBlue, startBlue + step * 4));
+
+        const int rowOrange = GRID_SIZE - GRID_SIZE / 6;
+        const int startOrange = GRID_SIZE - GRID_SIZE / 10;
+        m_world.units.push_back(new Models::Unit(m_world, Team::Orange, Role::Commander, rowOrange, startOrange - step * 0));
+        m_world.units.push_back(new Models::Warrior(m_world, Team::Orange, rowOrange, startOrange - step * 1));
+        m_world.units.push_back(new Models::Unit(m_world, Team::Orange, Role::Medic, rowOrange, startOrange - step * 2));
+        m_world.units.push_back(new Models::Unit(m_world, Team::Orange, Role::Supplier, rowOrange, startOrange - step * 3));
+        m_world.units.push_back(new Models::Warrior(m_world, Team::Orange, rowOrange, startOrange - step * 4));
+
+        int nextUnitId = 1;
+        for (auto* u : m_world.units) {
+            u->id = nextUnitId++;
+            u->isMoving = false;
+            u->isFighting = false;
+            u->isAutonomous = false;
+            u->isAlive = true;
+            if (u->team == Team::Blue) {
+                if (u->role == Role::Commander) m_world.commanderBlue.setUnitId(u->id);
+            }
+            else {
+                if (u->role == Role::Commander) m_world.commanderOrange.setUnitId(u->id);
+            }
+        }
+
+        m_world.occupancy.rebuild(m_world.units);
+        m_world.proximity.rebuild(m_world.units);
+
+        randomizeAllWarriorsInTeams();
+        m_world.smap.RebuildSecurityMap(m_world.grid);
+
+        int ar, ac;
+        m_blueAnchorValid = false;
+        m_orangeAnchorValid = false;
+        if (selectAnchorForTeam(m_world, m_world.rng.spawn, Team::Blue, ar, ac)) {
+            placeFirstByRole(m_world, Team::Blue, Role::Commander, ar, ac);
+            m_world.commanderBlue.anchorR = ar; m_world.commanderBlue.anchorC = ac;
+            m_blueAnchorValid = true;
+        }
+        if (selectAnchorForTeam(m_world, m_world.rng.spawn, Team::Orange, ar, ac)) {
+            placeFirstByRole(m_world, Team::Orange, Role::Commander, ar, ac);
+            m_world.commanderOrange.anchorR = ar; m_world.commanderOrange.anchorC = ac;
+            m_orangeAnchorValid = true;
+        }
+        m_commanderEnabled = false;
+        m_frameCounter = 0;
+
+        m_world.commanderBlue.initSubscriptions();
+        m_world.commanderOrange.initSubscriptions();
+
+        m_gameOver = false;
+    }
+
+    void Match::step()
+    {
+        // Closing the previous frame here also counts whatever the front end
+        // drew since the last step.
+        SIM_PROFILE_END_FRAME();
+        SIM_PROFILE_ZONE(Frame);
+        m_world.frame = m_frameCounter;
+        m_world.flow.setFrame(m_frameCounter);
+        m_world.connectivity.sync(m_world.grid);
+        m_world.cover.sync(m_world.grid);
+
+        if (!m_gameOver) {
+            m_world.combat.tickBullets(m_world.grid, m_world.smap);
+        }
+
+        std::vector<Models::Unit*> liveBlueUnits;
+        std::vector<Models::Unit*> liveOrangeUnits;
+        for (auto* u : m_world.units) {
+            if (u->isAlive) {
+                if (u->team == Team::Blue) {
+                    liveBlueUnits.push_back(u);
+                }
+                else {
+                    liveOrangeUnits.push_back(u);
+                }
+            }
+        }
+
+        struct TeamStatus {
+            Models::Unit* commander = nullptr;
+            bool commanderAlive = false;
+            bool warriorsAlive = false;
+            bool supportsAlive = false;
+        };
+        std::map<Team, TeamStatus> teamStatus;
+
+        for (auto* u : liveBlueUnits) {
+            TeamStatus& st = teamStatus[Team::Blue];
+            if (u->role == Role::Commander) { st.commander = u; st.commanderAlive = true; }
+            else if (u->role == Role::Warrior) { st.warriorsAlive = true; }
+            else if (u->role == Role::Medic || u->role == Role::Supplier) { st.supportsAlive = true; }
+        }
+        for (auto* u : liveOrangeUnits) {
+            TeamStatus& st = teamStatus[Team::Orange];
+            if (u->role == Role::Commander) { st.commander = u; st.commanderAlive = true; }
+            else if (u->role == Role::Warrior) { st.warriorsAlive = true; }
+            else if (u->role == Role::Medic || u->role == Role::Supplier) { st.supportsAlive = true; }
+        }
+
+        if (!m_gameOver) {
+            bool blueWarriorsExist = teamStatus[Team::Blue].warriorsAlive;
+            bool orangeWarriorsExist = teamStatus[Team::Orange].warriorsAlive;
+
+            if (!blueWarriorsExist && orangeWarriorsExist) {
+                m_gameOver = true;
+                m_winningTeam = Team::Orange;
+            }
+            else if (blueWarriorsExist && !orangeWarriorsExist) {
+                m_gameOver = true;
+                m_winningTeam = Team::Blue;
+            }
+        }
+
+        if (!m_gameOver) {
+
+            for (auto& kv : teamStatus) {
+                Team team = kv.first;
+                TeamStatus& status = kv.second;
+                std::vector<Models::Unit*>& teamPtrs = (team == Team::Blue) ? liveBlueUnits : liveOrangeUnits;
+
+                if (!status.commanderAlive && status.warriorsAlive) {
+                    bool changed = false;
+                    for (auto* u : teamPtrs) {
+                        if (u->role == Role::Warrior && !u->isAutonomous) {
+                            u->isAutonomous = true;
+                            changed = true;
+                        }
+                    }
+                    if (changed) SIM_LOG("[CONTINGENCY/%s] Commander down! Warriors autonomous.\n", teamTag(team));
+                }
+                else if (!status.warriorsAlive && status.commanderAlive) {
+                    if (status.commander && !status.commander->isFighting) {
+                        SIM_LOG("[CONTINGENCY/%s] Warriors down! Commander fights.\n", teamTag(team));
+                        status.commander->isFighting = true;
+                    }
+                }
+            }
+
+            {
+                SIM_PROFILE_ZONE(Perception);
+                m_world.perception.rebuild(m_world.grid, m_world.units, SIGHT_RANGE);
+            }
+
+            if (m_commanderEnabled) {
+                autoEnemySightings(liveBlueUnits, liveOrangeUnits);
+                m_world.commanderBlue.tick(m_world.grid, liveBlueUnits, liveOrangeUnits, m_frameCounter);
+                m_world.commanderOrange.tick(m_world.grid, liveOrangeUnits, liveBlueUnits, m_frameCounter);
+            }
+
+            // Searches requested last tick land here, before any state runs.
+            m_world.paths.deliver();
+
+            for (auto* u : m_world.units) {
+                if (u->isAlive) {
+                    if (u->m_fsm) {
+                        u->m_fsm->Update();
+                    }
+                    if (u->role == Definitions::Role::Warrior) {
+                        Models::Warrior* warrior = static_cast<Models::Warrior*>(u);
+                        warrior->CheckAndReportStatus();
+                    }
+                }
+            }
+
+        }
+
+        m_world.paths.dispatch(m_world.grid, m_world.smap, m_world.occupancy);
+        ++m_frameCounter;
+    }
+
+} // namespace Simulation
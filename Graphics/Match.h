@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "Definitions.h"
+#include "Units.h"
+#include "Commander.h"
+#include "World.h"
+
+namespace Simulation {
+
+    // Test-world setup and the per-frame simulation pipeline, shared by the
+    // GLUT front end and the headless runner. Each Match owns its World.
+    class Match {
+    public:
+        Match();
+
+        // Same seed, same map, spawns and outcome.
+        void buildTestWorld(uint32_t seed);
+
+        // One simulation frame: bullets, contingency checks, perception,
+        // commander ticks and FSM updates.
+        void step();
+
+        inline World& world() { return m_world; }
+        inline const World& world() const { return m_world; }
+
+        inline int  frame() const { return m_frameCounter; }
+        inline bool gameOver() const { return m_gameOver; }
+        inline Definitions::Team winner() const { return m_winningTeam; }
+
+        inline bool commanderEnabled() const { return m_commanderEnabled; }
+        inline void setCommanderEnabled(bool on) { m_commanderEnabled = on; }
+
+    private:
+        void randomizeAllWarriorsInTeams();
+        void autoEnemySightings(const std::vector<Models::Unit*>& blueTeam,
+            const std::vector<Models::Unit*>& orangeTeam);
+
+        World m_world;
+        std::vector<AI::Perception::Sighting> m_seen;
+        int  m_frameCounter = 0;
+        bool m_commanderEnabled = false;
+
+        // Random spawn flags/ids (debug)
+        bool m_randomizeWarriorsSpawn = true;
+        int  m_randBlueWarriorId = -1;
+        int  m_randOrangeWarriorId = -1;
+
+        bool m_blueAnchorValid = false;
+        bool m_orangeAnchorValid = false;
+        bool m_gameOver = false;
+        Definitions::Team m_winningTeam = Definitions::Team::Blue;
+    };
+
+} // namespace Simulation
@@ -0,0 +1,88 @@
+#include "MatchRunner.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "Match.h"
+#include "Units.h"
+
+namespace Simulation {
+
+    uint64_t WorldChecksum(const World& world, int frame)
+    {
+        // FNV-1a over the fields that decide the outcome.
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](int v) {
+            for (int b = 0; b < 4; ++b) {
+                h ^= (uint64_t)((uint32_t)v >> (8 * b)) & 0xFFu;
+                h *= 1099511628211ULL;
+            }
+            };
+        mix(frame);
+        for (const auto* u : world.units) {
+            mix(u->id); mix(u->row); mix(u->col); mix(u->isAlive ? 1 : 0);
+            mix(u->stats.hp); mix(u->stats.ammo); mix(u->stats.grenades);
+        }
+        return h;
+    }
+
+    static MatchResult playOne(int index, uint32_t seed, int maxFrames)
+    {
+        MatchResult res;
+        res.index = index;
+        res.seed = seed;
+
+        // World is large (grids, masks, perception tables); keep it off the
+        // worker's stack.
+        std::unique_ptr<Match> match(new Match());
+        match->buildTestWorld(seed);
+        match->setCommanderEnabled(true);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        while (!match->gameOver() && match->frame() < maxFrames) {
+            match->step();
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+
+        res.seconds = std::chrono::duration<double>(t1 - t0).count();
+        res.frames = match->frame();
+        res.decided = match->gameOver();
+        res.winner = match->winner();
+        for (const auto* u : match->world().units) {
+            if (!u->isAlive) continue;
+            if (u->team == Definitions::Team::Blue) ++res.aliveBlue; else ++res.aliveOrange;
+        }
+        res.checksum = WorldChecksum(match->world(), res.frames);
+        const auto& jobs = match->world().paths.stats();
+        res.pathJobs = jobs.solved;
+        res.pathSuspended = jobs.suspended;
+        res.pathPartial = jobs.partial;
+        res.droppedShots = match->world().combat.droppedShots();
+        return res;
+    }
+
+    std::vector<MatchResult> RunMatches(int count, int workers, int maxFrames, uint32_t baseSeed)
+    {
+        std::vector<MatchResult> results(std::max(count, 0));
+        if (results.empty()) return results;
+        workers = std::max(1, std::min(workers, count));
+
+        std::atomic<int> next(0);
+        auto worker = [&]() {
+            for (;;) {
+                const int i = next.fetch_add(1);
+                if (i >= count) break;
+                results[i] = playOne(i, baseSeed + (uint32_t)i, maxFrames);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (int t = 1; t < workers; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& th : pool) th.join();
+        return results;
+    }
+
+} // namespace Simulation
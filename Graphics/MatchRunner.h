@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+
+namespace Simulation {
+
+    class World;
+
+    struct MatchResult {
+        int index = 0;
+        uint32_t seed = 0;
+        int frames = 0;
+        bool decided = false;
+        Definitions::Team winner = Definitions::Team::Blue;
+        int aliveBlue = 0;
+        int aliveOrange = 0;
+        double seconds = 0.0;
+        // Hash of the final unit states; equal seeds must give equal values.
+        uint64_t checksum = 0;
+        // Path job queue counters (PathJobQueue::Stats).
+        uint64_t pathJobs = 0;
+        uint64_t pathSuspended = 0;
+        uint64_t pathPartial = 0;
+        // Projectiles the combat system dropped with its pool full.
+        uint64_t droppedShots = 0;
+    };
+
+    uint64_t WorldChecksum(const World& world, int frame);
+
+    // Plays `count` independent matches on a pool of `workers` threads. Match
+    // i is seeded with baseSeed + i, builds its own World, enables the
+    // commanders and steps until game over or `maxFrames`. Results come back
+    // in match order and do not depend on the number of workers.
+    std::vector<MatchResult> RunMatches(int count, int workers, int maxFrames, uint32_t baseSeed);
+
+} // namespace Simulation
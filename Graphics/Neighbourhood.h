@@ -0,0 +1,40 @@
+#pragma once
+#include "Grid.h"
+
+namespace AI {
+    namespace Pathfinding {
+
+        // Neighbour offsets in Grid's padded layout, fixed at compile time so
+        // search kernels can take the neighbourhood as a template parameter
+        // and unroll the inner loop. Order matches the {+row, -row, +col,
+        // -col} tables the searches used before, so expansion order (and
+        // with it tie-breaking) is unchanged.
+        template <int K>
+        struct Neighbourhood;
+
+        template <>
+        struct Neighbourhood<4> {
+            static constexpr int COUNT = 4;
+            static constexpr int offset(int k) {
+                return k == 0 ? +Models::Grid::STRIDE
+                     : k == 1 ? -Models::Grid::STRIDE
+                     : k == 2 ? +1
+                     : -1;
+            }
+        };
+
+        // The 4-neighbours first, then the diagonals.
+        template <>
+        struct Neighbourhood<8> {
+            static constexpr int COUNT = 8;
+            static constexpr int offset(int k) {
+                return k < 4 ? Neighbourhood<4>::offset(k)
+                     : k == 4 ? +Models::Grid::STRIDE + 1
+                     : k == 5 ? +Models::Grid::STRIDE - 1
+                     : k == 6 ? -Models::Grid::STRIDE + 1
+                     : -Models::Grid::STRIDE - 1;
+            }
+        };
+
+    } // namespace Pathfinding
+} // namespace AI
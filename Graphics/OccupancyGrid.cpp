@@ -0,0 +1,38 @@
+#include "OccupancyGrid.h"
+#include "Units.h"
+
+namespace Simulation {
+
+    OccupancyGrid::OccupancyGrid() { clear(); }
+
+    void OccupancyGrid::clear() {
+        for (auto& team : m_count) team.fill(0);
+        m_idXor.fill(0);
+    }
+
+    void OccupancyGrid::rebuild(const std::vector<Models::Unit*>& units) {
+        clear();
+        for (const auto* u : units) {
+            if (u && u->isAlive) add(*u);
+        }
+    }
+
+    void OccupancyGrid::apply(const Models::Unit& u, int r, int c, int delta) {
+        if (!inBounds(r, c)) return;
+        const int i = idx(r, c);
+        uint16_t& n = m_count[(int)u.team][i];
+        if (delta < 0 && n == 0) return;
+        n = (uint16_t)(n + delta);
+        m_idXor[i] ^= u.id;
+    }
+
+    void OccupancyGrid::add(const Models::Unit& u) { apply(u, u.row, u.col, +1); }
+
+    void OccupancyGrid::remove(const Models::Unit& u) { apply(u, u.row, u.col, -1); }
+
+    void OccupancyGrid::move(const Models::Unit& u, int fromR, int fromC) {
+        apply(u, fromR, fromC, -1);
+        apply(u, u.row, u.col, +1);
+    }
+
+} // namespace Simulation
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+
+namespace Models { class Unit; }
+
+namespace Simulation {
+
+    // Per-cell index of living units. Units may stack on a cell, so each cell
+    // keeps a count per team plus the XOR of the ids standing on it; with a
+    // single occupant the XOR is that unit's id.
+    class OccupancyGrid {
+    public:
+        OccupancyGrid();
+
+        void clear();
+        void rebuild(const std::vector<Models::Unit*>& units);
+
+        void add(const Models::Unit& u);
+        void remove(const Models::Unit& u);
+        void move(const Models::Unit& u, int fromR, int fromC);
+
+        inline int count(int r, int c) const {
+            if (!inBounds(r, c)) return 0;
+            const int i = idx(r, c);
+            return m_count[0][i] + m_count[1][i];
+        }
+
+        inline int countTeam(int r, int c, Definitions::Team team) const {
+            if (!inBounds(r, c)) return 0;
+            return m_count[(int)team][idx(r, c)];
+        }
+
+        inline bool occupied(int r, int c) const { return count(r, c) > 0; }
+
+        inline bool occupiedByTeam(int r, int c, Definitions::Team team) const {
+            return countTeam(r, c, team) > 0;
+        }
+
+        inline bool occupiedByOther(int r, int c, int unitId) const {
+            const int n = count(r, c);
+            if (n == 0) return false;
+            if (n > 1) return true;
+            return m_idXor[idx(r, c)] != unitId;
+        }
+
+        // Id of the only unit on the cell, or -1 if it is empty or shared.
+        inline int soleOccupant(int r, int c) const {
+            return (count(r, c) == 1) ? m_idXor[idx(r, c)] : -1;
+        }
+
+    private:
+        static constexpr int N = Definitions::GRID_SIZE;
+
+        static inline bool inBounds(int r, int c) { return r >= 0 && r < N && c >= 0 && c < N; }
+        static inline int  idx(int r, int c) { return r * N + c; }
+
+        void apply(const Models::Unit& u, int r, int c, int delta);
+
+        std::array<std::array<uint16_t, N * N>, 2> m_count{};
+        std::array<int, N * N> m_idXor{};
+    };
+
+} // namespace Simulation
@@ -0,0 +1,280 @@
+#include "PathJobs.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include "Units.h"
+#include "World.h"
+#include "Profiler.h"
+
+using namespace Definitions;
+
+namespace AI {
+    namespace Pathfinding {
+
+        static std::atomic<int> s_defaultWorkers{ 0 };
+        static std::atomic<int> s_defaultBudget{ PATH_NODE_BUDGET };
+
+        void PathJobQueue::SetDefaultWorkers(int n) { s_defaultWorkers = std::max(0, n); }
+        void PathJobQueue::SetDefaultNodeBudget(int nodes) { s_defaultBudget = std::max(0, nodes); }
+
+        PathJobQueue::PathJobQueue() {
+            setNodeBudget(s_defaultBudget);
+            setWorkers(s_defaultWorkers);
+        }
+
+        PathJobQueue::~PathJobQueue() {
+            waitBatch();
+            stopWorkers();
+        }
+
+        void PathJobQueue::setWorkers(int n) {
+            n = std::max(0, n);
+            if (n == (int)m_workers.size()) return;
+            waitBatch();
+            stopWorkers();
+            for (int i = 0; i < n; ++i) {
+                m_workers.emplace_back(new Worker());
+                Worker& w = *m_workers.back();
+                w.batch = m_batch;
+                w.thread = std::thread([this, &w] { workerLoop(w); });
+            }
+        }
+
+        void PathJobQueue::stopWorkers() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& w : m_workers) w->thread.join();
+            m_workers.clear();
+            m_stop = false;
+        }
+
+        Ticket PathJobQueue::request(const Models::Unit* unit, Cell goal, Planner planner) {
+            if (!unit) return 0;
+            return request(unit, { unit->row, unit->col }, goal, planner);
+        }
+
+        Ticket PathJobQueue::request(const Models::Unit* unit, Cell start, Cell goal, Planner planner) {
+            if (!unit || !unit->world) return 0;
+            Simulation::World& world = *unit->world;
+            const Ticket t = m_nextTicket++;
+            if (m_nextTicket == 0) m_nextTicket = 1;
+
+            if (world.connectivity.unreachable(start.first, start.second, goal.first, goal.second)) {
+                Result res;
+                res.ticket = t;
+                m_ready.push_back(std::move(res));
+                return t;
+            }
+            if ((planner == Planner::Auto && world.isSharedGoal(goal.first, goal.second)) || planner == Planner::FlowField) {
+                Result res;
+                res.ticket = t;
+                res.ok = world.flow.extractPath(world.grid, world.smap, start, goal, res.path);
+                if (res.ok || planner == Planner::FlowField) {
+                    m_ready.push_back(std::move(res));
+                    return t;
+                }
+            }
+            if (planner == Planner::Auto || planner == Planner::FlowField) {
+                const int d = std::abs(start.first - goal.first) + std::abs(start.second - goal.second);
+                planner = (d >= HPA_MIN_DISTANCE) ? Planner::Hierarchical : Planner::Grid;
+            }
+
+            Job job;
+            job.ticket = t;
+            job.unitId = unit->id;
+            job.start = start;
+            job.goal = goal;
+            job.riskWeight = RiskWeightForUnit(unit);
+            job.planner = planner;
+            m_queued.push_back(std::move(job));
+            return t;
+        }
+
+        JobStatus PathJobQueue::take(Ticket t, Path& out) {
+            if (t == 0) return JobStatus::Unknown;
+            for (size_t i = 0; i < m_ready.size(); ++i) {
+                if (m_ready[i].ticket != t) continue;
+                const JobStatus st = !m_ready[i].ok ? JobStatus::Failed
+                    : m_ready[i].partial ? JobStatus::Partial : JobStatus::Ready;
+                out.swap(m_ready[i].path);
+                m_ready.erase(m_ready.begin() + i);
+                return st;
+            }
+            for (const Job& j : m_queued) if (j.ticket == t) return JobStatus::Pending;
+            for (const Job& j : m_carry)  if (j.ticket == t) return JobStatus::Pending;
+            for (const Job& j : m_jobs)   if (j.ticket == t) return JobStatus::Pending;
+            return JobStatus::Unknown;
+        }
+
+        void PathJobQueue::cancel(Ticket t) {
+            if (t == 0) return;
+            // A search already dispatched still completes; its result is
+            // aged out like any other unclaimed one.
+            m_queued.erase(std::remove_if(m_queued.begin(), m_queued.end(),
+                [t](const Job& j) { return j.ticket == t; }), m_queued.end());
+            for (size_t i = 0; i < m_carry.size(); ++i) {
+                if (m_carry[i].ticket != t) continue;
+                releaseSearch(m_carry[i].search);
+                m_carry.erase(m_carry.begin() + i);
+                break;
+            }
+            m_ready.erase(std::remove_if(m_ready.begin(), m_ready.end(),
+                [t](const Result& r) { return r.ticket == t; }), m_ready.end());
+        }
+
+        void PathJobQueue::clear() {
+            waitBatch();
+            m_queued.clear();
+            m_carry.clear();
+            m_jobs.clear();
+            m_ready.clear();
+        }
+
+        std::unique_ptr<AStarSearch> PathJobQueue::acquireSearch() {
+            std::lock_guard<std::mutex> lock(m_spareMutex);
+            if (m_spare.empty()) return std::unique_ptr<AStarSearch>(new AStarSearch());
+            std::unique_ptr<AStarSearch> s = std::move(m_spare.back());
+            m_spare.pop_back();
+            return s;
+        }
+
+        void PathJobQueue::releaseSearch(std::unique_ptr<AStarSearch>& s) {
+            if (!s) return;
+            std::lock_guard<std::mutex> lock(m_spareMutex);
+            m_spare.push_back(std::move(s));
+        }
+
+        void PathJobQueue::solve(PathfinderContext& ctx, HierarchicalPlanner& hpa,
+            const Models::Grid& grid, const Simulation::SecurityMap& smap,
+            const Simulation::OccupancyGrid& occ, Job& job)
+        {
+            if (job.share <= 0) return;
+            SIM_PROFILE_ZONE(PathJob);
+            if (!job.search) {
+                if (job.planner == Planner::Hierarchical &&
+                    hpa.findPath(ctx, &occ, job.unitId, grid, smap, job.start, job.goal, job.riskWeight, job.path, false)) {
+                    job.ok = true;
+                    job.done = true;
+                    return;
+                }
+                job.search = acquireSearch();
+                job.search->begin(job.start, job.goal, job.riskWeight, job.unitId);
+            }
+
+            const AStarSearch::Status st = job.search->run(grid, smap, &occ, job.share);
+            ++job.slices;
+            if (st == AStarSearch::Status::Found) {
+                job.ok = job.search->path(job.path);
+                job.done = true;
+            }
+            else if (st == AStarSearch::Status::Exhausted || job.slices >= PATH_MAX_SLICES) {
+                job.ok = job.search->bestPartial(job.path) && job.path.size() > 1;
+                job.partial = job.ok;
+                job.done = true;
+            }
+        }
+
+        void PathJobQueue::runJobs(PathfinderContext& ctx, HierarchicalPlanner& hpa) {
+            const int count = (int)m_jobs.size();
+            for (;;) {
+                const int i = m_next.fetch_add(1);
+                if (i >= count) break;
+                solve(ctx, hpa, m_snap.grid, m_snap.smap, m_snap.occ, m_jobs[i]);
+            }
+        }
+
+        void PathJobQueue::workerLoop(Worker& w) {
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [&] { return m_stop || w.batch != m_batch; });
+                    if (m_stop) return;
+                    w.batch = m_batch;
+                }
+                runJobs(w.ctx, w.hpa);
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (--m_busy == 0) m_done.notify_all();
+                }
+            }
+        }
+
+        void PathJobQueue::waitBatch() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [&] { return m_busy == 0; });
+        }
+
+        void PathJobQueue::dispatch(const Models::Grid& grid, const Simulation::SecurityMap& smap,
+            const Simulation::OccupancyGrid& occ)
+        {
+            if (!m_jobs.empty()) deliver();
+            if (m_queued.empty() && m_carry.empty()) return;
+
+            // Suspended searches go first, so the oldest work is served
+            // first when the budget cannot cover everyone.
+            m_jobs.swap(m_carry);
+            for (Job& job : m_queued) m_jobs.push_back(std::move(job));
+            m_queued.clear();
+
+            const int count = (int)m_jobs.size();
+            int share = std::numeric_limits<int>::max();
+            int served = count;
+            if (m_budget > 0) {
+                served = std::max(1, std::min(count, m_budget / PATH_MIN_SLICE));
+                share = m_budget / served;
+            }
+            for (int i = 0; i < count; ++i) m_jobs[i].share = (i < served) ? share : 0;
+
+            if (m_workers.empty()) {
+                for (Job& job : m_jobs) solve(m_ctx, m_hpa, grid, smap, occ, job);
+                return;
+            }
+
+            m_snap.grid = grid;
+            m_snap.smap = smap;
+            m_snap.smap.normalized();   // workers only read the cached plane
+            m_snap.occ = occ;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_next = 0;
+                m_busy = (int)m_workers.size();
+                ++m_batch;
+            }
+            m_wake.notify_all();
+        }
+
+        void PathJobQueue::deliver() {
+            m_ready.erase(std::remove_if(m_ready.begin(), m_ready.end(),
+                [](const Result& r) { return r.age >= 1; }), m_ready.end());
+            for (Result& r : m_ready) ++r.age;
+
+            if (m_jobs.empty()) return;
+            if (!m_workers.empty()) {
+                runJobs(m_ctx, m_hpa);
+                SIM_PROFILE_ZONE(PathWait);
+                waitBatch();
+            }
+            for (Job& job : m_jobs) {
+                if (!job.done) {
+                    if (job.share > 0) ++m_stats.suspended;
+                    m_carry.push_back(std::move(job));
+                    continue;
+                }
+                releaseSearch(job.search);
+                Result res;
+                res.ticket = job.ticket;
+                res.ok = job.ok;
+                res.partial = job.partial;
+                res.path.swap(job.path);
+                m_ready.push_back(std::move(res));
+                ++m_stats.solved;
+                if (job.partial) ++m_stats.partial;
+            }
+            m_jobs.clear();
+        }
+
+    } // namespace Pathfinding
+} // namespace AI
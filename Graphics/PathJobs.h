@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+#include "SecurityMap.h"
+#include "OccupancyGrid.h"
+#include "Pathfinding.h"
+#include "HierarchicalPlanner.h"
+
+namespace Models { class Unit; }
+
+namespace AI {
+    namespace Pathfinding {
+
+        // Path requests that do not block the simulation thread.
+        //
+        // Requests made during tick N are handed to the workers at the end of
+        // that tick (dispatch), together with a copy of the grid, security
+        // map and occupancy as they are at that moment. The workers search
+        // while tick N+1 runs bullets, perception and the commanders; the
+        // results are collected before the FSM updates of tick N+1 (deliver),
+        // waiting for stragglers if needed. What a unit gets therefore only
+        // depends on the snapshot, never on thread timing, and the match is
+        // the same with any number of workers. With 0 workers the searches
+        // run inline at dispatch, against the same state.
+        //
+        // Flat A* work is time-sliced: each tick the queued and suspended
+        // searches share a node budget (PATH_NODE_BUDGET, at least
+        // PATH_MIN_SLICE each; searches that do not fit wait their turn).
+        // A search that runs out of slice is suspended and resumed on the
+        // next tick's snapshot. One that exhausts its open set, or is still
+        // running after PATH_MAX_SLICES ticks, hands back the path to the
+        // closed cell nearest its goal (JobStatus::Partial). HPA* queries
+        // run unsliced, since the cluster graph bounds them, and fall back
+        // to a sliced flat search when they fail.
+        //
+        // Shared goals (flow fields) cost O(path length) and are answered
+        // immediately. Results nobody takes within two deliveries are
+        // dropped, so a unit that dies or leaves its state leaks nothing.
+        class PathJobQueue {
+        public:
+            PathJobQueue();
+            ~PathJobQueue();
+
+            PathJobQueue(const PathJobQueue&) = delete;
+            PathJobQueue& operator=(const PathJobQueue&) = delete;
+
+            // Worker count and node budget used by queues created afterwards.
+            static void SetDefaultWorkers(int n);
+            static void SetDefaultNodeBudget(int nodes);
+
+            void setWorkers(int n);
+            int workers() const { return (int)m_workers.size(); }
+
+            // Flat A* nodes per tick over all searches; 0 = unlimited.
+            void setNodeBudget(int nodes) { m_budget = nodes > 0 ? nodes : 0; }
+            int nodeBudget() const { return m_budget; }
+
+            // Searches from the unit's current cell, or from `start`.
+            Ticket request(const Models::Unit* unit, Cell goal, Planner planner = Planner::Auto);
+            Ticket request(const Models::Unit* unit, Cell start, Cell goal, Planner planner);
+
+            // Ready/Partial/Failed hand the result over (the ticket is then
+            // spent); Pending means "ask again next tick".
+            JobStatus take(Ticket t, Path& out);
+            void cancel(Ticket t);
+
+            // Drops every request and result, waiting for running searches.
+            void clear();
+
+            void dispatch(const Models::Grid& grid, const Simulation::SecurityMap& smap,
+                const Simulation::OccupancyGrid& occ);
+            void deliver();
+
+            struct Stats {
+                uint64_t solved = 0;      // results delivered
+                uint64_t suspended = 0;   // searches carried over to another tick
+                uint64_t partial = 0;     // results that stop short of the goal
+            };
+            const Stats& stats() const { return m_stats; }
+            int pending() const { return (int)(m_queued.size() + m_carry.size()); }
+
+        private:
+            struct Job {
+                Ticket  ticket = 0;
+                int     unitId = -1;
+                Cell    start{ -1, -1 }, goal{ -1, -1 };
+                float   riskWeight = 0.f;
+                Planner planner = Planner::Auto;
+                int     share = 0;      // nodes this tick, 0 = sits this tick out
+                int     slices = 0;
+                bool    done = false;
+                bool    ok = false;
+                bool    partial = false;
+                Path    path;
+                std::unique_ptr<AStarSearch> search;
+            };
+
+            struct Result {
+                Ticket ticket = 0;
+                bool   ok = false;
+                bool   partial = false;
+                int    age = 0;
+                Path   path;
+            };
+
+            struct Snapshot {
+                Models::Grid grid;
+                Simulation::SecurityMap smap;
+                Simulation::OccupancyGrid occ;
+            };
+
+            struct Worker {
+                PathfinderContext ctx;
+                HierarchicalPlanner hpa;
+                uint64_t batch = 0;
+                std::thread thread;
+            };
+
+            void solve(PathfinderContext& ctx, HierarchicalPlanner& hpa,
+                const Models::Grid& grid, const Simulation::SecurityMap& smap,
+                const Simulation::OccupancyGrid& occ, Job& job);
+            void runJobs(PathfinderContext& ctx, HierarchicalPlanner& hpa);
+            std::unique_ptr<AStarSearch> acquireSearch();
+            void releaseSearch(std::unique_ptr<AStarSearch>& s);
+            void workerLoop(Worker& w);
+            void stopWorkers();
+            void waitBatch();
+
+            std::vector<Job>    m_queued;   // requested this tick
+            std::vector<Job>    m_carry;    // suspended, resumed at the next dispatch
+            std::vector<Job>    m_jobs;     // dispatched, delivered next tick
+            std::vector<Result> m_ready;
+            Ticket m_nextTicket = 1;
+            int    m_budget = 0;
+            Stats  m_stats;
+
+            std::vector<std::unique_ptr<AStarSearch>> m_spare;
+            std::mutex m_spareMutex;
+
+            Snapshot m_snap;
+            PathfinderContext   m_ctx;   // inline searches, and helping the workers
+            HierarchicalPlanner m_hpa;
+
+            std::vector<std::unique_ptr<Worker>> m_workers;
+            std::mutex m_mutex;
+            std::condition_variable m_wake;
+            std::condition_variable m_done;
+            std::atomic<int> m_next{ 0 };
+            uint64_t m_batch = 0;
+            int  m_busy = 0;
+            bool m_stop = false;
+        };
+
+    } // namespace Pathfinding
+} // namespace AI
@@ -5,8 +5,10 @@
 #include <limits>
 #include "Visibility.h"
 #include "Definitions.h"
-#include "Globals.h"
+#include "World.h"
 #include "Units.h"
+#include "Log.h"
+#include "Profiler.h"
 #include <cstdio>
 
 using namespace Definitions;
@@ -39,31 +41,13 @@ namespace AI {
                 (c <= GRID_SIZE - 1 - PLAY_RIGHT);
         }
 
-        static inline bool blocksExplosive(int cell) {
-            return (cell == TREE || cell == ROCK || cell == DEPOT_AMMO || cell == DEPOT_MED);
-        }
-
-        bool raycastBlocked(const Models::Grid& grid, int r0, int c0, int r1, int c1)
-        {
-            int dr = std::abs(r1 - r0), dc = std::abs(c1 - c0);
-            int sr = (r0 < r1) ? 1 : -1;
-            int sc = (c0 < c1) ? 1 : -1;
-            int err = dr - dc;
-            int r = r0, c = c0;
-
-            while (!(r == r1 && c == c1)) {
-                if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) break;
-                if (blocksExplosive(g_grid.at(r, c))) return true;
-                int e2 = 2 * err;
-                if (e2 > -dc) { err -= dc; r += sr; }
-                if (e2 < dr) { err += dr; c += sc; }
-            }
-            return false;
-        }
-
-        bool PickBestDefendCell(int goalR, int goalC, int radiusCells,
+        bool PickBestDefendCell(const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            const Simulation::OccupancyGrid& occ,
+            int goalR, int goalC, int radiusCells,
             int selfR, int selfC,
-            int& outR, int& outC)
+            int& outR, int& outC,
+            const Connectivity* reach)
         {
             const int R = std::max(1, radiusCells);
             float bestScore = 1e9f;
@@ -72,11 +56,12 @@ namespace AI {
             auto consider = [&](int r, int c) {
                 if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) return;
                 if (!inPlayfield(r, c)) return;
-                if (!AI::Pathfinding::IsWalkableForMovement(g_grid.at(r, c))) return;
-                if (IsOccupied(r, c)) return;
+                if (!grid.walkable(r, c)) return;
+                if (reach && reach->unreachable(selfR, selfC, r, c)) return;
+                if (IsOccupied(occ, r, c)) return;
 
-                float risk = g_smap.at(r, c);
-                bool covered = raycastBlocked(g_grid, goalR, goalC, r, c);
+                float risk = smap.at(r, c);
+                bool covered = grid.blastBlocked(goalR, goalC, r, c);
                 float coverPenalty = covered ? -0.25f : +0.0f;
                 float distSelf = float(std::abs(r - selfR) + std::abs(c - selfC)) * 0.01f;
                 float score = risk + coverPenalty + distSelf;
@@ -94,107 +79,119 @@ namespace AI {
             return true;
         }
 
-        bool IsOccupiedByOther(int r, int c, int pathingUnitId)
+        bool IsOccupiedByOther(const Simulation::OccupancyGrid& occ, int r, int c, int pathingUnitId)
         {
-            for (const auto* u : g_units) {
-                if (!u->isAlive) continue;
-                if (u->id == pathingUnitId) continue; 
-                if (u->row == r && u->col == c) return true;
-            }
-            return false;
+            return occ.occupiedByOther(r, c, pathingUnitId);
         }
 
-        bool IsOccupied(int r, int c)
+        bool IsOccupied(const Simulation::OccupancyGrid& occ, int r, int c)
         {
-            for (const auto* u : g_units) {
-                if (!u->isAlive) continue;
-                if (u->row == r && u->col == c) return true;
-            }
-            return false;
+            return occ.occupied(r, c);
         }
 
         static inline bool inBounds(int r, int c) {
             return (r >= 0 && r < GRID_SIZE && c >= 0 && c < GRID_SIZE);
         }
 
-        bool IsWalkableForMovement(int cell) {
-            if (cell == ROCK || cell == WATER) return false;
-            return true;
+        PathfinderContext::PathfinderContext()
+            : m_gScore(SLOTS, 0.0f),
+            m_parent(SLOTS, -1),
+            m_seen(SLOTS, 0),
+            m_closed(SLOTS, 0),
+            m_frontier(1024),  // covers one worst-case step (occupied, full risk) at PATH_COST_SCALE
+            m_queue(SLOTS, 0)
+        {
+            m_heap.reserve(SLOTS);
         }
 
-        static Path Reconstruct(std::vector<std::vector<Cell>>& parent, Cell start, Cell goal) {
-            Path path;
-            if (!inBounds(goal.first, goal.second)) {
-                return path;
-            }
-            if (parent[goal.first][goal.second].first == -1 && !(goal == start)) {
-                return path;
+        PathfinderContext& PathfinderContext::local() {
+            static thread_local PathfinderContext ctx;
+            return ctx;
+        }
+
+        void PathfinderContext::beginSearch() {
+            if (++m_generation == 0) {
+                std::fill(m_seen.begin(), m_seen.end(), 0u);
+                std::fill(m_closed.begin(), m_closed.end(), 0u);
+                m_generation = 1;
             }
+            m_heap.clear();
+            m_frontier.clear();
+        }
 
-            Cell cur = goal;
-            while (!(cur == start)) {
-                path.push_back(cur);
-                if (!inBounds(cur.first, cur.second)) {
-                    path.clear();
-                    break;
-                }
-                cur = parent[cur.first][cur.second];
-                if (cur.first < 0 || cur.second < 0) {
-                    path.clear();
-                    break;
+        // Follows parents from goalIdx back to startIdx; `toCell` maps an
+        // index of the layout the search used to (row, col).
+        template <typename ToCell>
+        static bool WalkParents(const PathfinderContext& ctx, int startIdx, int goalIdx, Path& out, ToCell toCell) {
+            out.clear();
+            if (goalIdx != startIdx && ctx.parent(goalIdx) == -1) return false;
+
+            int cur = goalIdx;
+            while (cur != startIdx) {
+                out.push_back(toCell(cur));
+                cur = ctx.parent(cur);
+                if (cur < 0 || (int)out.size() > PathfinderContext::SLOTS) {
+                    out.clear();
+                    return false;
                 }
             }
+            out.push_back(toCell(startIdx));
+            std::reverse(out.begin(), out.end());
+            return true;
+        }
 
-            if ((!path.empty() || goal == start) && cur == start) {
-                path.push_back(start);
-                std::reverse(path.begin(), path.end());
-            }
-            else if (!path.empty()) {
-                path.clear();
-            }
+        bool PathfinderContext::reconstruct(int startIdx, int goalIdx, Path& out) const {
+            return WalkParents(*this, startIdx, goalIdx, out,
+                [](int i) { return Cell{ i / GRID_SIZE, i % GRID_SIZE }; });
+        }
 
-            return path;
+        bool PathfinderContext::reconstructPadded(int startIdx, int goalIdx, Path& out) const {
+            return WalkParents(*this, startIdx, goalIdx, out,
+                [](int p) { return Cell{ Models::Grid::padRow(p), Models::Grid::padCol(p) }; });
         }
 
         Path BFS_FindPath(const Models::Grid& grid, Cell start, Cell goal) {
-            Path empty;
-            if (!inBounds(start.first, start.second) || !inBounds(goal.first, goal.second)) return empty;
-            if (!IsWalkableForMovement(grid.at(goal.first, goal.second))) return empty;
-
-            std::vector<std::vector<bool>> vis(GRID_SIZE, std::vector<bool>(GRID_SIZE, false));
-            std::vector<std::vector<Cell>> parent(GRID_SIZE, std::vector<Cell>(GRID_SIZE, { -1,-1 }));
-
-            std::queue<Cell> q;
-            q.push(start);
-            vis[start.first][start.second] = true;
-
-            const int dr[4] = { +1,-1,0,0 };
-            const int dc[4] = { 0,0,+1,-1 };
-
-            while (!q.empty()) {
-                Cell u = q.front(); q.pop();
-                if (u == goal) break;
-
-                for (int k = 0; k < 4; ++k) {
-                    int nr = u.first + dr[k];
-                    int nc = u.second + dc[k];
-                    if (!inBounds(nr, nc) || vis[nr][nc]) continue;
-                    if (!IsWalkableForMovement(grid.at(nr, nc))) continue;
-                    vis[nr][nc] = true;
-                    parent[nr][nc] = u;
-                    q.push({ nr,nc });
+            Path path;
+            BFS_FindPath(PathfinderContext::local(), grid, start, goal, path);
+            return path;
+        }
+
+        using Models::Grid;
+
+        static constexpr uint8_t WALK = Models::PlaneBit(Models::Plane::Walkable);
+
+        // Breadth-first over the padded property bytes: the border is not
+        // walkable, so the loop needs no bounds checks.
+        template <typename Nb>
+        static void ExpandBFS(PathfinderContext& ctx, const uint8_t* props, int startP, int goalP) {
+            std::vector<int>& q = ctx.queue();
+            int head = 0, tail = 0;
+            q[tail++] = startP;
+            ctx.open(startP, 0.0f, -1);
+
+            while (head < tail) {
+                const int u = q[head++];
+                if (u == goalP) break;
+                for (int k = 0; k < Nb::COUNT; ++k) {
+                    const int n = u + Nb::offset(k);
+                    if (ctx.seen(n) || !(props[n] & WALK)) continue;
+                    ctx.open(n, 0.0f, u);
+                    q[tail++] = n;
                 }
             }
-            return Reconstruct(parent, start, goal);
         }
 
-        struct Node {
-            int r = 0, c = 0;
-            float f = 0, g = 0, h = 0;
-        };
-        struct NodeCmp {
-            bool operator()(const Node& a, const Node& b) const { return a.f > b.f; }
-        };
+        bool BFS_FindPath(PathfinderContext& ctx, const Models::Grid& grid, Cell start, Cell goal, Path& out) {
+            out.clear();
+            if (!inBounds(start.first, start.second) || !inBounds(goal.first, goal.second)) return false;
+            if (!grid.walkable(goal.first, goal.second)) return false;
+
+            ctx.beginSearch();
+            const int startP = Grid::padIndex(start.first, start.second);
+            const int goalP = Grid::padIndex(goal.first, goal.second);
+            ExpandBFS<Neighbourhood<4>>(ctx, grid.paddedProps(), startP, goalP);
+            return ctx.reconstructPadded(startP, goalP, out);
+        }
 
         static inline float Heuristic(Cell a, Cell b) {
             return (float)(std::abs(a.first - b.first) + std::abs(a.second - b.second));
@@ -205,85 +202,211 @@ namespace AI {
             const Simulation::SecurityMap& smap,
             Cell start, Cell goal,
             float riskWeight) {
-            Path empty;
+            Path path;
+            AStar_FindPath(PathfinderContext::local(), pathingUnit, grid, smap, start, goal, riskWeight, path);
+            return path;
+        }
+
+        bool AStar_FindPath(PathfinderContext& ctx,
+            const Models::Unit* pathingUnit,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out) {
             if (!pathingUnit) {
-                printf("ERROR: A* called with null pathingUnit!\n");
-                return empty;
+                out.clear();
+                SIM_LOG("ERROR: A* called with null pathingUnit!\n");
+                return false;
             }
+            const Simulation::World* world = pathingUnit->world;
+            if (&grid == &world->grid && world->connectivity.unreachable(start.first, start.second, goal.first, goal.second)) {
+                out.clear();
+                return false;
+            }
+            return AStar_FindPath(ctx, &pathingUnit->world->occupancy, pathingUnit->id,
+                grid, smap, start, goal, riskWeight, out);
+        }
 
-            if (!inBounds(start.first, start.second) || !inBounds(goal.first, goal.second)) return empty;
-            if (!IsWalkableForMovement(grid.at(goal.first, goal.second))) return empty;
+        static inline float HeuristicPadded(int p, int goalRow, int goalCol) {
+            return (float)(std::abs(p / Grid::STRIDE - goalRow) + std::abs(p % Grid::STRIDE - goalCol));
+        }
 
-            const float maxV = std::max(0.0001f, smap.maxValue());
-            const int dr[4] = { +1,-1,0,0 };
-            const int dc[4] = { 0,0,+1,-1 };
+        // Expands at most `budget` nodes of the search held in `ctx`, which
+        // uses padded indices. Keeps the closed cell nearest the goal in
+        // bestIdx/bestH. Returns the number of nodes closed; `reached` is set
+        // once the goal is closed.
+        template <typename Nb>
+        static int ExpandAStar(PathfinderContext& ctx,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            const Simulation::OccupancyGrid* occ, int pathingUnitId,
+            int goalP, float riskWeight, int budget,
+            int& bestIdx, float& bestH, bool& reached)
+        {
+            const uint8_t* props = grid.paddedProps();
+            const float* risk = smap.normalizedPadded();
 
             constexpr float OCCUPANCY_PENALTY = 25.0f;
 
-            std::vector<std::vector<float>> gScore(GRID_SIZE, std::vector<float>(GRID_SIZE, std::numeric_limits<float>::infinity()));
-            std::vector<std::vector<Cell>> parent(GRID_SIZE, std::vector<Cell>(GRID_SIZE, { -1,-1 }));
-            std::vector<std::vector<bool>> closed(GRID_SIZE, std::vector<bool>(GRID_SIZE, false));
+            BucketQueue<int>& open = ctx.frontier();
+            const int goalRow = goalP / Grid::STRIDE, goalCol = goalP % Grid::STRIDE;
+            int done = 0;
+            reached = false;
 
-            auto riskNorm = [&](int r, int c)->float {
-                if (!inBounds(r, c)) return 1.0f;
-                float v = smap.at(r, c);
-                return (v <= 0.0f ? 0.0f : std::min(1.0f, v / maxV));
-                };
+            while (!open.empty() && done < budget) {
+                // Improved cells are pushed again; the stale entries are
+                // skipped here once the cell is closed.
+                const int cur = open.pop();
+                if (ctx.closed(cur)) continue;
+                ctx.close(cur);
+                ++done;
 
-            std::priority_queue<Node, std::vector<Node>, NodeCmp> open;
+                const float h = HeuristicPadded(cur, goalRow, goalCol);
+                if (h < bestH) { bestH = h; bestIdx = cur; }
 
-            gScore[start.first][start.second] = 0.0f;
-            Node s; s.r = start.first; s.c = start.second; s.g = 0.0f; s.h = Heuristic(start, goal); s.f = s.g + s.h;
-            open.push(s);
+                if (cur == goalP) { reached = true; break; }
 
-            while (!open.empty()) {
-                Node cur = open.top(); open.pop();
+                const float gCur = ctx.gScore(cur);
+
+                for (int k = 0; k < Nb::COUNT; ++k) {
+                    const int n = cur + Nb::offset(k);
+                    if (ctx.closed(n) || !(props[n] & WALK)) continue;
+
+                    float step = 1.0f + riskWeight * risk[n];
+
+                    if (occ && IsOccupiedByOther(*occ, Grid::padRow(n), Grid::padCol(n), pathingUnitId)) {
+                        step += OCCUPANCY_PENALTY;
+                    }
 
-                if (!inBounds(cur.r, cur.c) || closed[cur.r][cur.c]) {
-                    continue;
+                    const float tentative = gCur + step;
+
+                    if (tentative < ctx.gScore(n)) {
+                        ctx.open(n, tentative, cur);
+                        open.push(CostKey(tentative + HeuristicPadded(n, goalRow, goalCol)), n);
+                    }
                 }
-                closed[cur.r][cur.c] = true;
+            }
+            return done;
+        }
 
-                if (cur.r == goal.first && cur.c == goal.second) break;
+        bool AStar_FindPath(PathfinderContext& ctx,
+            const Simulation::OccupancyGrid* occ, int pathingUnitId,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out) {
+            SIM_PROFILE_ZONE(AStar);
+            out.clear();
+
+            if (!inBounds(start.first, start.second) || !inBounds(goal.first, goal.second)) return false;
+            if (!grid.walkable(goal.first, goal.second)) return false;
+
+            ctx.beginSearch();
+            const int startP = Grid::padIndex(start.first, start.second);
+            const int goalP = Grid::padIndex(goal.first, goal.second);
+            ctx.open(startP, 0.0f, -1);
+            ctx.frontier().push(CostKey(Heuristic(start, goal)), startP);
+
+            int best = -1;
+            float bestH = std::numeric_limits<float>::infinity();
+            bool reached = false;
+            ExpandAStar<Neighbourhood<4>>(ctx, grid, smap, occ, pathingUnitId, goalP, riskWeight,
+                std::numeric_limits<int>::max(), best, bestH, reached);
+            return ctx.reconstructPadded(startP, goalP, out);
+        }
 
-                for (int k = 0; k < 4; ++k) {
-                    int nr = cur.r + dr[k];
-                    int nc = cur.c + dc[k];
+        void AStarSearch::begin(Cell start, Cell goal, float riskWeight, int pathingUnitId) {
+            m_start = start;
+            m_goal = goal;
+            m_riskWeight = riskWeight;
+            m_unitId = pathingUnitId;
+            m_best = -1;
+            m_bestH = std::numeric_limits<float>::infinity();
+            m_expanded = 0;
+            m_status = Status::Idle;
+        }
 
-                    if (!inBounds(nr, nc) || closed[nr][nc]) continue;
-                    if (!IsWalkableForMovement(grid.at(nr, nc))) continue;
+        AStarSearch::Status AStarSearch::run(const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            const Simulation::OccupancyGrid* occ,
+            int maxExpansions)
+        {
+            if (m_status == Status::Found || m_status == Status::Exhausted) return m_status;
+            SIM_PROFILE_ZONE(AStar);
+
+            if (m_status == Status::Idle) {
+                if (!inBounds(m_start.first, m_start.second) || !inBounds(m_goal.first, m_goal.second) ||
+                    !grid.walkable(m_goal.first, m_goal.second)) {
+                    m_status = Status::Exhausted;
+                    return m_status;
+                }
+                m_ctx.beginSearch();
+                const int startP = Grid::padIndex(m_start.first, m_start.second);
+                m_ctx.open(startP, 0.0f, -1);
+                m_ctx.frontier().push(CostKey(Heuristic(m_start, m_goal)), startP);
+                m_status = Status::Running;
+            }
 
-                    float step = 1.0f + riskWeight * riskNorm(nr, nc);
+            bool reached = false;
+            m_expanded += ExpandAStar<Neighbourhood<4>>(m_ctx, grid, smap, occ, m_unitId,
+                Grid::padIndex(m_goal.first, m_goal.second), m_riskWeight,
+                maxExpansions, m_best, m_bestH, reached);
+            if (reached) m_status = Status::Found;
+            else if (m_ctx.frontier().empty()) m_status = Status::Exhausted;
+            return m_status;
+        }
 
-                    if (IsOccupiedByOther(nr, nc, pathingUnit->id)) {
-                        step += OCCUPANCY_PENALTY;
-                    }
+        bool AStarSearch::path(Path& out) const {
+            if (m_status != Status::Found) { out.clear(); return false; }
+            return m_ctx.reconstructPadded(Grid::padIndex(m_start.first, m_start.second),
+                Grid::padIndex(m_goal.first, m_goal.second), out);
+        }
 
-                    float tentative = gScore[cur.r][cur.c] + step;
-
-                    if (tentative < gScore[nr][nc]) {
-                        gScore[nr][nc] = tentative;
-                        parent[nr][nc] = { cur.r, cur.c };
-                        Node nxt;
-                        nxt.r = nr; nxt.c = nc;
-                        nxt.g = tentative;
-                        nxt.h = Heuristic({ nr,nc }, goal);
-                        nxt.f = nxt.g + nxt.h;
-                        open.push(nxt);
-                    }
+        bool AStarSearch::bestPartial(Path& out) const {
+            if (m_best < 0) { out.clear(); return false; }
+            return m_ctx.reconstructPadded(Grid::padIndex(m_start.first, m_start.second), m_best, out);
+        }
+
+        bool FindPath(PathfinderContext& ctx,
+            const Models::Unit* pathingUnit,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out,
+            Planner planner)
+        {
+            Simulation::World* world = pathingUnit ? pathingUnit->world : nullptr;
+            if (world && &grid == &world->grid &&
+                world->connectivity.unreachable(start.first, start.second, goal.first, goal.second)) {
+                out.clear();
+                return false;
+            }
+            if (planner == Planner::Auto) {
+                if (world && world->isSharedGoal(goal.first, goal.second)) {
+                    if (world->flow.extractPath(grid, smap, start, goal, out)) return true;
                 }
+                const int d = std::abs(start.first - goal.first) + std::abs(start.second - goal.second);
+                planner = (d >= HPA_MIN_DISTANCE) ? Planner::Hierarchical : Planner::Grid;
             }
-            return Reconstruct(parent, start, goal);
+            if (planner == Planner::FlowField && world)
+                return world->flow.extractPath(grid, smap, start, goal, out);
+            if (planner == Planner::Hierarchical && world)
+                return world->hpa.findPath(ctx, pathingUnit, grid, smap, start, goal, riskWeight, out);
+            return AStar_FindPath(ctx, pathingUnit, grid, smap, start, goal, riskWeight, out);
         }
 
         Cell PickVantagePoint(const Models::Grid& grid,
             const Simulation::SecurityMap& smap,
             Cell agent, Cell target,
-            int attackRangeCells, float distWeight, int searchRadius)
+            int attackRangeCells, float distWeight, int searchRadius,
+            const Connectivity* reach)
         {
             const int tr = target.first, tc = target.second;
             const int ar = agent.first, ac = agent.second;
-            const float maxRisk = std::max(0.0001f, smap.maxValue());
+            const auto& riskNorm = smap.normalized();
             float bestScore = std::numeric_limits<float>::infinity();
             Cell bestCell = { -1, -1 };
 
@@ -294,15 +417,15 @@ namespace AI {
 
             for (int r = r0; r <= r1; ++r) {
                 for (int c = c0; c <= c1; ++c) {
-                    if (!inBounds(r, c) || !IsWalkableForMovement(grid.at(r, c))) continue;
+                    if (!inBounds(r, c) || !grid.walkable(r, c)) continue;
+                    if (reach && reach->unreachable(ar, ac, r, c)) continue;
 
                     int distToTarget = std::abs(r - tr) + std::abs(c - tc);
                     if (distToTarget > attackRangeCells) continue;
                     if (!AI::Visibility::HasLineOfSight(grid, r, c, tr, tc)) continue;
 
-                    float riskNorm = smap.at(r, c) / maxRisk;
                     int distFromAgent = std::abs(r - ar) + std::abs(c - ac);
-                    float score = riskNorm + distWeight * float(distFromAgent);
+                    float score = riskNorm[r][c] + distWeight * float(distFromAgent);
 
                     if (score < bestScore) {
                         bestScore = score;
@@ -317,55 +440,55 @@ namespace AI {
             const Simulation::SecurityMap& smap,
             Cell from, int radius, float riskDeltaMin)
         {
+            using Nb = Neighbourhood<4>;
             const int r0 = from.first, c0 = from.second;
             if (!inBounds(r0, c0)) return { -1,-1 };
 
-            const float maxV = std::max(0.0001f, smap.maxValue());
-            auto riskN = [&](int r, int c)->float {
-                float v = smap.at(r, c);
-                return (v <= 0.f ? 0.f : std::min(1.f, v / maxV));
-                };
+            const uint8_t* props = grid.paddedProps();
+            const float* risk = smap.normalizedPadded();
+            const int p0 = Grid::padIndex(r0, c0);
 
-            const float here = riskN(r0, c0);
-            const int dr4[4] = { +1,-1,0,0 };
-            const int dc4[4] = { 0,0,+1,-1 };
-            Cell best = { -1,-1 };
+            const float here = risk[p0];
+            int best = -1;
             float bestDrop = 0.f;
 
-            for (int k = 0; k < 4; ++k) {
-                int r = r0 + dr4[k], c = c0 + dc4[k];
-                if (!inBounds(r, c) || !IsWalkableForMovement(grid.at(r, c))) continue;
-                float rn = riskN(r, c);
-                float drop = here - rn;
+            for (int k = 0; k < Nb::COUNT; ++k) {
+                const int n = p0 + Nb::offset(k);
+                if (!(props[n] & WALK)) continue;
+                const float drop = here - risk[n];
                 if (drop >= riskDeltaMin && drop > bestDrop) {
                     bestDrop = drop;
-                    best = { r,c };
+                    best = n;
                 }
             }
-            if (best.first != -1) return best;
+            if (best >= 0) return { Grid::padRow(best), Grid::padCol(best) };
 
             int rmin = std::max(0, r0 - radius), rmax = std::min(GRID_SIZE - 1, r0 + radius);
             int cmin = std::max(0, c0 - radius), cmax = std::min(GRID_SIZE - 1, c0 + radius);
-            Cell target = { -1,-1 };
+            int target = -1;
             float targetDrop = 0.f;
 
-            for (int r = rmin; r <= rmax; ++r) for (int c = cmin; c <= cmax; ++c) {
-                if (!IsWalkableForMovement(grid.at(r, c))) continue;
-                float rn = riskN(r, c);
-                float drop = here - rn;
-                if (drop >= riskDeltaMin && drop > targetDrop) {
-                    targetDrop = drop; target = { r,c };
+            for (int r = rmin; r <= rmax; ++r) {
+                const int rowP = Grid::padIndex(r, 0);
+                for (int p = rowP + cmin; p <= rowP + cmax; ++p) {
+                    if (!(props[p] & WALK)) continue;
+                    const float drop = here - risk[p];
+                    if (drop >= riskDeltaMin && drop > targetDrop) {
+                        targetDrop = drop; target = p;
+                    }
                 }
             }
 
-            if (target.first == -1) return { -1,-1 };
+            if (target < 0) return { -1,-1 };
 
+            const int tr = Grid::padRow(target), tc = Grid::padCol(target);
             Cell step = { -1,-1 };
-            int bestD = std::abs(r0 - target.first) + std::abs(c0 - target.second);
-            for (int k = 0; k < 4; ++k) {
-                int r = r0 + dr4[k], c = c0 + dc4[k];
-                if (!inBounds(r, c) || !IsWalkableForMovement(grid.at(r, c))) continue;
-                int d = std::abs(r - target.first) + std::abs(c - target.second);
+            int bestD = std::abs(r0 - tr) + std::abs(c0 - tc);
+            for (int k = 0; k < Nb::COUNT; ++k) {
+                const int n = p0 + Nb::offset(k);
+                if (!(props[n] & WALK)) continue;
+                const int r = Grid::padRow(n), c = Grid::padCol(n);
+                const int d = std::abs(r - tr) + std::abs(c - tc);
                 if (d < bestD) { bestD = d; step = { r,c }; }
             }
             return step;
@@ -375,15 +498,13 @@ namespace AI {
             const Path& path, int sampleLen, bool useMax)
         {
             if (path.empty() || sampleLen <= 0) return 0.f;
-            const float maxV = std::max(0.0001f, smap.maxValue());
             int n = 0;
             const int upto = std::min<int>(sampleLen, (int)path.size());
 
             if (useMax) {
                 float mx = 0.f;
                 for (int i = 0; i < upto; ++i) {
-                    float v = smap.at(path[i].first, path[i].second);
-                    float rn = (v <= 0.f ? 0.f : std::min(1.f, v / maxV));
+                    float rn = smap.normAt(path[i].first, path[i].second);
                     if (rn > mx) mx = rn;
                 }
                 return mx;
@@ -391,8 +512,7 @@ namespace AI {
             else {
                 float agg = 0.f;
                 for (int i = 0; i < upto; ++i) {
-                    float v = smap.at(path[i].first, path[i].second);
-                    float rn = (v <= 0.f ? 0.f : std::min(1.f, v / maxV));
+                    float rn = smap.normAt(path[i].first, path[i].second);
                     agg += rn; ++n;
                 }
                 return (n > 0 ? agg / float(n) : 0.f);
@@ -2,9 +2,14 @@
 #include <vector>
 #include <utility> 
 #include <limits>  
+#include <cstdint>
 #include "Definitions.h"
 #include "Grid.h"
 #include "SecurityMap.h"
+#include "OccupancyGrid.h"
+#include "Connectivity.h"
+#include "BucketQueue.h"
+#include "Neighbourhood.h"
 
 namespace Models { class Unit; }
 
@@ -14,31 +19,176 @@ namespace AI {
         using Cell = std::pair<int, int>;
         using Path = std::vector<Cell>;
 
+        // Reusable scratch memory for grid searches. All arrays are flat and
+        // sized once for Grid's padded layout: grid kernels index them with
+        // Grid::padIndex, the HPA* graph search with r * GRID_SIZE + c. A
+        // search does not clear them but bumps the generation counter, and a
+        // cell's gScore/parent are only trusted when its stamp matches the
+        // current generation.
+        class PathfinderContext {
+        public:
+            static constexpr int SLOTS = Models::Grid::PADDED_CELLS;
+
+            struct Node {
+                float f = 0.f, g = 0.f;
+                int   idx = 0;
+            };
+
+            PathfinderContext();
+
+            // One context per thread, shared by every search on that thread.
+            static PathfinderContext& local();
+
+            void beginSearch();
+
+            inline bool  seen(int i) const { return m_seen[i] == m_generation; }
+            inline bool  closed(int i) const { return m_closed[i] == m_generation; }
+            inline float gScore(int i) const { return seen(i) ? m_gScore[i] : std::numeric_limits<float>::infinity(); }
+            inline int   parent(int i) const { return seen(i) ? m_parent[i] : -1; }
+
+            inline void open(int i, float g, int parentIdx) {
+                m_seen[i] = m_generation; m_gScore[i] = g; m_parent[i] = parentIdx;
+            }
+            inline void close(int i) { m_closed[i] = m_generation; ++m_expanded; }
+
+            // Nodes closed by every search run on this context so far.
+            inline uint64_t expanded() const { return m_expanded; }
+
+            // Binary heap for searches with unbounded edge costs (the HPA*
+            // cluster graph); grid searches use the bucket frontier.
+            std::vector<Node>& heap() { return m_heap; }
+            BucketQueue<int>& frontier() { return m_frontier; }
+            std::vector<int>& queue() { return m_queue; }
+
+            bool reconstruct(int startIdx, int goalIdx, Path& out) const;
+            // Same walk for searches that stored padded indices.
+            bool reconstructPadded(int startIdx, int goalIdx, Path& out) const;
+
+        private:
+            std::vector<float>    m_gScore;
+            std::vector<int>      m_parent;
+            std::vector<uint32_t> m_seen;
+            std::vector<uint32_t> m_closed;
+            std::vector<Node>     m_heap;
+            BucketQueue<int>      m_frontier;
+            std::vector<int>      m_queue;
+            uint32_t              m_generation = 0;
+            uint64_t              m_expanded = 0;
+        };
+
+        // Which planner FindPath uses. Auto follows the cached flow field for
+        // shared goals (World::isSharedGoal), otherwise keeps flat A* for
+        // short hops and switches to HPA* from HPA_MIN_DISTANCE on.
+        enum class Planner : uint8_t { Grid, Hierarchical, FlowField, Auto };
+
+        // Handle for a queued search (PathJobQueue); 0 = no request.
+        using Ticket = uint32_t;
+        enum class JobStatus : uint8_t { Pending, Ready, Partial, Failed, Unknown };
+
         float RiskWeightForUnit(const Models::Unit* u);
 
-        bool PickBestDefendCell(
+        bool PickBestDefendCell(const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            const Simulation::OccupancyGrid& occ,
             int anchorR, int anchorC,
             int searchRadiusCells,
             int unitR, int unitC,
-            int& outR, int& outC
+            int& outR, int& outC,
+            const Connectivity* reach = nullptr
         );
 
 
         bool inPlayfield(int r, int c);
 
-        bool IsWalkableForMovement(int cell);
+        // For a raw cell value; with a grid at hand, Grid::walkable is a
+        // single bit test.
+        inline bool IsWalkableForMovement(int cell) {
+            return (Models::TypeProps(cell) & Models::PlaneBit(Models::Plane::Walkable)) != 0;
+        }
 
         Path BFS_FindPath(const Models::Grid& grid, Cell start, Cell goal);
 
+        bool BFS_FindPath(PathfinderContext& ctx,
+            const Models::Grid& grid,
+            Cell start, Cell goal,
+            Path& out);
+
         Path AStar_FindPath(const Models::Unit* pathingUnit,
             const Models::Grid& grid,
             const Simulation::SecurityMap& smap,
             Cell start, Cell goal,
             float riskWeight = Definitions::ASTAR_RISK_WEIGHT);
 
+        // Writes into 'out' (reusing its capacity); returns !out.empty().
+        bool AStar_FindPath(PathfinderContext& ctx,
+            const Models::Unit* pathingUnit,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out);
+
+        // Same search against an explicit occupancy grid (null = ignore
+        // occupancy), for callers that plan on a snapshot of the world.
+        bool AStar_FindPath(PathfinderContext& ctx,
+            const Simulation::OccupancyGrid* occ, int pathingUnitId,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out);
+
+
+        // A* that can stop after a number of expansions and carry on from the
+        // same open set on a later call. It owns its scratch memory, so any
+        // number of searches can be suspended at once. Costs match
+        // AStar_FindPath; a search resumed against a newer grid or security
+        // map uses the new values for the nodes it expands from then on.
+        class AStarSearch {
+        public:
+            enum class Status : uint8_t { Idle, Running, Found, Exhausted };
+
+            void begin(Cell start, Cell goal, float riskWeight, int pathingUnitId);
+
+            Status run(const Models::Grid& grid,
+                const Simulation::SecurityMap& smap,
+                const Simulation::OccupancyGrid* occ,
+                int maxExpansions);
+
+            Status status() const { return m_status; }
+            int expanded() const { return m_expanded; }
+
+            // start..goal, once Found.
+            bool path(Path& out) const;
+            // start..the closed cell nearest the goal so far.
+            bool bestPartial(Path& out) const;
+
+        private:
+            PathfinderContext m_ctx;
+            Cell   m_start{ -1, -1 }, m_goal{ -1, -1 };
+            float  m_riskWeight = 0.f;
+            int    m_unitId = -1;
+            int    m_best = -1;
+            float  m_bestH = 0.f;
+            int    m_expanded = 0;
+            Status m_status = Status::Idle;
+        };
+
+
+        // A* or HPA* (through the pathing unit's World), chosen by `planner`.
+        // Goals outside the start's connected component fail at once.
+        bool FindPath(PathfinderContext& ctx,
+            const Models::Unit* pathingUnit,
+            const Models::Grid& grid,
+            const Simulation::SecurityMap& smap,
+            Cell start, Cell goal,
+            float riskWeight,
+            Path& out,
+            Planner planner = Planner::Auto);
+
 
-        bool IsOccupied(int r, int c);
-        bool IsOccupiedByOther(int r, int c, int pathingUnitId);
+        bool IsOccupied(const Simulation::OccupancyGrid& occ, int r, int c);
+        bool IsOccupiedByOther(const Simulation::OccupancyGrid& occ, int r, int c, int pathingUnitId);
 
 
         Cell PickVantagePoint(const Models::Grid& grid,
@@ -47,7 +197,8 @@ namespace AI {
             Cell target,
             int   attackRangeCells = Definitions::FIRE_RANGE, 
             float distWeight = 0.15f,
-            int   searchRadius = 10);
+            int   searchRadius = 10,
+            const Connectivity* reach = nullptr);
 
         Cell FindLocalCoverStep(const Models::Grid& grid,
             const Simulation::SecurityMap& smap,
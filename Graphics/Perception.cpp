@@ -0,0 +1,129 @@
+#include "Perception.h"
+#include "Visibility.h"
+#include <algorithm>
+#include <limits>
+
+namespace AI {
+
+    void Perception::clear() {
+        m_n = 0;
+        m_losChecks = 0;
+        m_units.clear();
+        m_slotById.clear();
+        m_row.clear(); m_col.clear();
+        m_onTree.clear();
+        m_sees.clear();
+        m_distSq.clear();
+    }
+
+    void Perception::rebuild(const Models::Grid& map,
+        const std::vector<Models::Unit*>& units,
+        int sightRange)
+    {
+        clear();
+        m_range2 = sightRange * sightRange;
+
+        int maxId = 0;
+        for (const auto* u : units) {
+            if (!u || !u->isAlive) continue;
+            m_units.push_back(u);
+            maxId = std::max(maxId, u->id);
+        }
+        m_n = (int)m_units.size();
+
+        m_slotById.assign(maxId + 1, -1);
+        m_row.resize(m_n); m_col.resize(m_n); m_onTree.resize(m_n);
+        for (int i = 0; i < m_n; ++i) {
+            const auto* u = m_units[i];
+            if (u->id >= 0) m_slotById[u->id] = i;
+            m_row[i] = u->row;
+            m_col[i] = u->col;
+            m_onTree[i] = (map.at(u->row, u->col) == Definitions::TREE) ? 1 : 0;
+        }
+
+        m_sees.assign((size_t)m_n * m_n, 0);
+        m_distSq.assign((size_t)m_n * m_n, 0);
+
+        buildRows(map);
+    }
+
+    void Perception::buildRows(const Models::Grid& map) {
+        for (int v = 0; v < m_n; ++v) {
+            const Definitions::Team team = m_units[v]->team;
+            for (int t = 0; t < m_n; ++t) {
+                if (m_units[t]->team == team) continue;
+                const int dr = m_row[t] - m_row[v];
+                const int dc = m_col[t] - m_col[v];
+                const int d2 = dr * dr + dc * dc;
+                const size_t k = (size_t)v * m_n + t;
+                m_distSq[k] = d2;
+                if (d2 > m_range2) continue;
+                ++m_losChecks;
+                if (Visibility::HasLineOfSight(map, m_row[v], m_col[v], m_row[t], m_col[t])) m_sees[k] = 1;
+            }
+        }
+    }
+
+    int Perception::slotOf(const Models::Unit& u) const {
+        if (u.id < 0 || u.id >= (int)m_slotById.size()) return -1;
+        const int s = m_slotById[u.id];
+        return (s >= 0 && m_units[s] == &u) ? s : -1;
+    }
+
+    bool Perception::sees(const Models::Unit& viewer, const Models::Unit& target) const {
+        const int v = slotOf(viewer), t = slotOf(target);
+        if (v < 0 || t < 0) return false;
+        return m_sees[(size_t)v * m_n + t] != 0;
+    }
+
+    bool Perception::bestVisibleEnemy(const Models::Unit& viewer, Sighting& out, Pick pick) const {
+        const int v = slotOf(viewer);
+        if (v < 0 || !viewer.isAlive) return false;
+
+        float bestScore = std::numeric_limits<float>::infinity();
+        int best = -1;
+        const size_t base = (size_t)v * m_n;
+        for (int t = 0; t < m_n; ++t) {
+            if (!m_sees[base + t] || !m_units[t]->isAlive) continue;
+            float score = (float)m_distSq[base + t];
+            if (pick == Pick::PreferOpen && m_onTree[t]) score *= Definitions::TREE_COVER_PENALTY_MULTIPLIER;
+            if (score < bestScore) { bestScore = score; best = t; }
+        }
+        if (best < 0) return false;
+
+        out.unit = m_units[best];
+        out.row = m_row[best];
+        out.col = m_col[best];
+        out.distSq = m_distSq[base + best];
+        return true;
+    }
+
+    bool Perception::bestVisibleEnemy(const Models::Unit& viewer, int& outR, int& outC, Pick pick) const {
+        Sighting s;
+        outR = -1; outC = -1;
+        if (!bestVisibleEnemy(viewer, s, pick)) return false;
+        outR = s.row; outC = s.col;
+        return true;
+    }
+
+    void Perception::visibleEnemies(const Models::Unit& viewer, std::vector<Sighting>& out) const {
+        out.clear();
+        const int v = slotOf(viewer);
+        if (v < 0 || !viewer.isAlive) return;
+        const size_t base = (size_t)v * m_n;
+        for (int t = 0; t < m_n; ++t) {
+            if (!m_sees[base + t] || !m_units[t]->isAlive) continue;
+            out.push_back(Sighting{ m_units[t], m_row[t], m_col[t], m_distSq[base + t] });
+        }
+    }
+
+    void Perception::watchersOf(const Models::Unit& target, std::vector<const Models::Unit*>& out) const {
+        out.clear();
+        const int t = slotOf(target);
+        if (t < 0) return;
+        for (int v = 0; v < m_n; ++v) {
+            if (m_sees[(size_t)v * m_n + t] && m_units[v]->isAlive) out.push_back(m_units[v]);
+        }
+    }
+
+} // namespace AI
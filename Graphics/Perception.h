@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Definitions.h"
+#include "Grid.h"
+#include "Units.h"
+
+namespace AI {
+
+    // Who-sees-whom between opposing units, built once per tick from the unit
+    // positions at that moment. Every "is there a visible enemy" question
+    // during the tick is answered from this snapshot instead of casting its
+    // own HasLineOfSight rays.
+    class Perception {
+    public:
+        struct Sighting {
+            const Models::Unit* unit = nullptr;
+            int row = -1, col = -1; // where the enemy stood when the snapshot was taken
+            int distSq = 0;
+        };
+
+        // Nearest: smallest squared distance.
+        // PreferOpen: same, but enemies standing in trees score
+        // TREE_COVER_PENALTY_MULTIPLIER times farther away.
+        enum class Pick : uint8_t { Nearest, PreferOpen };
+
+        void clear();
+
+        void rebuild(const Models::Grid& map,
+            const std::vector<Models::Unit*>& units,
+            int sightRange);
+
+        bool sees(const Models::Unit& viewer, const Models::Unit& target) const;
+
+        bool bestVisibleEnemy(const Models::Unit& viewer, Sighting& out, Pick pick = Pick::Nearest) const;
+        bool bestVisibleEnemy(const Models::Unit& viewer, int& outR, int& outC, Pick pick = Pick::Nearest) const;
+
+        // In unit-list order.
+        void visibleEnemies(const Models::Unit& viewer, std::vector<Sighting>& out) const;
+        void watchersOf(const Models::Unit& target, std::vector<const Models::Unit*>& out) const;
+
+        inline int unitCount() const { return m_n; }
+        inline long long losChecks() const { return m_losChecks; }
+
+    private:
+        int slotOf(const Models::Unit& u) const;
+        void buildRows(const Models::Grid& map);
+
+        int m_n = 0;
+        int m_range2 = 0;
+        long long m_losChecks = 0;
+
+        std::vector<const Models::Unit*> m_units;
+        std::vector<int> m_slotById;
+        std::vector<int> m_row, m_col;
+        std::vector<uint8_t> m_onTree;
+
+        // m_sees[v * m_n + t]: unit v has t in sight (opposing teams only).
+        std::vector<uint8_t> m_sees;
+        std::vector<int> m_distSq;
+    };
+
+} // namespace AI
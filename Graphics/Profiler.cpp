@@ -0,0 +1,175 @@
+#include "Profiler.h"
+
+#if SIM_PROFILE
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace Simulation {
+namespace Profiler {
+
+    const char* ZoneName(Zone z)
+    {
+        switch (z) {
+        case Zone::Frame:          return "Frame";
+        case Zone::TickBullets:    return "TickBullets";
+        case Zone::Perception:     return "Perception";
+        case Zone::CommanderTick:  return "CommanderTick";
+        case Zone::DecideOrders:   return "DecideOrders";
+        case Zone::FsmUpdate:      return "FsmUpdate";
+        case Zone::AStar:          return "AStar";
+        case Zone::HpaAbstract:    return "HpaAbstract";
+        case Zone::FlowField:      return "FlowField";
+        case Zone::PathJob:        return "PathJob";
+        case Zone::PathWait:       return "PathWait";
+        case Zone::SecurityMap:    return "SecurityMap";
+        case Zone::TeamVisibility: return "TeamVisibility";
+        case Zone::Render:         return "Render";
+        default:                   return "?";
+        }
+    }
+
+#if SIM_PROFILE
+
+    namespace {
+
+        struct Event {
+            uint64_t start;
+            uint32_t dur;
+            Zone zone;
+        };
+
+        struct ThreadRing {
+            int tid = 0;
+            std::vector<Event> events = std::vector<Event>(RING_EVENTS);
+            uint64_t written = 0;
+
+            uint64_t totalNs[ZONE_COUNT] = {};
+            uint64_t totalCalls[ZONE_COUNT] = {};
+
+            uint64_t frameNs[ZONE_COUNT] = {};
+            uint32_t frameCalls[ZONE_COUNT] = {};
+
+            uint64_t histNs[AVG_FRAMES][ZONE_COUNT] = {};
+            uint32_t histCalls[AVG_FRAMES][ZONE_COUNT] = {};
+            uint64_t sumNs[ZONE_COUNT] = {};
+            uint64_t sumCalls[ZONE_COUNT] = {};
+            int histPos = 0;
+            int histFilled = 0;
+        };
+
+        const auto g_epoch = std::chrono::steady_clock::now();
+
+        // Rings outlive their threads so a trace can still be written after
+        // worker threads have joined.
+        std::mutex g_ringsMutex;
+        std::vector<std::unique_ptr<ThreadRing>> g_rings;
+        thread_local ThreadRing* t_ring = nullptr;
+
+        ThreadRing& localRing()
+        {
+            if (!t_ring) {
+                std::lock_guard<std::mutex> lock(g_ringsMutex);
+                g_rings.emplace_back(new ThreadRing());
+                t_ring = g_rings.back().get();
+                t_ring->tid = (int)g_rings.size();
+            }
+            return *t_ring;
+        }
+
+    } // namespace
+
+    uint64_t NowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - g_epoch).count();
+    }
+
+    void Record(Zone z, uint64_t startNs, uint64_t endNs)
+    {
+        ThreadRing& r = localRing();
+        const uint64_t dur = endNs - startNs;
+        Event& e = r.events[(size_t)(r.written & (RING_EVENTS - 1))];
+        e.start = startNs;
+        e.dur = dur > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)dur;
+        e.zone = z;
+        ++r.written;
+
+        r.totalNs[(int)z] += dur;
+        r.totalCalls[(int)z] += 1;
+        r.frameNs[(int)z] += dur;
+        r.frameCalls[(int)z] += 1;
+    }
+
+    void EndFrame()
+    {
+        ThreadRing& r = localRing();
+        for (int z = 0; z < ZONE_COUNT; ++z) {
+            r.sumNs[z] += r.frameNs[z] - r.histNs[r.histPos][z];
+            r.sumCalls[z] += r.frameCalls[z] - r.histCalls[r.histPos][z];
+            r.histNs[r.histPos][z] = r.frameNs[z];
+            r.histCalls[r.histPos][z] = r.frameCalls[z];
+            r.frameNs[z] = 0;
+            r.frameCalls[z] = 0;
+        }
+        r.histPos = (r.histPos + 1) % AVG_FRAMES;
+        if (r.histFilled < AVG_FRAMES) ++r.histFilled;
+    }
+
+    double AverageMs(Zone z)
+    {
+        const ThreadRing& r = localRing();
+        if (r.histFilled == 0) return 0.0;
+        return (double)r.sumNs[(int)z] / r.histFilled * 1e-6;
+    }
+
+    double AverageCalls(Zone z)
+    {
+        const ThreadRing& r = localRing();
+        if (r.histFilled == 0) return 0.0;
+        return (double)r.sumCalls[(int)z] / r.histFilled;
+    }
+
+    void Totals(Zone z, double& totalMs, uint64_t& calls)
+    {
+        std::lock_guard<std::mutex> lock(g_ringsMutex);
+        uint64_t ns = 0;
+        calls = 0;
+        for (const auto& ring : g_rings) {
+            ns += ring->totalNs[(int)z];
+            calls += ring->totalCalls[(int)z];
+        }
+        totalMs = ns * 1e-6;
+    }
+
+    bool WriteChromeTrace(const char* path)
+    {
+        std::FILE* f = std::fopen(path, "w");
+        if (!f) return false;
+
+        std::lock_guard<std::mutex> lock(g_ringsMutex);
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+        bool first = true;
+        for (const auto& ring : g_rings) {
+            std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"sim %d\"}}",
+                first ? "" : ",\n", ring->tid, ring->tid);
+            first = false;
+
+            const uint64_t n = ring->written < (uint64_t)RING_EVENTS ? ring->written : (uint64_t)RING_EVENTS;
+            for (uint64_t i = ring->written - n; i < ring->written; ++i) {
+                const Event& e = ring->events[(size_t)(i & (RING_EVENTS - 1))];
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"sim\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    ZoneName(e.zone), ring->tid, e.start * 1e-3, e.dur * 1e-3);
+            }
+        }
+        std::fputs("\n]}\n", f);
+        return std::fclose(f) == 0;
+    }
+
+#endif
+
+} // namespace Profiler
+} // namespace Simulation
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+
+// Frame profiler. Build with SIM_PROFILE=1 to enable it; otherwise every
+// SIM_PROFILE_* macro expands to nothing and only ZoneName is compiled.
+//
+// Each thread records into its own fixed-size ring of (zone, start, duration)
+// events, so zones cost two clock reads and a store. Per-zone totals are
+// folded into a rolling window at the end of every frame for the HUD, and the
+// rings can be written out as a Chrome trace_event JSON file
+// (chrome://tracing or https://ui.perfetto.dev).
+
+#ifndef SIM_PROFILE
+#define SIM_PROFILE 0
+#endif
+
+namespace Simulation {
+namespace Profiler {
+
+    enum class Zone : uint8_t {
+        Frame,
+        TickBullets,
+        Perception,
+        CommanderTick,
+        DecideOrders,
+        FsmUpdate,
+        AStar,
+        HpaAbstract,
+        FlowField,
+        PathJob,
+        PathWait,
+        SecurityMap,
+        TeamVisibility,
+        Render,
+        Count
+    };
+
+    constexpr int ZONE_COUNT = (int)Zone::Count;
+    constexpr int RING_EVENTS = 1 << 16;
+    constexpr int AVG_FRAMES = 60;
+
+    const char* ZoneName(Zone z);
+
+#if SIM_PROFILE
+    uint64_t NowNs();
+    void Record(Zone z, uint64_t startNs, uint64_t endNs);
+
+    class Scope {
+    public:
+        explicit Scope(Zone z) : m_zone(z), m_start(NowNs()) {}
+        ~Scope() { Record(m_zone, m_start, NowNs()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Zone m_zone;
+        uint64_t m_start;
+    };
+
+    // Closes the calling thread's frame: this frame's per-zone totals go into
+    // the rolling window read by AverageMs.
+    void EndFrame();
+
+    // Mean milliseconds per frame spent in `z` on the calling thread over the
+    // last AVG_FRAMES frames, and mean calls per frame.
+    double AverageMs(Zone z);
+    double AverageCalls(Zone z);
+
+    // Totals for `z` since start-up, summed over every thread.
+    void Totals(Zone z, double& totalMs, uint64_t& calls);
+
+    // Writes the events still held by every thread's ring. Call it while no
+    // other thread is recording (from the render thread, or after the
+    // workers have joined). Returns false if the file cannot be opened.
+    bool WriteChromeTrace(const char* path);
+#endif
+
+} // namespace Profiler
+} // namespace Simulation
+
+#if SIM_PROFILE
+#define SIM_PROFILE_CONCAT2(a, b) a##b
+#define SIM_PROFILE_CONCAT(a, b) SIM_PROFILE_CONCAT2(a, b)
+#define SIM_PROFILE_ZONE(z) \
+    ::Simulation::Profiler::Scope SIM_PROFILE_CONCAT(simProfZone_, __LINE__)(::Simulation::Profiler::Zone::z)
+#define SIM_PROFILE_END_FRAME() ::Simulation::Profiler::EndFrame()
+#else
+#define SIM_PROFILE_ZONE(z) ((void)0)
+#define SIM_PROFILE_END_FRAME() ((void)0)
+#endif
@@ -0,0 +1,220 @@
+#include "ProjectilePool.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PROJECTILES_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PROJECTILES_SSE2 1
+#endif
+
+using namespace Definitions;
+
+namespace Combat {
+
+    namespace {
+        template <typename T>
+        inline void moveRun(std::vector<T>& v, int from, int to, int n) {
+            std::memmove(v.data() + to, v.data() + from, sizeof(T) * (size_t)n);
+        }
+    } // namespace
+
+    ProjectilePool::ProjectilePool()
+        : m_r(CAPACITY), m_c(CAPACITY), m_or(CAPACITY), m_oc(CAPACITY)
+        , m_dr(CAPACITY), m_dc(CAPACITY), m_row(CAPACITY), m_col(CAPACITY)
+        , m_tMaxR(CAPACITY), m_tMaxC(CAPACITY), m_tDeltaR(CAPACITY), m_tDeltaC(CAPACITY)
+        , m_steps(CAPACITY), m_team(CAPACITY), m_flags(CAPACITY)
+    {
+    }
+
+    bool ProjectilePool::spawn(float r, float c, float dr, float dc, Team team, uint8_t flags) {
+        if (m_size >= CAPACITY) return false;
+        GridRay ray;
+        if (!ray.start(r, c, dr, dc)) return false;
+        const int i = m_size++;
+        m_r[i] = m_or[i] = r;
+        m_c[i] = m_oc[i] = c;
+        m_dr[i] = dr; m_dc[i] = dc;
+        m_row[i] = ray.row; m_col[i] = ray.col;
+        m_tMaxR[i] = ray.tMaxR; m_tMaxC[i] = ray.tMaxC;
+        m_tDeltaR[i] = ray.tDeltaR; m_tDeltaC[i] = ray.tDeltaC;
+        m_steps[i] = 0;
+        m_team[i] = (uint8_t)team;
+        m_flags[i] = flags;
+        return true;
+    }
+
+    // One cell step for every projectile due one, a few lanes at a time.
+    // Whether a ray steps a row or a column next is a coin toss per slot,
+    // so the vector paths select with masks instead of branching; adding
+    // zero to the other axis leaves it bit for bit unchanged, so every
+    // lane matches enterNext. The slots are listed branch-free too: each
+    // lane is written and the count only moves past the ones that crossed.
+    int ProjectilePool::enterCrossing(int n, float speed, const uint8_t* props,
+        int32_t* slots, int32_t* cells, float* tEntry)
+    {
+        const int size = m_size;
+        int i = 0, k = 0;
+#if defined(PROJECTILES_AVX2)
+        {
+            const __m256 vs = _mm256_set1_ps(speed);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256i vn = _mm256_set1_epi32(n);
+            const __m256i two = _mm256_set1_epi32(2), one = _mm256_set1_epi32(1);
+            alignas(32) float t[8];
+            for (; i + 8 <= size; i += 8) {
+                const __m256 tEnd = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_steps.data() + i)), vn)), vs);
+                const __m256 tR = _mm256_loadu_ps(m_tMaxR.data() + i);
+                const __m256 tC = _mm256_loadu_ps(m_tMaxC.data() + i);
+                const __m256 tMin = _mm256_min_ps(tR, tC);
+                const __m256 move = _mm256_cmp_ps(tMin, tEnd, _CMP_LE_OQ);
+                const int bits = _mm256_movemask_ps(move);
+                if (!bits) continue;
+                const __m256 rowFirst = _mm256_cmp_ps(tR, tC, _CMP_LE_OQ);
+                const __m256 byRow = _mm256_and_ps(move, rowFirst);
+                const __m256 byCol = _mm256_andnot_ps(rowFirst, move);
+                _mm256_storeu_ps(m_tMaxR.data() + i, _mm256_add_ps(tR, _mm256_and_ps(byRow, _mm256_loadu_ps(m_tDeltaR.data() + i))));
+                _mm256_storeu_ps(m_tMaxC.data() + i, _mm256_add_ps(tC, _mm256_and_ps(byCol, _mm256_loadu_ps(m_tDeltaC.data() + i))));
+                // +1 where the direction is positive, -1 elsewhere.
+                const __m256i sgnR = _mm256_sub_epi32(_mm256_and_si256(_mm256_castps_si256(
+                    _mm256_cmp_ps(_mm256_loadu_ps(m_dr.data() + i), zero, _CMP_GT_OQ)), two), one);
+                const __m256i sgnC = _mm256_sub_epi32(_mm256_and_si256(_mm256_castps_si256(
+                    _mm256_cmp_ps(_mm256_loadu_ps(m_dc.data() + i), zero, _CMP_GT_OQ)), two), one);
+                __m256i* row = reinterpret_cast<__m256i*>(m_row.data() + i);
+                __m256i* col = reinterpret_cast<__m256i*>(m_col.data() + i);
+                _mm256_storeu_si256(row, _mm256_add_epi32(_mm256_loadu_si256(row), _mm256_and_si256(_mm256_castps_si256(byRow), sgnR)));
+                _mm256_storeu_si256(col, _mm256_add_epi32(_mm256_loadu_si256(col), _mm256_and_si256(_mm256_castps_si256(byCol), sgnC)));
+                _mm256_store_ps(t, tMin);
+                for (int l = 0; l < 8; ++l) {
+                    slots[k] = i + l;
+                    cells[k] = cellOf(i + l, props);
+                    tEntry[k] = t[l];
+                    k += (bits >> l) & 1;
+                }
+            }
+        }
+#elif defined(PROJECTILES_SSE2)
+        {
+            const __m128 vs = _mm_set1_ps(speed);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128i vn = _mm_set1_epi32(n);
+            const __m128i two = _mm_set1_epi32(2), one = _mm_set1_epi32(1);
+            alignas(16) float t[4];
+            for (; i + 4 <= size; i += 4) {
+                const __m128 tEnd = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_steps.data() + i)), vn)), vs);
+                const __m128 tR = _mm_loadu_ps(m_tMaxR.data() + i);
+                const __m128 tC = _mm_loadu_ps(m_tMaxC.data() + i);
+                const __m128 tMin = _mm_min_ps(tR, tC);
+                const __m128 move = _mm_cmple_ps(tMin, tEnd);
+                const int bits = _mm_movemask_ps(move);
+                if (!bits) continue;
+                const __m128 rowFirst = _mm_cmple_ps(tR, tC);
+                const __m128 byRow = _mm_and_ps(move, rowFirst);
+                const __m128 byCol = _mm_andnot_ps(rowFirst, move);
+                _mm_storeu_ps(m_tMaxR.data() + i, _mm_add_ps(tR, _mm_and_ps(byRow, _mm_loadu_ps(m_tDeltaR.data() + i))));
+                _mm_storeu_ps(m_tMaxC.data() + i, _mm_add_ps(tC, _mm_and_ps(byCol, _mm_loadu_ps(m_tDeltaC.data() + i))));
+                // +1 where the direction is positive, -1 elsewhere.
+                const __m128i sgnR = _mm_sub_epi32(_mm_and_si128(_mm_castps_si128(
+                    _mm_cmpgt_ps(_mm_loadu_ps(m_dr.data() + i), zero)), two), one);
+                const __m128i sgnC = _mm_sub_epi32(_mm_and_si128(_mm_castps_si128(
+                    _mm_cmpgt_ps(_mm_loadu_ps(m_dc.data() + i), zero)), two), one);
+                __m128i* row = reinterpret_cast<__m128i*>(m_row.data() + i);
+                __m128i* col = reinterpret_cast<__m128i*>(m_col.data() + i);
+                _mm_storeu_si128(row, _mm_add_epi32(_mm_loadu_si128(row), _mm_and_si128(_mm_castps_si128(byRow), sgnR)));
+                _mm_storeu_si128(col, _mm_add_epi32(_mm_loadu_si128(col), _mm_and_si128(_mm_castps_si128(byCol), sgnC)));
+                _mm_store_ps(t, tMin);
+                for (int l = 0; l < 4; ++l) {
+                    slots[k] = i + l;
+                    cells[k] = cellOf(i + l, props);
+                    tEntry[k] = t[l];
+                    k += (bits >> l) & 1;
+                }
+            }
+        }
+#endif
+        for (; i < size; ++i) {
+            const float tEnd = float(m_steps[i] + n) * speed;
+            const int p = enterNext(i, tEnd, props, tEntry + k);
+            if (p == NOT_YET) continue;
+            slots[k] = i;
+            cells[k] = p;
+            ++k;
+        }
+        return k;
+    }
+
+    // position = origin + (steps * speed) * direction for the whole pool.
+    // The vector paths use separate multiplies and adds, so every lane
+    // matches the scalar tail bit for bit.
+    void ProjectilePool::advanceSteps(int n, float speed) {
+        float* r = m_r.data();
+        float* c = m_c.data();
+        const float* orr = m_or.data();
+        const float* oc = m_oc.data();
+        const float* dr = m_dr.data();
+        const float* dc = m_dc.data();
+        int32_t* steps = m_steps.data();
+        const int size = m_size;
+        int i = 0;
+#if defined(PROJECTILES_AVX2)
+        {
+            const __m256 vs = _mm256_set1_ps(speed);
+            const __m256i vn = _mm256_set1_epi32(n);
+            for (; i + 8 <= size; i += 8) {
+                const __m256i k = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(steps + i)), vn);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(steps + i), k);
+                const __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(k), vs);
+                _mm256_storeu_ps(r + i, _mm256_add_ps(_mm256_loadu_ps(orr + i), _mm256_mul_ps(t, _mm256_loadu_ps(dr + i))));
+                _mm256_storeu_ps(c + i, _mm256_add_ps(_mm256_loadu_ps(oc + i), _mm256_mul_ps(t, _mm256_loadu_ps(dc + i))));
+            }
+        }
+#elif defined(PROJECTILES_SSE2)
+        {
+            const __m128 vs = _mm_set1_ps(speed);
+            const __m128i vn = _mm_set1_epi32(n);
+            for (; i + 4 <= size; i += 4) {
+                const __m128i k = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(steps + i)), vn);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(steps + i), k);
+                const __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(k), vs);
+                _mm_storeu_ps(r + i, _mm_add_ps(_mm_loadu_ps(orr + i), _mm_mul_ps(t, _mm_loadu_ps(dr + i))));
+                _mm_storeu_ps(c + i, _mm_add_ps(_mm_loadu_ps(oc + i), _mm_mul_ps(t, _mm_loadu_ps(dc + i))));
+            }
+        }
+#endif
+        for (; i < size; ++i) {
+            steps[i] += n;
+            const float t = (float)steps[i] * speed;
+            r[i] = orr[i] + t * dr[i];
+            c[i] = oc[i] + t * dc[i];
+        }
+    }
+
+    void ProjectilePool::compact(const uint8_t* keep) {
+        // Few projectiles die per tick, so survivors come in long runs;
+        // slide each run down as a block rather than slot by slot.
+        int w = 0, i = 0;
+        while (i < m_size) {
+            while (i < m_size && !keep[i]) ++i;
+            const int from = i;
+            while (i < m_size && keep[i]) ++i;
+            const int n = i - from;
+            if (n > 0 && w != from) {
+                moveRun(m_r, from, w, n); moveRun(m_c, from, w, n);
+                moveRun(m_or, from, w, n); moveRun(m_oc, from, w, n);
+                moveRun(m_dr, from, w, n); moveRun(m_dc, from, w, n);
+                moveRun(m_row, from, w, n); moveRun(m_col, from, w, n);
+                moveRun(m_tMaxR, from, w, n); moveRun(m_tMaxC, from, w, n);
+                moveRun(m_tDeltaR, from, w, n); moveRun(m_tDeltaC, from, w, n);
+                moveRun(m_steps, from, w, n);
+                moveRun(m_team, from, w, n); moveRun(m_flags, from, w, n);
+            }
+            w += n;
+        }
+        m_size = w;
+    }
+
+} // namespace Combat
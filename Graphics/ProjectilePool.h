@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+#include "GridRay.h"
+
+namespace Combat {
+
+    // Bullets and shrapnel as parallel arrays (structure of arrays) with a
+    // fixed capacity. Slots [0, size()) are live and kept in spawn order:
+    // the order bullets are resolved in decides who is hit first.
+    //
+    // Positions are in grid space (cell (r,c) covers [r, r+1) x [c, c+1)).
+    // A projectile flies a ray from where it was spawned and walks the
+    // cells it crosses with a GridRay, so any distance
+    // per step is safe: nothing it passes through is skipped. Time along
+    // the ray is distance travelled; after `steps` ticks a projectile has
+    // reached t = steps * speed, computed from the integer step count so
+    // that sweeping N ticks at once ends exactly where N single ticks do.
+    class ProjectilePool {
+    public:
+        static constexpr int CAPACITY = 8192;
+
+        enum Flag : uint8_t { SHRAPNEL = 1 };
+
+        // enterNext results besides a padded cell index.
+        static constexpr int NOT_YET = GridRay::NOT_YET;
+        static constexpr int STOPPED = GridRay::STOPPED;
+
+        ProjectilePool();
+
+        int  size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        void clear() { m_size = 0; }
+
+        // `dr`,`dc` must be a unit vector. False (and nothing spawned) when
+        // the pool is full or the start lies off the grid.
+        bool spawn(float r, float c, float dr, float dc, Definitions::Team team, uint8_t flags);
+
+        // Steps every projectile whose ray reaches a new cell within the
+        // next `n` ticks into that cell (the rest only move inside their
+        // own). Writes those slots to `slots`, each one's padded cell index
+        // or STOPPED to `cells` and its entry distance to `tEntry`, and
+        // returns how many there are.
+        int enterCrossing(int n, float speed, const uint8_t* props,
+            int32_t* slots, int32_t* cells, float* tEntry);
+
+        // True if projectile i reaches another cell by tEnd.
+        inline bool crossesBy(int i, float tEnd) const { return std::min(m_tMaxR[i], m_tMaxC[i]) <= tEnd; }
+
+        // Crosses into the next cell on projectile i's ray if the ray gets
+        // there by tEnd. Returns its padded index (and the distance along
+        // the ray in `tEntry`), NOT_YET, or STOPPED.
+        inline int enterNext(int i, float tEnd, const uint8_t* props, float* tEntry) {
+            float t;
+            if (m_tMaxR[i] <= m_tMaxC[i]) {
+                t = m_tMaxR[i];
+                if (t > tEnd) return NOT_YET;
+                m_row[i] += m_dr[i] > 0.f ? 1 : -1;
+                m_tMaxR[i] += m_tDeltaR[i];
+            }
+            else {
+                t = m_tMaxC[i];
+                if (t > tEnd) return NOT_YET;
+                m_col[i] += m_dc[i] > 0.f ? 1 : -1;
+                m_tMaxC[i] += m_tDeltaC[i];
+            }
+            *tEntry = t;
+            return cellOf(i, props);
+        }
+
+        // Adds `n` ticks to every projectile's step count and moves the
+        // drawn positions to match.
+        void advanceSteps(int n, float speed);
+
+        // Drops every slot whose `keep` entry is zero, preserving order.
+        void compact(const uint8_t* keep);
+
+        inline float r(int i) const  { return m_r[i]; }
+        inline float c(int i) const  { return m_c[i]; }
+        inline float originR(int i) const { return m_or[i]; }
+        inline float originC(int i) const { return m_oc[i]; }
+        inline float dirR(int i) const { return m_dr[i]; }
+        inline float dirC(int i) const { return m_dc[i]; }
+        inline int   steps(int i) const { return m_steps[i]; }
+        inline int   cell(int i) const { return Models::Grid::padIndex(m_row[i], m_col[i]); }
+        inline Definitions::Team team(int i) const { return (Definitions::Team)m_team[i]; }
+        inline bool  isShrapnel(int i) const { return (m_flags[i] & SHRAPNEL) != 0; }
+
+    private:
+        // Projectile i's padded cell index, or STOPPED if it is off the grid
+        // or in a shot-blocking cell.
+        inline int cellOf(int i, const uint8_t* props) const {
+            const int row = m_row[i], col = m_col[i];
+            if (row < 0 || row >= Definitions::GRID_SIZE || col < 0 || col >= Definitions::GRID_SIZE) return STOPPED;
+            const int p = Models::Grid::padIndex(row, col);
+            return (props[p] & Models::PlaneBit(Models::Plane::BlocksShot)) ? STOPPED : p;
+        }
+
+        // Drawn position, ray origin and direction.
+        std::vector<float>   m_r, m_c, m_or, m_oc, m_dr, m_dc;
+        // GridRay state, one array per field.
+        std::vector<int32_t> m_row, m_col;
+        std::vector<float>   m_tMaxR, m_tMaxC, m_tDeltaR, m_tDeltaC;
+        std::vector<int32_t> m_steps;
+        std::vector<uint8_t> m_team, m_flags;
+        int m_size = 0;
+    };
+
+} // namespace Combat
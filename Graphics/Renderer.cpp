@@ -226,14 +226,12 @@ namespace Painting {
             for (int c = 0; c < GRID_SIZE; ++c)
                 drawCellIcon(grid, r, c, grid.at(r, c));
 
-        const auto& A = smap.data();
-        const float M = std::max(0.001f, smap.maxValue());
+        const auto& N = smap.normalized();
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         for (int r = 0; r < GRID_SIZE; ++r) {
             for (int c = 0; c < GRID_SIZE; ++c) {
-                float t = A[r][c] / M;
-                t = std::min(1.f, std::max(0.f, t));
+                const float t = N[r][c];
                 int x = cellX(c), y = cellY(r);
                 glColor4f(0.05f, 0.8f, 0.2f, 0.28f * t);
                 glBegin(GL_QUADS);
@@ -251,7 +249,7 @@ namespace Painting {
 
     void RenderFrameWithVisibility(const Models::Grid& grid,
         const std::vector<Models::Unit*>& units,
-        const AI::Visibility::BArray& vis,
+        const AI::VisMask& vis,
         const std::vector<std::string>& hudLines)
     {
         glClear(GL_COLOR_BUFFER_BIT);
@@ -261,7 +259,7 @@ namespace Painting {
                 int v = grid.at(r, c);
                 drawCellIcon(grid, r, c, v);
 
-                if (!vis[r][c]) {
+                if (!vis.test(r, c)) {
                     int x = cellX(c), y = cellY(r);
                     glColor4f(0.f, 0.f, 0.f, 0.45f);
                     glBegin(GL_QUADS);
@@ -324,14 +322,12 @@ namespace Painting {
             for (int c = 0; c < GRID_SIZE; ++c)
                 drawCellIcon(grid, r, c, grid.at(r, c));
 
-        const auto& A = smap.data();
-        const float M = std::max(0.001f, smap.maxValue());
+        const auto& N = smap.normalized();
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         for (int r = 0; r < GRID_SIZE; ++r) {
             for (int c = 0; c < GRID_SIZE; ++c) {
-                float t = A[r][c] / M;
-                t = std::min(1.f, std::max(0.f, t));
+                const float t = N[r][c];
                 int x = cellX(c), y = cellY(r);
                 glColor4f(0.05f, 0.8f, 0.2f, 0.28f * t);
                 glBegin(GL_QUADS);
@@ -352,7 +348,7 @@ namespace Painting {
 
     void RenderFrameWithVisibility_Overlay(const Models::Grid& grid,
         const std::vector<Models::Unit*>& units,
-        const AI::Visibility::BArray& vis,
+        const AI::VisMask& vis,
         const std::vector<std::string>& hudLines,
         OverlayDrawFn overlay)
     {
@@ -363,7 +359,7 @@ namespace Painting {
                 int v = grid.at(r, c);
                 drawCellIcon(grid, r, c, v);
 
-                if (!vis[r][c]) {
+                if (!vis.test(r, c)) {
                     int x = cellX(c), y = cellY(r);
                     glColor4f(0.f, 0.f, 0.f, 0.45f);
                     glBegin(GL_QUADS);
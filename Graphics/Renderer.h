@@ -28,7 +28,7 @@ namespace Painting {
 
     void RenderFrameWithVisibility(const Models::Grid& grid,
         const std::vector<Models::Unit*>& units,
-        const AI::Visibility::BArray& vis,
+        const AI::VisMask& vis,
         const std::vector<std::string>& hudLines);
 
     using OverlayDrawFn = void(*)();
@@ -50,7 +50,7 @@ namespace Painting {
 
     void RenderFrameWithVisibility_Overlay(const Models::Grid& grid,
         const std::vector<Models::Unit*>& units,
-        const AI::Visibility::BArray& vis,
+        const AI::VisMask& vis,
         const std::vector<std::string>& hudLines,
         OverlayDrawFn overlay);
 }
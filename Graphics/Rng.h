@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+
+namespace Simulation {
+
+    // Small PCG32 generator. Unlike std::rand and the <random> distributions
+    // its output is fully specified, so one seed gives the same sequence on
+    // every compiler and standard library.
+    class Rng {
+    public:
+        explicit Rng(uint64_t seed = 0, uint64_t stream = 0) { reseed(seed, stream); }
+
+        inline void reseed(uint64_t seed, uint64_t stream = 0) {
+            m_state = 0;
+            m_inc = (stream << 1u) | 1u;
+            next();
+            m_state += seed;
+            next();
+        }
+
+        inline uint32_t next() {
+            const uint64_t old = m_state;
+            m_state = old * 6364136223846793005ULL + m_inc;
+            const uint32_t xs = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+            const uint32_t rot = (uint32_t)(old >> 59u);
+            return (xs >> rot) | (xs << ((32u - rot) & 31u));
+        }
+
+        inline uint32_t operator()() { return next(); }
+
+        // Uniform in [0, n). n must be > 0.
+        inline int below(int n) {
+            return (int)(((uint64_t)next() * (uint32_t)n) >> 32);
+        }
+
+        // Uniform in [lo, hi], inclusive.
+        inline int range(int lo, int hi) { return lo + below(hi - lo + 1); }
+
+        inline bool chance(float p) {
+            return (float)(next() >> 8) * (1.0f / 16777216.0f) < p;
+        }
+
+    private:
+        uint64_t m_state = 0;
+        uint64_t m_inc = 1;
+    };
+
+    // One independent stream per subsystem, all derived from the match's
+    // master seed. Adding draws in one subsystem leaves the others untouched.
+    struct RngStreams {
+        Rng map;     // obstacle placement
+        Rng spawn;   // warrior spawn cells and team anchors
+        Rng ai;      // commander anchor search and other AI tie-breaks
+
+        inline void seed(uint32_t master) {
+            map.reseed(master, 1);
+            spawn.reseed(master, 2);
+            ai.reseed(master, 3);
+        }
+    };
+
+} // namespace Simulation
@@ -1,4 +1,5 @@
 ﻿#include "SecurityMap.h"
+#include "Profiler.h"
 #include <algorithm>
 #include <cmath>
 #include <utility> 
@@ -13,15 +14,40 @@ namespace Simulation {
 
     void SecurityMap::clear() {
         for (auto& row : smap_) row.fill(0.0f);
+        touch();
     }
 
     void SecurityMap::fill(float v) {
         for (auto& row : smap_) row.fill(v);
+        touch();
     }
 
     void SecurityMap::add(int r, int c, float v) {
         if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) return;
+        const bool maxWasValid = (maxVersion_ == version_);
         smap_[r][c] += v;
+        touch();
+        // Positive deposits can only raise the max, so keep it valid without a rescan.
+        if (maxWasValid && v >= 0.0f) {
+            if (smap_[r][c] > max_) max_ = smap_[r][c];
+            maxVersion_ = version_;
+        }
+    }
+
+    void SecurityMap::addPadded(const int32_t* cells, int n, float v) {
+        if (n <= 0) return;
+        const bool maxWasValid = (maxVersion_ == version_);
+        float m = max_;
+        for (int i = 0; i < n; ++i) {
+            float& cell = smap_[Models::Grid::padRow(cells[i])][Models::Grid::padCol(cells[i])];
+            cell += v;
+            m = std::max(m, cell);
+        }
+        touch();
+        if (maxWasValid && v >= 0.0f) {
+            max_ = m;
+            maxVersion_ = version_;
+        }
     }
 
     float SecurityMap::at(int r, int c) const {
@@ -29,12 +55,43 @@ namespace Simulation {
         return smap_[r][c];
     }
 
-    float SecurityMap::maxValue() const {
+    void SecurityMap::refreshMax() const {
+        if (maxVersion_ == version_) return;
         float m = 0.0f;
         for (int r = 0; r < GRID_SIZE; ++r)
             for (int c = 0; c < GRID_SIZE; ++c)
                 m = std::max(m, smap_[r][c]);
-        return (m <= 0.0f ? 1.0f : m);
+        max_ = m;
+        maxVersion_ = version_;
+    }
+
+    float SecurityMap::maxValue() const {
+        refreshMax();
+        return (max_ <= 0.0f ? 1.0f : max_);
+    }
+
+    const SecurityMap::SArray& SecurityMap::normalized() const {
+        if (normVersion_ == version_) return norm_;
+
+        const float m = maxValue();
+        for (int r = 0; r < GRID_SIZE; ++r)
+            for (int c = 0; c < GRID_SIZE; ++c) {
+                const float v = smap_[r][c];
+                norm_[r][c] = (v <= 0.0f ? 0.0f : std::min(1.0f, v / m));
+                normPadded_[Models::Grid::padIndex(r, c)] = norm_[r][c];
+            }
+        normVersion_ = version_;
+        return norm_;
+    }
+
+    const float* SecurityMap::normalizedPadded() const {
+        normalized();
+        return normPadded_.data();
+    }
+
+    float SecurityMap::normAt(int r, int c) const {
+        if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) return 0.0f;
+        return normalized()[r][c];
     }
 
     void SecurityMap::traceRay(const Models::Grid& grid,
@@ -85,6 +142,7 @@ namespace Simulation {
 
     void SecurityMap::RebuildSecurityMap(const Models::Grid& grid)
     {
+        SIM_PROFILE_ZONE(SecurityMap);
         clear();
 
         const int S = SECURITY_SAMPLES;             
@@ -142,6 +200,8 @@ namespace Simulation {
             std::pair<float, float> v2 = unitVec(0.0f, -1.0f);
             traceRay(grid, r0, cR, v2.first, v2.second, basePower * 0.6f, ttl / 2);
         }
+
+        touch();
     }
 
 } // namespace Sim
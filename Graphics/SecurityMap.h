@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <array>
+#include <cstdint>
 #include "Definitions.h"
 #include "Grid.h"
 
@@ -17,13 +18,26 @@ namespace Simulation {
         void RebuildSecurityMap(const Models::Grid& grid);
 
         void add(int r, int c, float v);
+        // add(v) once per entry of `cells`, given as Grid::padIndex cells
+        // on the grid; repeats are added once each.
+        void addPadded(const int32_t* cells, int n, float v);
         float at(int r, int c) const;
         int   size() const { return Definitions::GRID_SIZE; }
 
+        // Every mutation bumps the version; the max and the normalized plane
+        // are recomputed lazily, at most once per version.
+        uint32_t version() const { return version_; }
+
         float maxValue() const;
 
+        // Risk scaled to [0,1] by the current max (0 outside the grid).
+        float normAt(int r, int c) const;
+        const SArray& normalized() const;
+        // The normalized plane in Grid's padded layout (zero border), for
+        // kernels that walk Grid::padIndex cells.
+        const float* normalizedPadded() const;
+
         const SArray& data() const { return smap_; }
-        SArray& data() { return smap_; }
 
     private:
         void traceRay(const Models::Grid& grid,
@@ -32,8 +46,18 @@ namespace Simulation {
             float power,              
             int   maxSteps);           
 
+        void touch() { ++version_; }
+        void refreshMax() const;
+
     private:
         SArray smap_{};
+        uint32_t version_ = 1;
+
+        mutable float    max_ = 1.0f;
+        mutable uint32_t maxVersion_ = 0;
+        mutable SArray   norm_{};
+        mutable std::array<float, Models::Grid::PADDED_CELLS> normPadded_{};
+        mutable uint32_t normVersion_ = 0;
     };
 
 } // namespace Sim
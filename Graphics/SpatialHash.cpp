@@ -0,0 +1,218 @@
+#include "SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+#include "Units.h"
+
+namespace Simulation {
+
+    namespace {
+
+        inline float cellDist2(const Models::Unit& u, int r, int c) {
+            const int dr = u.row - r, dc = u.col - c;
+            return float(dr * dr + dc * dc);
+        }
+
+        // (d2, id) ordering used by every "closest" query.
+        inline bool closer(float d2a, int ida, float d2b, int idb) {
+            return d2a < d2b || (d2a == d2b && ida < idb);
+        }
+
+        // No cell of a bucket `ring` buckets away (Chebyshev) is closer
+        // than this to any cell of the centre bucket.
+        inline float ringLowerBound(int ring) {
+            if (ring <= 0) return 0.f;
+            const float gap = float((ring - 1) * SpatialHash::BUCKET + 1);
+            return gap * gap;
+        }
+
+        inline int clampBucket(int b) { return std::max(0, std::min(SpatialHash::SIDE - 1, b)); }
+
+        inline bool ringOutside(int br, int bc, int ring) {
+            return br - ring < 0 && br + ring >= SpatialHash::SIDE &&
+                   bc - ring < 0 && bc + ring >= SpatialHash::SIDE;
+        }
+
+        struct Hit { float d2; int id; Models::Unit* u; };
+        inline bool hitOrder(const Hit& a, const Hit& b) { return closer(a.d2, a.id, b.d2, b.id); }
+
+        inline bool swapErase(std::vector<Models::Unit*>& v, Models::Unit* u) {
+            auto it = std::find(v.begin(), v.end(), u);
+            if (it == v.end()) return false;
+            *it = v.back();
+            v.pop_back();
+            return true;
+        }
+
+    } // namespace
+
+    template <typename F>
+    void SpatialHash::visitBuckets(uint8_t teams, int br0, int br1, int bc0, int bc1, F&& f) const {
+        br0 = clampBucket(br0); br1 = clampBucket(br1);
+        bc0 = clampBucket(bc0); bc1 = clampBucket(bc1);
+        for (int t = 0; t < 2; ++t) {
+            if (!(teams & (1u << t))) continue;
+            for (int br = br0; br <= br1; ++br)
+                for (int bc = bc0; bc <= bc1; ++bc)
+                    for (Models::Unit* u : m_buckets[t][br * SIDE + bc]) f(u);
+        }
+    }
+
+    template <typename F>
+    void SpatialHash::visitRing(uint8_t teams, int br, int bc, int ring, F&& f) const {
+        if (ring == 0) { visitBuckets(teams, br, br, bc, bc, f); return; }
+        auto cell = [&](int i, int j) {
+            if (i < 0 || i >= SIDE || j < 0 || j >= SIDE) return;
+            for (int t = 0; t < 2; ++t) {
+                if (!(teams & (1u << t))) continue;
+                for (Models::Unit* u : m_buckets[t][i * SIDE + j]) f(u);
+            }
+        };
+        for (int j = bc - ring; j <= bc + ring; ++j) { cell(br - ring, j); cell(br + ring, j); }
+        for (int i = br - ring + 1; i <= br + ring - 1; ++i) { cell(i, bc - ring); cell(i, bc + ring); }
+    }
+
+    template <typename F>
+    void SpatialHash::visitAll(uint8_t teams, F&& f) const {
+        for (int t = 0; t < 2; ++t) {
+            if (!(teams & (1u << t))) continue;
+            for (Models::Unit* u : m_all[t]) f(u);
+        }
+    }
+
+    void SpatialHash::clear() {
+        for (auto& team : m_buckets)
+            for (auto& b : team) b.clear();
+        for (auto& team : m_all) team.clear();
+        m_size = 0;
+    }
+
+    void SpatialHash::rebuild(const std::vector<Models::Unit*>& units) {
+        clear();
+        for (auto* u : units) {
+            if (u && u->isAlive) add(*u);
+        }
+    }
+
+    void SpatialHash::insert(Models::Unit& u, int r, int c) {
+        if (!inBounds(r, c)) return;
+        m_buckets[(int)u.team][bucketOf(r, c)].push_back(&u);
+        m_all[(int)u.team].push_back(&u);
+        ++m_size;
+    }
+
+    void SpatialHash::erase(Models::Unit& u, int r, int c) {
+        if (!inBounds(r, c)) return;
+        if (!swapErase(m_buckets[(int)u.team][bucketOf(r, c)], &u)) return;
+        swapErase(m_all[(int)u.team], &u);
+        --m_size;
+    }
+
+    void SpatialHash::add(Models::Unit& u) { insert(u, u.row, u.col); }
+
+    void SpatialHash::remove(Models::Unit& u) { erase(u, u.row, u.col); }
+
+    void SpatialHash::move(Models::Unit& u, int fromR, int fromC) {
+        if (inBounds(fromR, fromC) && inBounds(u.row, u.col)) {
+            const int from = bucketOf(fromR, fromC), to = bucketOf(u.row, u.col);
+            if (from == to) return;
+            auto& team = m_buckets[(int)u.team];
+            if (swapErase(team[from], &u)) team[to].push_back(&u);
+            return;
+        }
+        erase(u, fromR, fromC);
+        insert(u, u.row, u.col);
+    }
+
+    int SpatialHash::countWithin(uint8_t teams, int r, int c, float radius2) const {
+        if (radius2 < 0.f) return 0;
+        int n = 0;
+        auto test = [&](const Models::Unit* u) { if (cellDist2(*u, r, c) <= radius2) ++n; };
+        if (m_size <= LINEAR_MAX) { visitAll(teams, test); return n; }
+        const int reach = (int)std::floor(std::sqrt(radius2));
+        if (r + reach < 0 || c + reach < 0) return 0;
+        visitBuckets(teams, (r - reach) / BUCKET, (r + reach) / BUCKET,
+            (c - reach) / BUCKET, (c + reach) / BUCKET, test);
+        return n;
+    }
+
+    bool SpatialHash::anyWithin(uint8_t teams, int r, int c, float radius2) const {
+        return nearest(teams, r, c, radius2) != nullptr;
+    }
+
+    Models::Unit* SpatialHash::nearest(uint8_t teams, int r, int c, float maxD2, float* outD2) const {
+        Models::Unit* best = nullptr;
+        float bestD2 = std::numeric_limits<float>::infinity();
+        auto consider = [&](Models::Unit* u) {
+            const float d2 = cellDist2(*u, r, c);
+            if (d2 > maxD2) return;
+            if (!best || closer(d2, u->id, bestD2, best->id)) { best = u; bestD2 = d2; }
+        };
+        if (m_size <= LINEAR_MAX) {
+            visitAll(teams, consider);
+        }
+        else {
+            const int br = clampBucket(r / BUCKET), bc = clampBucket(c / BUCKET);
+            for (int ring = 0; !ringOutside(br, bc, ring); ++ring) {
+                const float lb = ringLowerBound(ring);
+                if (lb > maxD2 || (best && lb > bestD2)) break;
+                visitRing(teams, br, bc, ring, consider);
+            }
+        }
+        if (outD2) *outD2 = bestD2;
+        return best;
+    }
+
+    int SpatialHash::nearestK(uint8_t teams, int r, int c, int k, Models::Unit** out) const {
+        if (k <= 0) return 0;
+        static thread_local std::vector<Hit> hits;
+        hits.clear();
+        auto collect = [&](Models::Unit* u) { hits.push_back({ cellDist2(*u, r, c), u->id, u }); };
+        if (m_size <= LINEAR_MAX) {
+            visitAll(teams, collect);
+        }
+        else {
+            const int br = clampBucket(r / BUCKET), bc = clampBucket(c / BUCKET);
+            for (int ring = 0; !ringOutside(br, bc, ring); ++ring) {
+                if ((int)hits.size() >= k) {
+                    std::nth_element(hits.begin(), hits.begin() + (k - 1), hits.end(), hitOrder);
+                    if (ringLowerBound(ring) > hits[k - 1].d2) break;
+                }
+                visitRing(teams, br, bc, ring, collect);
+            }
+        }
+        const int n = std::min(k, (int)hits.size());
+        if ((int)hits.size() > n) std::nth_element(hits.begin(), hits.begin() + (n - 1), hits.end(), hitOrder);
+        std::sort(hits.begin(), hits.begin() + n, hitOrder);
+        for (int i = 0; i < n; ++i) out[i] = hits[i].u;
+        return n;
+    }
+
+    Models::Unit* SpatialHash::at(uint8_t teams, int r, int c) const {
+        if (!inBounds(r, c)) return nullptr;
+        Models::Unit* best = nullptr;
+        auto test = [&](Models::Unit* u) {
+            if (u->row == r && u->col == c && (!best || u->id < best->id)) best = u;
+        };
+        if (m_size <= LINEAR_MAX) visitAll(teams, test);
+        else visitBuckets(teams, r / BUCKET, r / BUCKET, c / BUCKET, c / BUCKET, test);
+        return best;
+    }
+
+    void SpatialHash::gather(uint8_t teams, float r, float c, float radius,
+        std::vector<Models::Unit*>& out) const
+    {
+        out.clear();
+        const int r0 = (int)std::floor(r - radius), r1 = (int)std::ceil(r + radius);
+        const int c0 = (int)std::floor(c - radius), c1 = (int)std::ceil(c + radius);
+        if (r1 < 0 || c1 < 0 || r0 >= Definitions::GRID_SIZE || c0 >= Definitions::GRID_SIZE) return;
+        auto test = [&](Models::Unit* u) {
+            if (u->row >= r0 && u->row <= r1 && u->col >= c0 && u->col <= c1) out.push_back(u);
+        };
+        if (m_size <= LINEAR_MAX) visitAll(teams, test);
+        else visitBuckets(teams, std::max(r0, 0) / BUCKET, r1 / BUCKET,
+            std::max(c0, 0) / BUCKET, c1 / BUCKET, test);
+        std::sort(out.begin(), out.end(),
+            [](const Models::Unit* a, const Models::Unit* b) { return a->id < b->id; });
+    }
+
+} // namespace Simulation
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include "Definitions.h"
+
+namespace Models { class Unit; }
+
+namespace Simulation {
+
+    // Uniform-grid index of living units by team, for proximity questions
+    // (who is within a radius, who is closest, who stands on a cell). Kept
+    // in step with OccupancyGrid: Unit::moveTo and Unit::kill update both,
+    // and Match rebuilds both after spawning.
+    //
+    // Queries take a team mask (only(), enemiesOf(), ANY). Wherever several
+    // units qualify, results come in id order, which is World::units order,
+    // so routing a full scan through the index does not change its outcome.
+    class SpatialHash {
+    public:
+        static constexpr int BUCKET = 8;    // cells per bucket edge
+        static constexpr int SIDE = (Definitions::GRID_SIZE + BUCKET - 1) / BUCKET;
+        static constexpr uint8_t ANY = 3;
+        // Up to this many live units, queries scan the per-team lists; the
+        // buckets only pay off once the map is crowded.
+        static constexpr int LINEAR_MAX = 64;
+
+        static constexpr uint8_t only(Definitions::Team t) { return (uint8_t)(1u << (int)t); }
+        static constexpr uint8_t enemiesOf(Definitions::Team t) { return (uint8_t)(ANY & ~only(t)); }
+
+        void clear();
+        void rebuild(const std::vector<Models::Unit*>& units);
+
+        void add(Models::Unit& u);
+        void remove(Models::Unit& u);
+        void move(Models::Unit& u, int fromR, int fromC);
+
+        // Units with dr*dr + dc*dc <= radius2 from cell (r,c).
+        int  countWithin(uint8_t teams, int r, int c, float radius2) const;
+        bool anyWithin(uint8_t teams, int r, int c, float radius2) const;
+
+        // Closest unit by squared cell distance, ties to the lowest id;
+        // nullptr when none is within maxD2.
+        Models::Unit* nearest(uint8_t teams, int r, int c,
+            float maxD2 = std::numeric_limits<float>::infinity(), float* outD2 = nullptr) const;
+
+        // Up to k closest units, nearest first (ties by id); returns how
+        // many were written to `out`.
+        int nearestK(uint8_t teams, int r, int c, int k, Models::Unit** out) const;
+
+        // Lowest-id unit standing on the cell.
+        Models::Unit* at(uint8_t teams, int r, int c) const;
+
+        // Units whose cell lies within `radius` (per axis) of the point
+        // (r,c) in cell coordinates, sorted by id. The caller applies its
+        // own exact distance test.
+        void gather(uint8_t teams, float r, float c, float radius,
+            std::vector<Models::Unit*>& out) const;
+
+        int size() const { return m_size; }
+        // Every indexed unit of one team, in no particular order.
+        const std::vector<Models::Unit*>& members(Definitions::Team t) const { return m_all[(int)t]; }
+
+    private:
+        static inline int bucketOf(int r, int c) { return (r / BUCKET) * SIDE + (c / BUCKET); }
+        static inline bool inBounds(int r, int c) {
+            return r >= 0 && r < Definitions::GRID_SIZE && c >= 0 && c < Definitions::GRID_SIZE;
+        }
+
+        void insert(Models::Unit& u, int r, int c);
+        void erase(Models::Unit& u, int r, int c);
+
+        // Calls f(unit) for units of `teams` in buckets [br0..br1] x [bc0..bc1]
+        // (clamped to the grid), on the edge of the square `ring` buckets
+        // out from (br,bc), or in the per-team lists.
+        template <typename F>
+        void visitBuckets(uint8_t teams, int br0, int br1, int bc0, int bc1, F&& f) const;
+        template <typename F>
+        void visitRing(uint8_t teams, int br, int bc, int ring, F&& f) const;
+        template <typename F>
+        void visitAll(uint8_t teams, F&& f) const;
+
+        std::vector<Models::Unit*> m_buckets[2][SIDE * SIDE];
+        std::vector<Models::Unit*> m_all[2];
+        int m_size = 0;
+    };
+
+} // namespace Simulation
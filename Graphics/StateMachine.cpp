@@ -1,5 +1,7 @@
 #include "StateMachine.h"
 #include "State.h"
+#include "Log.h"
+#include "Profiler.h"
 #include <cstdio>
 
 namespace AI {
@@ -31,13 +33,14 @@ namespace AI {
     }
 
     void StateMachine::Update() {
+        SIM_PROFILE_ZONE(FsmUpdate);
         if (!m_owner || isPoisonPtr(m_owner)) {
-            std::printf("[FSM] WARNING: owner is null/poison, skipping Update.\n");
+            SIM_LOG("[FSM] WARNING: owner is null/poison, skipping Update.\n");
             return;
         }
         if (!m_currentState || isPoisonPtr(m_currentState)) {
 
-            std::printf("[FSM] WARNING: current state is null/poison for Unit#%d. Skipping Update.\n",
+            SIM_LOG("[FSM] WARNING: current state is null/poison for Unit#%d. Skipping Update.\n",
                 m_owner ? m_owner->id : -1);
             return;
         }
@@ -47,13 +50,13 @@ namespace AI {
 
     void StateMachine::ChangeState(State* newState) {
         if (!m_owner || isPoisonPtr(m_owner)) {
-            std::printf("[FSM] WARNING: ChangeState on invalid owner. Ignored.\n");
+            SIM_LOG("[FSM] WARNING: ChangeState on invalid owner. Ignored.\n");
             if (newState && !isPoisonPtr(newState)) delete newState;
             return;
         }
 
         if (newState == m_currentState) {
-            std::printf("[FSM] NOTE: ChangeState called with same state object. Ignored.\n");
+            SIM_LOG("[FSM] NOTE: ChangeState called with same state object. Ignored.\n");
             return;
         }
 
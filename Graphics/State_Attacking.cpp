@@ -5,9 +5,10 @@
 #include "Visibility.h"
 #include "Pathfinding.h"
 #include "Combat.h"
-#include "Globals.h"
+#include "World.h"
 #include "State_Idle.h"
 #include "State_RetreatingToCover.h"
+#include "Log.h"
 
 #include <cmath>
 #include <limits>
@@ -27,28 +28,7 @@ namespace {
 namespace AI {
 
     static inline bool enemyAtCell(const Models::Unit& me, int r, int c) {
-        for (const auto* u : g_units) {
-            if (!u->isAlive || u->team == me.team) continue;
-            if (u->row == r && u->col == c) return true;
-        }
-        return false;
-    }
-
-    static bool acquireVisibleEnemy(const Models::Unit& me, int& outR, int& outC) {
-        const int R2 = Definitions::SIGHT_RANGE * Definitions::SIGHT_RANGE;
-        float bestD2 = std::numeric_limits<float>::infinity();
-        int br = -1, bc = -1;
-        for (const auto* other : g_units) {
-            if (!other->isAlive || other->team == me.team) continue;
-            int dr = other->row - me.row;
-            int dc = other->col - me.col;
-            float d2 = float(dr * dr + dc * dc);
-            if (d2 > R2 || d2 >= bestD2) continue;
-            if (!AI::Visibility::HasLineOfSight(g_grid, me.row, me.col, other->row, other->col)) continue;
-            bestD2 = d2; br = other->row; bc = other->col;
-        }
-        if (br != -1) { outR = br; outC = bc; return true; }
-        return false;
+        return me.world->proximity.at(Simulation::SpatialHash::enemiesOf(me.team), r, c) != nullptr;
     }
 
     State_Attacking::State_Attacking(int targetR, int targetC, Combat::System* combatSys, int attackRange, int cooldown)
@@ -60,7 +40,7 @@ namespace AI {
         , m_cooldownTimer(0)
     {
         if (!m_combatSystem) {
-            std::printf("Warning: State_Attacking created without valid Combat::System pointer!\n");
+            SIM_LOG("Warning: State_Attacking created without valid Combat::System pointer!\n");
         }
     }
 
@@ -70,7 +50,7 @@ namespace AI {
         unit->isMoving = false;
 
         int vr = -1, vc = -1;
-        if (acquireVisibleEnemy(*unit, vr, vc)) {
+        if (unit->world->perception.bestVisibleEnemy(*unit, vr, vc)) {
             m_targetR = vr; m_targetC = vc;
         }
     }
@@ -88,13 +68,7 @@ namespace AI {
         int r = r0, c = c0;
         while (true) {
             if (!((r == r0 && c == c0) || (r == r1 && c == c1))) {
-                for (const auto* u : g_units) {
-                    if (!u->isAlive) continue;
-                    if (u->team != shooter->team) continue;
-                    if (u->row == r && u->col == c) {
-                        return true;
-                    }
-                }
+                if (shooter->world->occupancy.occupiedByTeam(r, c, shooter->team)) return true;
             }
 
             if (r == r1 && c == c1) break;
@@ -113,13 +87,7 @@ namespace AI {
 
         if (unit->stats.ammo <= 0) return false;
 
-        Models::Unit* targetPtr = nullptr;
-        for (auto* u : g_units) {
-            if (u->isAlive && u->row == m_targetR && u->col == m_targetC) {
-                targetPtr = u;
-                break;
-            }
-        }
+        Models::Unit* targetPtr = unit->world->proximity.at(Simulation::SpatialHash::ANY, m_targetR, m_targetC);
         if (!targetPtr) return false;
         if (targetPtr->team == unit->team) return false;
 
@@ -129,7 +97,7 @@ namespace AI {
         const int range2 = m_attackRangeCells * m_attackRangeCells;
         if (dist2 > range2) return false;
 
-        if (!AI::Visibility::HasLineOfSight(g_grid, unit->row, unit->col, m_targetR, m_targetC))
+        if (!AI::Visibility::HasLineOfSight(unit->world->grid, unit->row, unit->col, m_targetR, m_targetC))
             return false;
 
         if (FriendlyInLine(unit, m_targetR, m_targetC))
@@ -147,49 +115,37 @@ namespace AI {
         const int d2 = dr * dr + dc * dc;
         if (d2 > kGrenadeThrowRangeCells * kGrenadeThrowRangeCells) return false;
 
-        const bool hasLOS = AI::Visibility::HasLineOfSight(g_grid, self->row, self->col, m_targetR, m_targetC);
+        const bool hasLOS = AI::Visibility::HasLineOfSight(self->world->grid, self->row, self->col, m_targetR, m_targetC);
         if (!hasLOS) return true;
 
-        const int nearby = CountEnemiesNear(m_targetR, m_targetC, kGrenadeBlastRadius, self->team);
+        const int nearby = CountEnemiesNear(*self->world, m_targetR, m_targetC, kGrenadeBlastRadius, self->team);
         return (nearby >= kMinEnemiesForGrenade);
     }
 
-    int State_Attacking::CountEnemiesNear(int r, int c, int radius, Definitions::Team myTeam) const {
-        int count = 0;
-        const int rmin = std::max(0, r - radius);
-        const int rmax = std::min(Definitions::GRID_SIZE - 1, r + radius);
-        const int cmin = std::max(0, c - radius);
-        const int cmax = std::min(Definitions::GRID_SIZE - 1, c + radius);
-
-        for (const auto* other : g_units) {
-            if (!other->isAlive || other->team == myTeam) continue;
-            if (other->row < rmin || other->row > rmax || other->col < cmin || other->col > cmax) continue;
-            const int dr = other->row - r;
-            const int dc = other->col - c;
-            if (dr * dr + dc * dc <= radius * radius) ++count;
-        }
-        return count;
+    int State_Attacking::CountEnemiesNear(const Simulation::World& world, int r, int c, int radius, Definitions::Team myTeam) const {
+        return world.proximity.countWithin(Simulation::SpatialHash::enemiesOf(myTeam), r, c, float(radius * radius));
     }
 
     void State_Attacking::DoThrowGrenade(Models::Unit* self) {
         if (!self || self->stats.grenades <= 0) return;
 
-        std::printf("Unit %d throws GRENADE to (%d,%d)\n", self->id, m_targetR, m_targetC);
-
-        for (auto* other : g_units) {
-            if (!other->isAlive || other->team == self->team) continue;
+        SIM_LOG("Unit %d throws GRENADE to (%d,%d)\n", self->id, m_targetR, m_targetC);
 
+        std::vector<Models::Unit*> nearby;
+        self->world->proximity.gather(Simulation::SpatialHash::enemiesOf(self->team),
+            (float)m_targetR, (float)m_targetC, (float)kGrenadeBlastRadius, nearby);
+        for (auto* other : nearby) {
             const int dr = other->row - m_targetR;
             const int dc = other->col - m_targetC;
             if (dr * dr + dc * dc <= kGrenadeBlastRadius * kGrenadeBlastRadius) {
                 other->stats.hp -= kGrenadeDamage;
                 if (other->stats.hp <= 0) {
                     other->stats.hp = 0;
-                    other->isAlive = false;
-                    std::printf("Unit %d killed by grenade.\n", other->id);
+                    other->kill();
+                    SIM_LOG("Unit %d killed by grenade.\n", other->id);
                 }
                 else {
-                    std::printf("Unit %d damaged by grenade. HP now %d\n", other->id, other->stats.hp);
+                    SIM_LOG("Unit %d damaged by grenade. HP now %d\n", other->id, other->stats.hp);
                 }
             }
         }
@@ -202,7 +158,7 @@ namespace AI {
         if (!unit || !unit->isAlive || !unit->m_fsm || !m_combatSystem) return;
 
         int vr = -1, vc = -1;
-        if (acquireVisibleEnemy(*unit, vr, vc)) {
+        if (unit->world->perception.bestVisibleEnemy(*unit, vr, vc)) {
             m_targetR = vr; m_targetC = vc;
         }
 
@@ -225,11 +181,11 @@ namespace AI {
                     );
                     unit->stats.ammo--;
                     m_cooldownTimer = m_attackCooldownFrames;
-                    std::printf("Unit %d fired. Ammo left: %d\n", unit->id, unit->stats.ammo);
+                    SIM_LOG("Unit %d fired. Ammo left: %d\n", unit->id, unit->stats.ammo);
                 }
                 else {
-                    std::printf("Unit %d (Attacking): Out of ammo!\n", unit->id);
-                    AI::EventBus::instance().publish(AI::Message{
+                    SIM_LOG("Unit %d (Attacking): Out of ammo!\n", unit->id);
+                    unit->world->bus.publish(AI::Message{
                         AI::EventType::LowAmmo, unit->id, -1, unit->row, unit->col, unit->stats.ammo
                         });
                     unit->m_fsm->ChangeState(new State_RetreatingToCover());
@@ -240,12 +196,13 @@ namespace AI {
 
         AI::Pathfinding::Cell destination = { -1, -1 };
         AI::Pathfinding::Cell vantagePoint = AI::Pathfinding::PickVantagePoint(
-            g_grid, g_smap,
+            unit->world->grid, unit->world->smap,
             { unit->row, unit->col },
             { m_targetR, m_targetC },
             m_attackRangeCells,
             0.15f,
-            10
+            10,
+            &unit->world->connectivity
         );
 
         if (vantagePoint.first != -1) destination = vantagePoint;
@@ -257,14 +214,14 @@ namespace AI {
 
         AI::Pathfinding::Path potentialPath = AI::Pathfinding::AStar_FindPath(
             unit,
-            g_grid, g_smap,
+            unit->world->grid, unit->world->smap,
             { unit->row, unit->col },
             destination,
             5.5f
         );
 
         if (potentialPath.empty()) {
-            std::printf("Unit %d (Attacking): No path to (%d,%d). Switching to Idle.\n",
+            SIM_LOG("Unit %d (Attacking): No path to (%d,%d). Switching to Idle.\n",
                 unit->id, destination.first, destination.second);
             delete nextStateOnArrival;
             nextStateOnArrival = nullptr;
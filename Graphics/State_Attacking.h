@@ -4,6 +4,7 @@
 #include "Combat.h"
 
 namespace Models { class Unit; }
+namespace Simulation { class World; }
 
 namespace AI {
 
@@ -31,7 +32,7 @@ namespace AI {
         bool CanShoot(Models::Unit* unit);
 
         bool ShouldThrowGrenade(const Models::Unit* self) const;
-        int  CountEnemiesNear(int r, int c, int radius, Definitions::Team myTeam) const;
+        int  CountEnemiesNear(const Simulation::World& world, int r, int c, int radius, Definitions::Team myTeam) const;
         void DoThrowGrenade(Models::Unit* self);
     };
 
@@ -4,10 +4,10 @@
 #include "Units.h"
 #include "StateMachine.h"
 #include "Pathfinding.h"
-#include "Globals.h"      
+#include "BucketQueue.h"
+#include "World.h"      
 #include "Definitions.h"
 
-#include <queue>
 #include <vector>
 #include <algorithm>
 #include <cstdio>
@@ -18,73 +18,75 @@ namespace AI {
         return r >= 0 && r < Definitions::GRID_SIZE && c >= 0 && c < Definitions::GRID_SIZE;
     }
 
-    static bool hasBlockingNeighbor(const Models::Grid& grid, int r, int c) {
-        using namespace Definitions;
-        static const int dr[4] = { +1,-1,0,0 };
-        static const int dc[4] = { 0,0,+1,-1 };
-        for (int k = 0; k < 4; ++k) {
-            int rr = r + dr[k], cc = c + dc[k];
-            if (!inBounds(rr, cc)) continue;
-            int cell = grid.at(rr, cc);
-            if (cell == ROCK || cell == TREE) return true;
-        }
-        return false;
-    }
-
-    static bool isCoverCell(const Models::Grid& grid, int r, int c, float riskNorm, float riskThreshold) {
-        if (!AI::Pathfinding::IsWalkableForMovement(grid.at(r, c))) return false;
-        if (AI::Pathfinding::IsOccupied(r, c)) return false;
+    static bool isCoverCell(const Models::Grid& grid, const Simulation::OccupancyGrid& occ,
+        int r, int c, float riskNorm, float riskThreshold) {
+        // Walkable and next to a rock or tree, in one test of the property byte.
+        const uint8_t need = Models::PlaneBit(Models::Plane::Walkable) | Models::PlaneBit(Models::Plane::CoverAdjacent);
+        if ((grid.props(r, c) & need) != need) return false;
+        if (AI::Pathfinding::IsOccupied(occ, r, c)) return false;
         if (riskNorm > riskThreshold) return false;
-        if (!hasBlockingNeighbor(grid, r, c)) return false;
         return true;
     }
 
+    // Cover cells outside the label `reachable` (when non-zero) are skipped.
     static bool BFS_FindCoverAround(const Models::Grid& grid,
         const Simulation::SecurityMap& smap,
+        const Simulation::OccupancyGrid& occ,
+        const AI::Pathfinding::Connectivity& conn, int reachable,
+        const AI::Pathfinding::CoverField& cover,
         int anchorR, int anchorC,
         int radius,
         float riskThreshold,
         int& outR, int& outC)
     {
-        using namespace Definitions;
+        using Models::Grid;
+        using Nb = AI::Pathfinding::Neighbourhood<4>;
         outR = outC = -1;
         if (!inBounds(anchorR, anchorC)) return false;
-        const float maxRisk = std::max(0.001f, smap.maxValue());
-        const int N = GRID_SIZE;
-        static std::vector<uint8_t> visited;
-        visited.assign(N * N, 0);
-        auto idx = [N](int r, int c) { return r * N + c; };
-        struct Node { int r, c, d; };
-        std::queue<Node> q;
-        q.push({ anchorR, anchorC, 0 });
-        visited[idx(anchorR, anchorC)] = 1;
-        const int dr[4] = { +1, -1, 0, 0 };
-        const int dc[4] = { 0, 0, +1, -1 };
-        {
-            float riskNorm = smap.at(anchorR, anchorC) / maxRisk;
-            if (isCoverCell(grid, anchorR, anchorC, riskNorm, riskThreshold)) {
-                outR = anchorR; outC = anchorC;
-                return true;
-            }
+        // No rock or tree close enough for any cell in range to touch one.
+        if (!cover.coverWithin(anchorR, anchorC, radius)) return false;
+
+        // Padded layout with the border pre-marked as visited, so the ring
+        // walk never leaves the grid and needs no bounds checks.
+        static const std::vector<uint8_t> unvisited = [] {
+            std::vector<uint8_t> v(Grid::PADDED_CELLS, 1);
+            for (int r = 0; r < Definitions::GRID_SIZE; ++r)
+                for (int c = 0; c < Definitions::GRID_SIZE; ++c)
+                    v[Grid::padIndex(r, c)] = 0;
+            return v;
+        }();
+        static thread_local std::vector<uint8_t> visited;
+        visited = unvisited;
+        const float* risk = smap.normalizedPadded();
+
+        struct Node { int p, d; };
+        // Keyed on ring distance, so cells come out in plain BFS order.
+        static thread_local AI::Pathfinding::BucketQueue<Node> q(4);
+        q.clear();
+        const int anchorP = Grid::padIndex(anchorR, anchorC);
+        q.push(0, { anchorP, 0 });
+        visited[anchorP] = 1;
+        if (isCoverCell(grid, occ, anchorR, anchorC, risk[anchorP], riskThreshold) &&
+            (reachable == 0 || conn.label(anchorR, anchorC) == reachable)) {
+            outR = anchorR; outC = anchorC;
+            return true;
         }
         while (!q.empty()) {
-            Node cur = q.front(); q.pop();
+            const Node cur = q.pop();
             if (cur.d >= radius) continue;
-            for (int k = 0; k < 4; ++k) {
-                int nr = cur.r + dr[k];
-                int nc = cur.c + dc[k];
-                if (!inBounds(nr, nc)) continue;
-                int id = idx(nr, nc);
-                if (visited[id]) continue;
-                visited[id] = 1;
-                int manhattan = std::abs(nr - anchorR) + std::abs(nc - anchorC);
+            for (int k = 0; k < Nb::COUNT; ++k) {
+                const int n = cur.p + Nb::offset(k);
+                if (visited[n]) continue;
+                visited[n] = 1;
+                const int nr = Grid::padRow(n), nc = Grid::padCol(n);
+                const int manhattan = std::abs(nr - anchorR) + std::abs(nc - anchorC);
                 if (manhattan > radius) continue;
-                float riskNorm = smap.at(nr, nc) / maxRisk;
-                if (isCoverCell(grid, nr, nc, riskNorm, riskThreshold)) {
+                if (isCoverCell(grid, occ, nr, nc, risk[n], riskThreshold) &&
+                    (reachable == 0 || conn.label(nr, nc) == reachable)) {
                     outR = nr; outC = nc;
                     return true;
                 }
-                q.push({ nr, nc, cur.d + 1 });
+                q.push(cur.d + 1, { n, cur.d + 1 });
             }
         }
         return false;
@@ -97,7 +99,9 @@ namespace AI {
         int targetR = -1, targetC = -1;
 
         bool foundSpot = BFS_FindCoverAround(
-            g_grid, g_smap,
+            unit->world->grid, unit->world->smap, unit->world->occupancy,
+            unit->world->connectivity, unit->world->connectivity.label(unit->row, unit->col),
+            unit->world->cover,
             anchorR, anchorC,
             defendRadius,
             riskThreshold,
@@ -115,7 +119,7 @@ namespace AI {
         }
         else {
             if (inBounds(anchorR, anchorC) &&
-                AI::Pathfinding::IsWalkableForMovement(g_grid.at(anchorR, anchorC)))
+                !unit->world->connectivity.unreachable(unit->row, unit->col, anchorR, anchorC))
             {
                 unit->m_fsm->ChangeState(new State_MovingToTarget(anchorR, anchorC, new State_Idle()));
             }
@@ -1,5 +1,6 @@
 #pragma once
 #include "State.h"
+#include "Definitions.h"
 
 namespace Models { class Unit; }
 
@@ -14,7 +15,7 @@ namespace AI {
         float m_riskThreshold;
 
     public:
-        State_Defending(int anchorR, int anchorC, int radius = 6, float riskThreshold = 0.25f);
+        State_Defending(int anchorR, int anchorC, int radius = Definitions::DEFEND_COVER_RADIUS, float riskThreshold = 0.25f);
         virtual ~State_Defending() {}
 
         void Enter(Models::Unit* unit) override;
@@ -4,18 +4,14 @@
 #include "StateMachine.h"
 #include "Units.h"
 #include "Definitions.h"
-#include "Globals.h"
+#include "World.h"
 #include "Pathfinding.h"
+#include "Log.h"
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 
 namespace {
-    inline Models::Unit* findUnitById(int uid) {
-        if (uid <= 0) return nullptr;
-        for (auto& u : g_units) if (u->id == uid) return u;
-        return nullptr;
-    }
     inline int manhattan(int r1, int c1, int r2, int c2) { return std::abs(r1 - r2) + std::abs(c1 - c2); }
 }
 
@@ -29,19 +25,21 @@ namespace AI {
         if (!self) return false;
 
         if (path.empty() || i >= path.size()) {
-            path = AI::Pathfinding::AStar_FindPath(
-                self, g_grid, g_smap,
-                { self->row, self->col },
-                { goalR, goalC },
-                AI::Pathfinding::RiskWeightForUnit(self)
-            );
+            // Stand still until the queued search comes back.
+            if (ticket == 0) ticket = self->world->paths.request(self, { goalR, goalC });
+            const AI::Pathfinding::JobStatus st = self->world->paths.take(ticket, path);
+            if (st == AI::Pathfinding::JobStatus::Pending) return true;
+            ticket = 0;
             i = 0;
-            if (path.empty()) return false;
+            // A partial path gets the unit closer; the next request starts from its end.
+            if (st != AI::Pathfinding::JobStatus::Ready && st != AI::Pathfinding::JobStatus::Partial) {
+                path.clear();
+                return false;
+            }
         }
 
         const auto next = path[i++];
-        self->row = next.first;
-        self->col = next.second;
+        self->moveTo(next.first, next.second);
         return true;
     }
 
@@ -58,7 +56,7 @@ namespace AI {
         tgt->stats.hp = std::min(Definitions::HP_MAX, tgt->stats.hp + canGive);
         self->roleData.currentHealPool = std::max(0, self->roleData.currentHealPool - canGive);
 
-        std::printf("Medic #%d -> Unit #%d : +%d HP (pool left: %d)\n",
+        SIM_LOG("Medic #%d -> Unit #%d : +%d HP (pool left: %d)\n",
             self->id, tgt->id, canGive, self->roleData.currentHealPool);
 
         return true;
@@ -76,7 +74,7 @@ namespace AI {
     void State_Healing::Update(Models::Unit* unit) {
         if (!unit || !unit->m_fsm) return;
 
-        Models::Unit* tgt = findUnitById(m_targetUnitId);
+        Models::Unit* tgt = unit->world->findUnit(m_targetUnitId);
         if (!tgt || !tgt->isAlive) {
             unit->m_fsm->ChangeState(new State_Idle());
             return;
@@ -1,7 +1,7 @@
 #include "State_Idle.h"
 #include "Definitions.h"
 #include "Units.h"
-#include "Globals.h"
+#include "World.h"
 #include "StateMachine.h"
 #include "Pathfinding.h"
 #include "Visibility.h"
@@ -12,6 +12,7 @@
 #include "State_Supplying.h"
 #include "State_RefillAtDepot.h"
 #include "State_Healing.h"
+#include "Log.h"
 
 #include <limits>
 #include <cmath>
@@ -26,7 +27,7 @@ namespace AI {
         int bestTargetId = -1;
         int bestDist2 = std::numeric_limits<int>::max();
 
-        for (auto* u : g_units) {
+        for (auto* u : self->world->units) {
             if (!u || !u->isAlive) continue;
             if (u->team != self->team) continue;
             if (u->id == self->id) continue;
@@ -64,39 +65,15 @@ namespace AI {
         if (unit->role == Definitions::Role::Warrior && unit->isAutonomous)
         {
             if (unit->hpNorm() * 100.0f < Definitions::HP_CRITICAL) {
-                std::printf("[Warrior %d] Autonomous: Critically injured! Retreating!\n", unit->id);
+                SIM_LOG("[Warrior %d] Autonomous: Critically injured! Retreating!\n", unit->id);
                 unit->m_fsm->ChangeState(new State_RetreatingToCover());
                 return;
             }
 
-            int   nearest_er = -1, nearest_ec = -1;
-            float bestScore = std::numeric_limits<float>::infinity();
-            const int SIGHT_RANGE_SQ = Definitions::SIGHT_RANGE * Definitions::SIGHT_RANGE;
-
-            for (const auto* other : g_units) {
-                if (!other || !other->isAlive || other->team == unit->team) continue;
-                int dr = other->row - unit->row;
-                int dc = other->col - unit->col;
-                float d2 = float(dr * dr + dc * dc);
-                if (d2 >= SIGHT_RANGE_SQ) continue;
-
-                if (AI::Visibility::HasLineOfSight(g_grid, unit->row, unit->col, other->row, other->col)) {
-                    float score = d2;
-                    int enemyCell = g_grid.at(other->row, other->col);
-                    if (enemyCell == Definitions::Cell::TREE) {
-                        score *= Definitions::TREE_COVER_PENALTY_MULTIPLIER;
-                    }
-                    if (score < bestScore) {
-                        bestScore = score;
-                        nearest_er = other->row;
-                        nearest_ec = other->col;
-                    }
-                }
-            }
-
-            if (nearest_er != -1) {
-                std::printf("[Warrior %d] Autonomous: Target acquired! Attacking!\n", unit->id);
-                unit->m_fsm->ChangeState(new State_Attacking(nearest_er, nearest_ec, &g_combat));
+            int nearest_er = -1, nearest_ec = -1;
+            if (unit->world->perception.bestVisibleEnemy(*unit, nearest_er, nearest_ec, AI::Perception::Pick::PreferOpen)) {
+                SIM_LOG("[Warrior %d] Autonomous: Target acquired! Attacking!\n", unit->id);
+                unit->m_fsm->ChangeState(new State_Attacking(nearest_er, nearest_ec, &unit->world->combat));
                 return;
             }
             return;
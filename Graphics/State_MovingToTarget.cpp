@@ -1,10 +1,11 @@
 #include "State_MovingToTarget.h"
 #include "State_Idle.h"
 #include "Units.h"
-#include "Globals.h"              
+#include "World.h"              
 #include "Pathfinding.h"          
 #include "StateMachine.h"
 #include "Definitions.h"
+#include "Log.h"
 
 #include <cstdio>
 #include <algorithm>
@@ -12,21 +13,15 @@
 
 namespace AI {
 
-    static void ReplanAStar(Models::Unit* unit, int targetR, int targetC) {
-        unit->m_currentPath = AI::Pathfinding::AStar_FindPath(
-            unit,
-            g_grid,
-            g_smap,
-            { unit->row, unit->col },
-            { targetR, targetC },
-            AI::Pathfinding::RiskWeightForUnit(unit)
-        );
+    static AI::Pathfinding::Ticket RequestPath(Models::Unit* unit, int targetR, int targetC,
+        AI::Pathfinding::Planner planner = AI::Pathfinding::Planner::Auto) {
+        return unit->world->paths.request(unit, { targetR, targetC }, planner);
     }
 
-    static inline bool IsLegalStep(int r, int c) {
+    static inline bool IsLegalStep(const Models::Grid& grid, int r, int c) {
         if (r < 0 || r >= Definitions::GRID_SIZE || c < 0 || c >= Definitions::GRID_SIZE)
             return false;
-        return AI::Pathfinding::IsWalkableForMovement(g_grid.at(r, c));
+        return grid.walkable(r, c);
     }
 
 
@@ -57,18 +52,38 @@ namespace AI {
         unit->isMoving = true;
         m_stepCounter = 0;
         unit->m_currentPath.clear();
+        m_replanReason = "";
+        m_partial = false;
+        m_ticket = RequestPath(unit, m_targetR, m_targetC);
+    }
 
-        ReplanAStar(unit, m_targetR, m_targetC);
-
-        if (unit->m_currentPath.empty()) {
-            printf("Unit %d: No path found to target (%d,%d) in Enter. Switching to Idle.\n", unit->id, m_targetR, m_targetC);
-            if (m_onArrivalState) {
-                delete m_onArrivalState;
-                m_onArrivalState = nullptr;
-            }
+    bool State_MovingToTarget::collectPath(Models::Unit* unit)
+    {
+        AI::Pathfinding::Path path;
+        const AI::Pathfinding::JobStatus st = unit->world->paths.take(m_ticket, path);
+        if (st == AI::Pathfinding::JobStatus::Pending) return true;
+        m_ticket = 0;
+
+        if (st != AI::Pathfinding::JobStatus::Ready && st != AI::Pathfinding::JobStatus::Partial) {
+            SIM_LOG("Unit %d: No path found to target (%d,%d)%s%s. Switching to Idle.\n",
+                unit->id, m_targetR, m_targetC, *m_replanReason ? " after replan: " : "", m_replanReason);
+            if (m_onArrivalState) { delete m_onArrivalState; m_onArrivalState = nullptr; }
             unit->m_fsm->ChangeState(new State_Idle());
-            return;
+            return false;
         }
+
+        // The search started from where the unit stood a tick ago; drop the
+        // part it has walked since, or ask again if it left the new route.
+        const AI::Pathfinding::Cell here{ unit->row, unit->col };
+        auto it = std::find(path.begin(), path.end(), here);
+        if (it == path.end()) {
+            m_ticket = RequestPath(unit, m_targetR, m_targetC);
+            return true;
+        }
+        path.erase(path.begin(), it);
+        unit->m_currentPath.swap(path);
+        m_partial = (st == AI::Pathfinding::JobStatus::Partial);
+        return true;
     }
 
     void State_MovingToTarget::Update(Models::Unit* unit)
@@ -76,13 +91,23 @@ namespace AI {
         if (!unit || !unit->m_fsm) return;
 
         if (unit->role == Definitions::Role::Supplier) {
-            static int supplierMoveCounter = 0;
+            static thread_local int supplierMoveCounter = 0;
             if (supplierMoveCounter++ % 30 == 0) {
-                printf("DEBUG: Unit %d (Supplier) in MovingToTarget::Update. currentAmmo = %d\n", unit->id, unit->roleData.currentAmmo);
+                SIM_LOG("DEBUG: Unit %d (Supplier) in MovingToTarget::Update. currentAmmo = %d\n", unit->id, unit->roleData.currentAmmo);
             }
         }
 
+        if (m_ticket != 0 && !collectPath(unit)) return;
+        if (m_ticket != 0 && unit->m_currentPath.size() <= 1) return;   // nothing to walk until it is back
+
         if (unit->m_currentPath.size() <= 1) {
+            if (m_partial && (unit->row != m_targetR || unit->col != m_targetC)) {
+                // End of a partial path: search on from here. An unreachable
+                // target comes back Failed once no closer cell is left.
+                m_partial = false;
+                m_ticket = RequestPath(unit, m_targetR, m_targetC);
+                return;
+            }
             State* nextState = m_onArrivalState;
             m_onArrivalState = nullptr;
             unit->m_fsm->ChangeState(nextState);
@@ -99,63 +124,54 @@ namespace AI {
         int nextR = nextStep.first;
         int nextC = nextStep.second;
 
-        bool needsReplan = false;
-        const char* replanReason = "";
+        bool blocked = false;
+        bool occupiedStep = false;
+        const char* replanReason = nullptr;
 
-        if (!IsLegalStep(nextR, nextC)) {
-            needsReplan = true;
+        if (!IsLegalStep(unit->world->grid, nextR, nextC)) {
+            blocked = true;
             replanReason = "Illegal Step";
         }
-        else if (AI::Pathfinding::IsOccupied(nextR, nextC)) {
+        else if (AI::Pathfinding::IsOccupied(unit->world->occupancy, nextR, nextC)) {
             if (nextR == m_targetR && nextC == m_targetC) {
                 int dist = std::abs(unit->row - m_targetR) + std::abs(unit->col - m_targetC);
                 if (dist == 1) {
-                    printf("Unit %d: Arrived adjacent to occupied target (%d,%d). Switching state.\n", unit->id, m_targetR, m_targetC);
+                    SIM_LOG("Unit %d: Arrived adjacent to occupied target (%d,%d). Switching state.\n", unit->id, m_targetR, m_targetC);
                     State* nextState = m_onArrivalState;
                     m_onArrivalState = nullptr;
                     unit->m_fsm->ChangeState(nextState);
                     return;
                 }
             }
-            needsReplan = true;
+            blocked = true;
+            occupiedStep = true;
             replanReason = "Occupied";
         }
         else
         {
             constexpr int SAMPLE_LEN = 8;
             float riskMaxNorm = AI::Pathfinding::PathRiskSample(
-                g_smap, unit->m_currentPath, SAMPLE_LEN, true);
+                unit->world->smap, unit->m_currentPath, SAMPLE_LEN, true);
 
             if (riskMaxNorm >= Definitions::REPLAN_RISK_DELTA) {
-                needsReplan = true;
                 replanReason = "High Risk";
             }
         }
 
-        if (needsReplan) {
-            ReplanAStar(unit, m_targetR, m_targetC);
-
-            if (unit->m_currentPath.empty()) {
-                printf("Unit %d: No path found to target (%d,%d) after replan [%s]. Switching to Idle.\n", unit->id, m_targetR, m_targetC, replanReason);
-                if (m_onArrivalState) { delete m_onArrivalState; m_onArrivalState = nullptr; }
-                unit->m_fsm->ChangeState(new State_Idle());
-                return;
-            }
-
-            if (unit->m_currentPath.size() <= 1) {
-                return;
-            }
-
-            nextR = unit->m_currentPath[1].first;
-            nextC = unit->m_currentPath[1].second;
-
-            if (!IsLegalStep(nextR, nextC) || AI::Pathfinding::IsOccupied(nextR, nextC)) {
-                return;
-            }
+        if (replanReason && m_ticket == 0) {
+            // The flow field ignores occupancy, so blocked steps search around
+            // the blocker instead.
+            m_replanReason = replanReason;
+            m_ticket = RequestPath(unit, m_targetR, m_targetC, occupiedStep
+                ? AI::Pathfinding::Planner::Hierarchical
+                : AI::Pathfinding::Planner::Auto);
         }
 
-        unit->row = nextR;
-        unit->col = nextC;
+        // A risky route is still walkable: keep following it until the new
+        // one arrives. A blocked step waits.
+        if (blocked) return;
+
+        unit->moveTo(nextR, nextC);
 
         if (!unit->m_currentPath.empty()) {
             unit->m_currentPath.erase(unit->m_currentPath.begin());
@@ -168,6 +184,8 @@ namespace AI {
         if (!unit) return;
         unit->isMoving = false;
         unit->m_currentPath.clear();
+        unit->world->paths.cancel(m_ticket);
+        m_ticket = 0;
     }
 
 } // namespace AI
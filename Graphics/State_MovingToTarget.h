@@ -11,6 +11,12 @@ namespace AI {
         State* m_onArrivalState;
         int m_framesPerStep;
         int m_stepCounter;
+        Pathfinding::Ticket m_ticket = 0;
+        const char* m_replanReason = "";
+        bool m_partial = false;   // current path stops short of the target
+
+        // Picks up a queued search. Returns false if the state was left.
+        bool collectPath(Models::Unit* unit);
 
     public:
         State_MovingToTarget(int r, int c, State* onArrivalState, int framesPerMove = 6);
@@ -5,18 +5,14 @@
 #include "StateMachine.h"
 #include "Units.h"
 #include "Definitions.h"
-#include "Globals.h"
+#include "World.h"
 #include "Pathfinding.h"
 #include "Grid.h"
+#include "Log.h"
 #include <cstdio>
 #include <cstdlib>
 
 namespace {
-    inline Models::Unit* findUnitById(int uid) {
-        if (uid <= 0) return nullptr;
-        for (auto& u : g_units) if (u->id == uid) return u;
-        return nullptr;
-    }
     inline int manhattan(int r1, int c1, int r2, int c2) { return std::abs(r1 - r2) + std::abs(c1 - c2); }
 }
 
@@ -29,24 +25,26 @@ namespace AI {
     bool State_RefillAtDepot::Navigator::step(Models::Unit* self, int goalR, int goalC) {
         if (!self) return false;
         if (path.empty() || i >= path.size()) {
-            path = AI::Pathfinding::AStar_FindPath(
-                self, g_grid, g_smap,
-                { self->row, self->col },
-                { goalR, goalC },
-                AI::Pathfinding::RiskWeightForUnit(self)
-            );
+            // Stand still until the queued search comes back.
+            if (ticket == 0) ticket = self->world->paths.request(self, { goalR, goalC });
+            const AI::Pathfinding::JobStatus st = self->world->paths.take(ticket, path);
+            if (st == AI::Pathfinding::JobStatus::Pending) return true;
+            ticket = 0;
             i = 0;
-            if (path.empty()) return false;
+            // A partial path gets the unit closer; the next request starts from its end.
+            if (st != AI::Pathfinding::JobStatus::Ready && st != AI::Pathfinding::JobStatus::Partial) {
+                path.clear();
+                return false;
+            }
         }
         const auto next = path[i++];
-        self->row = next.first;
-        self->col = next.second;
+        self->moveTo(next.first, next.second);
         return true;
     }
 
     bool State_RefillAtDepot::findDepotCell(Models::Unit* self, int& r, int& c) const {
         if (!self) return false;
-        const auto& lm = g_grid.landmarks();
+        const auto& lm = self->world->grid.landmarks();
         if (m_unitRole == Definitions::Role::Medic) {
             if (self->team == Definitions::Team::Blue) { r = lm.medBlue.first;  c = lm.medBlue.second;  return true; }
             else { r = lm.medOrange.first; c = lm.medOrange.second; return true; }
@@ -64,13 +62,13 @@ namespace AI {
             int add = self->isFighting ? Definitions::MEDIC_REFILL_AMOUNT_FIGHTING
                 : Definitions::MEDIC_REFILL_AMOUNT;
             self->roleData.currentHealPool += add;
-            std::printf("Medic #%d: Refilled +%d (pool=%d)\n", self->id, add, self->roleData.currentHealPool);
+            SIM_LOG("Medic #%d: Refilled +%d (pool=%d)\n", self->id, add, self->roleData.currentHealPool);
         }
         else if (m_unitRole == Definitions::Role::Supplier) {
             int add = self->isFighting ? Definitions::SUPPLIER_REFILL_AMOUNT_FIGHTING
                 : Definitions::SUPPLIER_REFILL_AMOUNT;
             self->roleData.currentAmmo += add;
-            std::printf("Supplier #%d: Refilled +%d (stock=%d)\n", self->id, add, self->roleData.currentAmmo);
+            SIM_LOG("Supplier #%d: Refilled +%d (stock=%d)\n", self->id, add, self->roleData.currentAmmo);
         }
     }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include "State.h"
 #include "Definitions.h"
 #include "Pathfinding.h"
@@ -13,7 +14,8 @@ namespace AI {
         struct Navigator {
             std::vector<AI::Pathfinding::Cell> path;
             size_t i = 0;
-            void reset() { path.clear(); i = 0; }
+            AI::Pathfinding::Ticket ticket = 0;
+            void reset() { path.clear(); i = 0; ticket = 0; }
             bool step(Models::Unit* self, int goalR, int goalC);
         } nav;
 
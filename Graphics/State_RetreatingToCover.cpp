@@ -4,9 +4,10 @@
 #include "StateMachine.h"
 #include "Units.h"
 #include "Pathfinding.h"
-#include "Globals.h"
+#include "World.h"
 #include "Definitions.h"
 #include "Visibility.h"
+#include "Log.h"
 
 #include <vector>
 #include <limits>
@@ -18,38 +19,9 @@ struct CoverCandidate {
     float score;
 };
 
-static bool isAdjacentToRock(int r, int c) {
-    const int dr[] = { -1, 1, 0, 0, -1, -1, 1, 1 };
-    const int dc[] = { 0, 0, -1, 1, -1, 1, -1, 1 };
-
-    for (int i = 0; i < 8; ++i) {
-        int nr = r + dr[i];
-        int nc = c + dc[i];
-        if (nr >= 0 && nr < Definitions::GRID_SIZE && nc >= 0 && nc < Definitions::GRID_SIZE) {
-            if (g_grid.at(nr, nc) == Definitions::ROCK) {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
 static const Models::Unit* findNearestEnemy(const Models::Unit* self) {
-    const Models::Unit* nearestEnemy = nullptr;
-    float min_dist_sq = std::numeric_limits<float>::infinity();
-
-    for (const auto* other : g_units) {
-        if (other->isAlive && other->team != self->team) {
-            float dr = other->row - self->row;
-            float dc = other->col - self->col;
-            float dist_sq = dr * dr + dc * dc;
-            if (dist_sq < min_dist_sq) {
-                min_dist_sq = dist_sq;
-                nearestEnemy = other;
-            }
-        }
-    }
-    return nearestEnemy;
+    return self->world->proximity.nearest(
+        Simulation::SpatialHash::enemiesOf(self->team), self->row, self->col);
 }
 
 
@@ -63,7 +35,9 @@ namespace AI {
         const int sc = unit->col;
 
         const Models::Unit* nearestEnemy = findNearestEnemy(unit);
-        const float maxRisk = std::max(0.001f, g_smap.maxValue());
+        const Models::Grid& grid = unit->world->grid;
+        const Simulation::SecurityMap& smap = unit->world->smap;
+        const AI::Pathfinding::CoverField& cover = unit->world->cover;
 
         std::vector<CoverCandidate> rockCandidates;
         std::vector<CoverCandidate> safeCandidates;
@@ -71,15 +45,19 @@ namespace AI {
         for (int r = sr - RADIUS; r <= sr + RADIUS; ++r) {
             for (int c = sc - RADIUS; c <= sc + RADIUS; ++c) {
                 if (r < 0 || r >= Definitions::GRID_SIZE || c < 0 || c >= Definitions::GRID_SIZE) continue;
-                if (!AI::Pathfinding::IsWalkableForMovement(g_grid.at(r, c))) continue;
-                if (AI::Pathfinding::IsOccupiedByOther(r, c, unit->id)) continue;
+                if (!grid.walkable(r, c)) continue;
+                if (AI::Pathfinding::IsOccupiedByOther(unit->world->occupancy, r, c, unit->id)) continue;
 
-                float riskScore = g_smap.at(r, c) / maxRisk;
+                float riskScore = smap.normAt(r, c);
                 float dist = std::sqrt(std::pow(r - sr, 2) + std::pow(c - sc, 2));
                 float distScore = dist / RADIUS;
 
-                if (isAdjacentToRock(r, c)) {
-                    float losPenalty = (nearestEnemy && AI::Visibility::HasLineOfSight(g_grid, r, c, nearestEnemy->row, nearestEnemy->col)) ? 1.0f : 0.0f;
+                if (cover.rockAdjacent(r, c)) {
+                    // A rock on the side facing the enemy settles it without walking the ray.
+                    const bool seen = nearestEnemy &&
+                        !cover.coveredFrom(r, c, nearestEnemy->row, nearestEnemy->col) &&
+                        AI::Visibility::HasLineOfSight(grid, r, c, nearestEnemy->row, nearestEnemy->col);
+                    float losPenalty = seen ? 1.0f : 0.0f;
                     float totalScore = (riskScore * 1.5f) + (distScore * 1.0f) + (losPenalty * 2.0f);
                     rockCandidates.push_back({ r, c, totalScore });
                 }
@@ -99,24 +77,24 @@ namespace AI {
         std::sort(safeCandidates.begin(), safeCandidates.end(), [](const auto& a, const auto& b) { return a.score < b.score; });
 
         for (const auto& candidate : rockCandidates) {
-            auto path = AI::Pathfinding::AStar_FindPath(unit, g_grid, g_smap, { sr, sc }, { candidate.r, candidate.c });
+            auto path = AI::Pathfinding::AStar_FindPath(unit, grid, smap, { sr, sc }, { candidate.r, candidate.c });
             if (!path.empty()) {
-                printf("Unit %d retreating to BEST REACHABLE rock cover at (%d, %d)\n", unit->id, candidate.r, candidate.c);
+                SIM_LOG("Unit %d retreating to BEST REACHABLE rock cover at (%d, %d)\n", unit->id, candidate.r, candidate.c);
                 unit->m_fsm->ChangeState(new State_MovingToTarget(candidate.r, candidate.c, new State_WaitingForSupport()));
                 return;
             }
         }
 
         for (const auto& candidate : safeCandidates) {
-            auto path = AI::Pathfinding::AStar_FindPath(unit, g_grid, g_smap, { sr, sc }, { candidate.r, candidate.c });
+            auto path = AI::Pathfinding::AStar_FindPath(unit, grid, smap, { sr, sc }, { candidate.r, candidate.c });
             if (!path.empty()) {
-                printf("Unit %d (no rock found) retreating to SAFEST REACHABLE spot at (%d, %d)\n", unit->id, candidate.r, candidate.c);
+                SIM_LOG("Unit %d (no rock found) retreating to SAFEST REACHABLE spot at (%d, %d)\n", unit->id, candidate.r, candidate.c);
                 unit->m_fsm->ChangeState(new State_MovingToTarget(candidate.r, candidate.c, new State_WaitingForSupport()));
                 return;
             }
         }
 
-        printf("Unit %d is completely TRAPPED. No reachable cover found. Waiting for support at current location.\n", unit->id);
+        SIM_LOG("Unit %d is completely TRAPPED. No reachable cover found. Waiting for support at current location.\n", unit->id);
         unit->m_fsm->ChangeState(new State_WaitingForSupport());
     }
 
@@ -3,20 +3,16 @@
 #include "State_Idle.h"
 #include "Units.h"
 #include "Definitions.h"
-#include "Globals.h"
+#include "World.h"
 #include "Pathfinding.h"
 #include "StateMachine.h"
+#include "Log.h"
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
 
 namespace {
-    inline Models::Unit* findUnitById(int uid) {
-        if (uid <= 0) return nullptr;
-        for (auto* u : g_units) if (u->id == uid) return u;
-        return nullptr;
-    }
 
     inline int cheb(int r1, int c1, int r2, int c2) {
         return std::max(std::abs(r1 - r2), std::abs(c1 - c2));
@@ -35,19 +31,21 @@ namespace AI {
         if (!self) return false;
 
         if (path.empty() || i >= path.size()) {
-            path = AI::Pathfinding::AStar_FindPath(
-                self, g_grid, g_smap,
-                { self->row, self->col },
-                { goalR, goalC },
-                AI::Pathfinding::RiskWeightForUnit(self)
-            );
+            // Stand still until the queued search comes back.
+            if (ticket == 0) ticket = self->world->paths.request(self, { goalR, goalC });
+            const AI::Pathfinding::JobStatus st = self->world->paths.take(ticket, path);
+            if (st == AI::Pathfinding::JobStatus::Pending) return true;
+            ticket = 0;
             i = 0;
-            if (path.empty()) return false;
+            // A partial path gets the unit closer; the next request starts from its end.
+            if (st != AI::Pathfinding::JobStatus::Ready && st != AI::Pathfinding::JobStatus::Partial) {
+                path.clear();
+                return false;
+            }
         }
 
         const auto next = path[i++];
-        self->row = next.first;
-        self->col = next.second;
+        self->moveTo(next.first, next.second);
         return true;
     }
 
@@ -66,7 +64,7 @@ namespace AI {
                 supplier->roleData.currentAmmo -= give;
                 tgt->stats.ammo = std::min<int>(MAX_AMMO, tgt->stats.ammo + give);
 
-                std::printf("Supplier #%d -> Unit #%d : +%d ammo (stock left: %d)\n",
+                SIM_LOG("Supplier #%d -> Unit #%d : +%d ammo (stock left: %d)\n",
                     supplier->id, tgt->id, give, supplier->roleData.currentAmmo);
             }
 
@@ -91,7 +89,7 @@ namespace AI {
     void State_Supplying::Update(Models::Unit* unit) {
         if (!unit || !unit->m_fsm) return;
 
-        Models::Unit* tgt = findUnitById(m_targetUnitId);
+        Models::Unit* tgt = unit->world->findUnit(m_targetUnitId);
         if (!tgt || !tgt->isAlive) {
             unit->assignedSupplyTargetId = -1;
             unit->m_fsm->ChangeState(new State_RefillAtDepot(Definitions::Role::Supplier, -1));
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Combat {
+
+    // Hashed timing wheel for events a whole number of ticks ahead (damage
+    // from hitscan shots still "in flight"). schedule() is O(1) and each
+    // advance() only looks at the slot for the current tick. The wheel
+    // doubles when a delay does not fit, so any delay is accepted.
+    template <typename T>
+    class TimingWheel {
+    public:
+        explicit TimingWheel(uint32_t span = 256) { grow(span); }
+
+        bool     empty() const { return m_count == 0; }
+        size_t   size() const { return m_count; }
+        uint32_t now() const { return m_now; }
+
+        void clear() {
+            for (auto& slot : m_slots) slot.clear();
+            m_count = 0;
+            m_now = 0;
+        }
+
+        // Due in `delay` ticks; 0 means in this tick's advance().
+        void schedule(uint32_t delay, const T& value) {
+            if (delay >= (uint32_t)m_slots.size()) grow(delay + 1);
+            const uint32_t due = m_now + delay;
+            m_slots[due & m_mask].push_back({ due, value });
+            ++m_count;
+        }
+
+        // Calls f(value) for everything due this tick, in scheduling
+        // order, then moves on to the next tick. f may schedule() again
+        // with a delay of at least 1.
+        template <typename F>
+        void advance(F&& f) {
+            std::vector<Entry>& slot = m_slots[m_now & m_mask];
+            m_due.swap(slot);
+            m_count -= m_due.size();
+            for (const Entry& e : m_due) f(e.value);
+            m_due.clear();
+            ++m_now;
+        }
+
+    private:
+        struct Entry {
+            uint32_t due;
+            T value;
+        };
+
+        void grow(uint32_t span) {
+            uint32_t n = 1;
+            while (n < span) n <<= 1;
+            if (n <= (uint32_t)m_slots.size()) return;
+            std::vector<std::vector<Entry>> slots(n);
+            for (auto& slot : m_slots)
+                for (const Entry& e : slot) slots[e.due & (n - 1)].push_back(e);
+            m_slots.swap(slots);
+            m_mask = n - 1;
+        }
+
+        std::vector<std::vector<Entry>> m_slots;
+        std::vector<Entry> m_due;
+        uint32_t m_mask = 0;
+        uint32_t m_now = 0;
+        size_t   m_count = 0;
+    };
+
+} // namespace Combat
@@ -0,0 +1,77 @@
+#include "UnitBins.h"
+#include <algorithm>
+#include "SpatialHash.h"
+#include "Units.h"
+
+using namespace Definitions;
+
+namespace Combat {
+
+    namespace {
+        // The 3x3 block around a padded cell.
+        const int NEIGHBOURS[9] = {
+            -Models::Grid::STRIDE - 1, -Models::Grid::STRIDE, -Models::Grid::STRIDE + 1,
+            -1, 0, 1,
+            Models::Grid::STRIDE - 1, Models::Grid::STRIDE, Models::Grid::STRIDE + 1,
+        };
+    } // namespace
+
+    UnitBins::UnitBins() {
+        for (int t = 0; t < 2; ++t) m_head[t].assign(Models::Grid::PADDED_CELLS, -1);
+    }
+
+    void UnitBins::build(const Simulation::SpatialHash& units) {
+        for (int t = 0; t < 2; ++t) {
+            std::vector<int32_t>& head = m_head[t];
+            for (int p : m_used[t]) head[p] = -1;
+            m_used[t].clear();
+
+            m_units[t] = units.members((Team)t);
+            m_next[t].resize(m_units[t].size());
+            for (int i = 0; i < (int)m_units[t].size(); ++i) {
+                const Models::Unit* u = m_units[t][i];
+                const int p = Models::Grid::padIndex(u->row, u->col);
+                if (head[p] < 0) m_used[t].push_back(p);
+                m_next[t][i] = head[p];
+                head[p] = i;
+            }
+        }
+    }
+
+    Models::Unit* UnitBins::firstHit(uint8_t teams, int p, float r, float c, float radius2) const {
+        Models::Unit* best = nullptr;
+        for (int t = 0; t < 2; ++t) {
+            if (!(teams & (1u << t))) continue;
+            const int32_t* next = m_next[t].data();
+            Models::Unit* const* units = m_units[t].data();
+            for (int k = 0; k < 9; ++k) {
+                const int q = p + NEIGHBOURS[k];
+                for (int i = m_head[t][q]; i >= 0; i = next[i]) {
+                    Models::Unit* u = units[i];
+                    if (!u->isAlive || (best && u->id > best->id)) continue;
+                    const float dr = r - (u->row + 0.5f), dc = c - (u->col + 0.5f);
+                    if (dr * dr + dc * dc <= radius2) best = u;
+                }
+            }
+        }
+        return best;
+    }
+
+    Models::Unit* UnitBins::firstOnLine(uint8_t teams, int p, float r, float c,
+        float dr, float dc, float radius2) const
+    {
+        Models::Unit* best = nullptr;
+        for (int t = 0; t < 2; ++t) {
+            if (!(teams & (1u << t))) continue;
+            for (int i = m_head[t][p]; i >= 0; i = m_next[t][i]) {
+                Models::Unit* u = m_units[t][i];
+                if (!u->isAlive || (best && u->id > best->id)) continue;
+                // Perpendicular distance from the cell centre to the line.
+                const float cross = (u->row + 0.5f - r) * dc - (u->col + 0.5f - c) * dr;
+                if (cross * cross <= radius2) best = u;
+            }
+        }
+        return best;
+    }
+
+} // namespace Combat
@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Definitions.h"
+#include "Grid.h"
+
+namespace Models { class Unit; }
+namespace Simulation { class SpatialHash; }
+
+namespace Combat {
+
+    // Broadphase for bullet hits: once per tick, the living units of each
+    // team are chained per padded cell, so a bullet only looks at the cells
+    // the projectile pool puts it in (or the 3x3 around one). Rebuilding
+    // touches only the cells used last time, so it costs O(units) however
+    // big the map. Units killed during the tick stay binned and are
+    // skipped by their isAlive flag.
+    class UnitBins {
+    public:
+        UnitBins();
+
+        void build(const Simulation::SpatialHash& units);
+
+        // Lowest-id living unit of `teams` whose cell centre is within
+        // sqrt(radius2) of the point (r,c); `p` is the padded index of the
+        // cell holding that point. nullptr if none.
+        Models::Unit* firstHit(uint8_t teams, int p, float r, float c, float radius2) const;
+
+        // Lowest-id living unit of `teams` standing in padded cell p whose
+        // cell centre lies within sqrt(radius2) of the line through (r,c)
+        // along the unit vector (dr,dc). For radii under half a cell this
+        // is a swept hit test: a ray can only touch a unit's disc inside
+        // the unit's own cell.
+        Models::Unit* firstOnLine(uint8_t teams, int p, float r, float c,
+            float dr, float dc, float radius2) const;
+
+    private:
+        // Units of team t in padded cell p: m_units[t][i] for i = m_head[t][p],
+        // m_next[t][i], ... until -1. m_used[t] lists the cells with a head.
+        std::vector<int32_t>       m_head[2];
+        std::vector<int32_t>       m_next[2];
+        std::vector<int32_t>       m_used[2];
+        std::vector<Models::Unit*> m_units[2];
+    };
+
+} // namespace Combat
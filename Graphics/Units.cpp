@@ -5,12 +5,13 @@
 #include "Definitions.h"
 #include "EventBus.h"
 #include "AIEvents.h"
-#include "Globals.h"
+#include "World.h"
 #include "Pathfinding.h"
 #include "State_Healing.h"
 #include "State_Supplying.h"
 #include "State_RefillAtDepot.h"
 #include "Visibility.h"
+#include "Log.h"
 #include <cstdio>
 #include <cstdlib>
 #include <algorithm>
@@ -22,12 +23,6 @@ using AI::EventType;
 
 namespace {
 
-    inline Models::Unit* findUnitById(int uid) {
-        if (uid <= 0) return nullptr;
-        for (auto* u : g_units) if (u && u->id == uid) return u;
-        return nullptr;
-    }
-
     inline bool isInterruptible(Models::Unit* u) {
         if (!u || !u->isAlive || !u->m_fsm) return false;
         AI::State* s = u->m_fsm->GetCurrentState();
@@ -38,8 +33,8 @@ namespace {
 
 namespace Models {
 
-    Unit::Unit(Definitions::Team t, Definitions::Role r, int r0, int c0)
-        : team(t), role(r), row(r0), col(c0),
+    Unit::Unit(Simulation::World& w, Definitions::Team t, Definitions::Role r, int r0, int c0)
+        : world(&w), team(t), role(r), row(r0), col(c0),
         isAlive(true), isMoving(false),
         stats{}, id(-1), isCarryingObjective(false),
         isFighting(false), isInCover(false), isAutonomous(false),
@@ -57,19 +52,19 @@ namespace Models {
         }
         else if (role == Definitions::Role::Supplier) {
             roleData.currentAmmo = 20;
-            std::printf("DEBUG: Supplier Unit %d created. Initial currentAmmo = %d\n", id, roleData.currentAmmo);
+            SIM_LOG("DEBUG: Supplier Unit %d created. Initial currentAmmo = %d\n", id, roleData.currentAmmo);
         }
 
 
-        EventBus::instance().subscribe(-1, [this](const Message& m) {
+        world->bus.subscribe(-1, [this](const Message& m) {
             if (m.type != EventType::CommanderDown) return;
 
-            Models::Unit* commander = findUnitById(m.fromUnitId);
+            Models::Unit* commander = this->world->findUnit(m.fromUnitId);
             if (!commander || commander->team != this->team) return;
 
             if (!this->isAutonomous) {
                 this->isAutonomous = true;
-                std::printf("[Unit %d] CommanderDown for team -> switching to AUTONOMOUS\n", this->id);
+                SIM_LOG("[Unit %d] CommanderDown for team -> switching to AUTONOMOUS\n", this->id);
 
                 if (this->m_fsm && isInterruptible(this)) {
                     this->m_fsm->ChangeState(new AI::State_Idle());
@@ -78,46 +73,46 @@ namespace Models {
             });
 
         if (role == Definitions::Role::Medic) {
-            EventBus::instance().subscribe(-1, [this](const Message& m) {
+            world->bus.subscribe(-1, [this](const Message& m) {
                 if (!this->isAutonomous) return;
                 if (m.type != EventType::Injured) return;
                 if (!this->isAlive || !this->m_fsm) return;
 
-                Models::Unit* inj = findUnitById(m.fromUnitId);
+                Models::Unit* inj = this->world->findUnit(m.fromUnitId);
                 if (!inj || !inj->isAlive) return;
                 if (inj->team != this->team) return;
                 if (!isInterruptible(this)) return;
 
                 if (this->roleData.currentHealPool < Definitions::MEDIC_REFILL_THRESHOLD) {
                     this->m_fsm->ChangeState(new AI::State_RefillAtDepot(Definitions::Role::Medic, inj->id));
-                    std::printf("[Medic %d] Autonomous: REFILL then HEAL Unit %d\n", this->id, inj->id);
+                    SIM_LOG("[Medic %d] Autonomous: REFILL then HEAL Unit %d\n", this->id, inj->id);
                 }
                 else {
                     this->m_fsm->ChangeState(new AI::State_Healing(inj->id));
-                    std::printf("[Medic %d] Autonomous: HEAL Unit %d\n", this->id, inj->id);
+                    SIM_LOG("[Medic %d] Autonomous: HEAL Unit %d\n", this->id, inj->id);
                 }
                 this->assignedHealTargetId = inj->id;
                 });
         }
 
         if (role == Definitions::Role::Supplier) {
-            EventBus::instance().subscribe(-1, [this](const Message& m) {
+            world->bus.subscribe(-1, [this](const Message& m) {
                 if (!this->isAutonomous) return;
                 if (m.type != EventType::LowAmmo) return;
                 if (!this->isAlive || !this->m_fsm) return;
 
-                Models::Unit* needy = findUnitById(m.fromUnitId);
+                Models::Unit* needy = this->world->findUnit(m.fromUnitId);
                 if (!needy || !needy->isAlive) return;
                 if (needy->team != this->team) return;
                 if (!isInterruptible(this)) return;
 
                 if (this->roleData.currentAmmo < Definitions::SUPPLIER_REFILL_THRESHOLD) {
                     this->m_fsm->ChangeState(new AI::State_RefillAtDepot(Definitions::Role::Supplier, needy->id));
-                    std::printf("[Supplier %d] Autonomous: REFILL then SUPPLY Unit %d\n", this->id, needy->id);
+                    SIM_LOG("[Supplier %d] Autonomous: REFILL then SUPPLY Unit %d\n", this->id, needy->id);
                 }
                 else {
                     this->m_fsm->ChangeState(new AI::State_Supplying(needy->id));
-                    std::printf("[Supplier %d] Autonomous: SUPPLY Unit %d\n", this->id, needy->id);
+                    SIM_LOG("[Supplier %d] Autonomous: SUPPLY Unit %d\n", this->id, needy->id);
                 }
                 this->assignedSupplyTargetId = needy->id;
                 });
@@ -132,6 +127,31 @@ namespace Models {
         }
     }
 
+    void Unit::report(AI::EventType type, int r, int c, int extra) const {
+        world->bus.publish(Message{ type, id, -1, r, c, extra });
+    }
+
+    void Unit::receiveOrder(const AI::Order&) {
+        world->bus.publish(Message{ EventType::OrderAck, id, -1 });
+    }
+
+    void Unit::moveTo(int r, int c) {
+        if (r == row && c == col) return;
+        const int fromR = row, fromC = col;
+        row = r; col = c;
+        if (isAlive) {
+            world->occupancy.move(*this, fromR, fromC);
+            world->proximity.move(*this, fromR, fromC);
+        }
+    }
+
+    void Unit::kill() {
+        if (!isAlive) return;
+        world->occupancy.remove(*this);
+        world->proximity.remove(*this);
+        isAlive = false;
+    }
+
     char Unit::roleLetter() const {
         using Definitions::Role;
         switch (role) {
@@ -6,6 +6,7 @@
 #include "Pathfinding.h" 
 
 namespace AI { class StateMachine; }
+namespace Simulation { class World; }
 
 namespace Models {
 
@@ -17,6 +18,7 @@ namespace Models {
 
     class Unit {
     public:
+        Simulation::World* world;
         Definitions::Team team;
         Definitions::Role role;
         int  row, col;
@@ -44,18 +46,16 @@ namespace Models {
 
 
 
-        Unit(Definitions::Team t, Definitions::Role r, int r0, int c0);
+        Unit(Simulation::World& w, Definitions::Team t, Definitions::Role r, int r0, int c0);
         virtual ~Unit();
         virtual char roleLetter() const;
 
-        inline void report(AI::EventType type, int r = -1, int c = -1, int extra = 0) const {
-            AI::Message msg{ type, id, -1, r, c, extra };
-            AI::EventBus::instance().publish(msg);
-        }
-        inline void receiveOrder(const AI::Order& o) {
-            AI::Message ack{ AI::EventType::OrderAck, id, -1 };
-            AI::EventBus::instance().publish(ack);
-        }
+        void report(AI::EventType type, int r = -1, int c = -1, int extra = 0) const;
+        void receiveOrder(const AI::Order& o);
+        // Position and death changes go through these so the occupancy index stays in sync.
+        void moveTo(int r, int c);
+        void kill();
+
         inline float hpNorm() const {
             if (Definitions::HP_MAX <= 0) return 0.0f;
             float x = static_cast<float>(stats.hp) / static_cast<float>(Definitions::HP_MAX);
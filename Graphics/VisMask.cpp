@@ -0,0 +1,112 @@
+#include "VisMask.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VISMASK_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VISMASK_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace AI {
+
+    namespace {
+
+        inline int popcount64(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+            return (int)__popcnt64(x);
+#elif defined(_MSC_VER)
+            return (int)(__popcnt((unsigned)x) + __popcnt((unsigned)(x >> 32)));
+#else
+            return __builtin_popcountll(x);
+#endif
+        }
+
+        enum class Op { Or, And, AndNot };
+
+        // dst = dst op src over n words, 256/128 bits at a time where available.
+        template <Op op>
+        inline void combine(uint64_t* dst, const uint64_t* src, int n) {
+            int i = 0;
+#if defined(VISMASK_AVX2)
+            for (; i + 4 <= n; i += 4) {
+                __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(dst + i));
+                __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));
+                if (op == Op::Or)          a = _mm256_or_si256(a, b);
+                else if (op == Op::And)    a = _mm256_and_si256(a, b);
+                else                       a = _mm256_andnot_si256(b, a);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), a);
+            }
+#elif defined(VISMASK_SSE2)
+            for (; i + 2 <= n; i += 2) {
+                __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(dst + i));
+                __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(src + i));
+                if (op == Op::Or)          a = _mm_or_si128(a, b);
+                else if (op == Op::And)    a = _mm_and_si128(a, b);
+                else                       a = _mm_andnot_si128(b, a);
+                _mm_store_si128(reinterpret_cast<__m128i*>(dst + i), a);
+            }
+#endif
+            for (; i < n; ++i) {
+                if (op == Op::Or)          dst[i] |= src[i];
+                else if (op == Op::And)    dst[i] &= src[i];
+                else                       dst[i] &= ~src[i];
+            }
+        }
+    }
+
+    void VisMask::clear() { m_words.fill(0); }
+
+    void VisMask::fill() {
+        for (int r = 0; r < N; ++r) {
+            for (int k = 0; k < WORDS_PER_ROW; ++k) {
+                const int bits = N - k * 64;
+                m_words[r * WORDS_PER_ROW + k] = (bits >= 64) ? ~uint64_t(0) : ((uint64_t(1) << bits) - 1);
+            }
+        }
+    }
+
+    bool VisMask::any() const {
+        uint64_t acc = 0;
+        for (uint64_t w : m_words) acc |= w;
+        return acc != 0;
+    }
+
+    int VisMask::count() const {
+        int n = 0;
+        for (uint64_t w : m_words) n += popcount64(w);
+        return n;
+    }
+
+    VisMask& VisMask::operator|=(const VisMask& o) {
+        combine<Op::Or>(m_words.data(), o.m_words.data(), WORDS);
+        return *this;
+    }
+
+    VisMask& VisMask::operator&=(const VisMask& o) {
+        combine<Op::And>(m_words.data(), o.m_words.data(), WORDS);
+        return *this;
+    }
+
+    VisMask& VisMask::andNot(const VisMask& o) {
+        combine<Op::AndNot>(m_words.data(), o.m_words.data(), WORDS);
+        return *this;
+    }
+
+    int VisMask::countAnd(const VisMask& a, const VisMask& b) {
+        int n = 0;
+        for (int i = 0; i < WORDS; ++i) n += popcount64(a.m_words[i] & b.m_words[i]);
+        return n;
+    }
+
+    int VisMask::countAndNot(const VisMask& a, const VisMask& b) {
+        int n = 0;
+        for (int i = 0; i < WORDS; ++i) n += popcount64(a.m_words[i] & ~b.m_words[i]);
+        return n;
+    }
+
+} // namespace AI
@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "Definitions.h"
+
+namespace AI {
+
+    // One bit per cell; every grid row is padded to whole 64-bit words and the
+    // padding bits are always zero, so word-wise ops never need masking.
+    class VisMask {
+    public:
+        static constexpr int N = Definitions::GRID_SIZE;
+        static constexpr int WORDS_PER_ROW = (N + 63) / 64;
+        static constexpr int WORDS = WORDS_PER_ROW * N;
+
+        inline bool test(int r, int c) const {
+            if (!inBounds(r, c)) return false;
+            return (m_words[word(r, c)] >> (c & 63)) & 1u;
+        }
+        inline void set(int r, int c) {
+            if (inBounds(r, c)) m_words[word(r, c)] |= bit(c);
+        }
+        inline void reset(int r, int c) {
+            if (inBounds(r, c)) m_words[word(r, c)] &= ~bit(c);
+        }
+
+        void clear();
+        void fill();
+
+        bool any() const;
+        int  count() const;
+
+        VisMask& operator|=(const VisMask& o);
+        VisMask& operator&=(const VisMask& o);
+        // this &= ~o: cells seen here but not in o (fog-of-war diff).
+        VisMask& andNot(const VisMask& o);
+
+        bool operator==(const VisMask& o) const { return m_words == o.m_words; }
+        bool operator!=(const VisMask& o) const { return !(*this == o); }
+
+        // popcount(a & b) / popcount(a & ~b) without a temporary mask.
+        static int countAnd(const VisMask& a, const VisMask& b);
+        static int countAndNot(const VisMask& a, const VisMask& b);
+
+        inline uint64_t rowWord(int r, int k) const { return m_words[r * WORDS_PER_ROW + k]; }
+        inline const uint64_t* data() const { return m_words.data(); }
+
+    private:
+        static inline bool inBounds(int r, int c) { return r >= 0 && r < N && c >= 0 && c < N; }
+        static inline int  word(int r, int c) { return r * WORDS_PER_ROW + (c >> 6); }
+        static inline uint64_t bit(int c) { return uint64_t(1) << (c & 63); }
+
+        alignas(32) std::array<uint64_t, WORDS> m_words{};
+    };
+
+} // namespace AI
@@ -1,4 +1,5 @@
 ﻿#include "Visibility.h"
+#include "Profiler.h"
 #include <cmath>
 #include <algorithm>
 
@@ -6,14 +7,6 @@ using namespace Definitions;
 
 namespace AI {
 
-    void Visibility::Clear(BArray& arr) {
-        for (auto& row : arr) row.fill(0);
-    }
-
-    static inline bool blocksLOS(int cell) {
-        return (cell == ROCK);
-    }
-
     bool Visibility::HasLineOfSight(const Models::Grid& map, int r0, int c0, int r1, int c1)
     {
         int dr = std::abs(r1 - r0);
@@ -24,7 +17,7 @@ namespace AI {
         int r = r0, c = c0;
 
         while (true) {
-            if (!(r == r0 && c == c0) && blocksLOS(map.at(r, c))) return false;
+            if (!(r == r0 && c == c0) && map.blocksLOS(r, c)) return false;
             if (r == r1 && c == c1) break;
 
             int e2 = err;
@@ -36,9 +29,82 @@ namespace AI {
         return true;
     }
 
-    void Visibility::BuildUnitVisibility(const Models::Grid& map, int r, int c, int sightRange, BArray& out)
+    namespace {
+
+        // Slopes are exact fractions num/den (den > 0) so the sweep stays symmetric.
+        struct Slope { int num, den; };
+
+        inline int floorDiv(int a, int b) { return (a >= 0) ? (a / b) : -((-a + b - 1) / b); }
+        inline int ceilDiv(int a, int b) { return -floorDiv(-a, b); }
+
+        // depth * s rounded half up / half down.
+        inline int roundTiesUp(int depth, Slope s) { return floorDiv(2 * depth * s.num + s.den, 2 * s.den); }
+        inline int roundTiesDown(int depth, Slope s) { return ceilDiv(2 * depth * s.num - s.den, 2 * s.den); }
+
+        struct Shadowcaster {
+            const Models::Grid& map;
+            VisMask& out;
+            int originR, originC;
+            int range2;
+            int quadrant = 0;
+
+            void transform(int depth, int col, int& r, int& c) const {
+                switch (quadrant) {
+                case 0:  r = originR - depth; c = originC + col; break;
+                case 1:  r = originR + depth; c = originC + col; break;
+                case 2:  r = originR + col;   c = originC + depth; break;
+                default: r = originR + col;   c = originC - depth; break;
+                }
+            }
+
+            // Cells outside the grid behave as walls that are never revealed.
+            bool isWall(int depth, int col) const {
+                int r, c; transform(depth, col, r, c);
+                if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) return true;
+                return map.blocksLOS(r, c);
+            }
+
+            void reveal(int depth, int col) {
+                int r, c; transform(depth, col, r, c);
+                if (depth * depth + col * col > range2) return;
+                out.set(r, c);
+            }
+
+            void scan(int depth, Slope start, Slope end) {
+                if (depth * depth > range2) return;
+                const int minCol = roundTiesUp(depth, start);
+                const int maxCol = roundTiesDown(depth, end);
+
+                int prev = -1; // -1 none, 0 floor, 1 wall
+                for (int col = minCol; col <= maxCol; ++col) {
+                    const bool wall = isWall(depth, col);
+                    const bool symmetric = (col * start.den >= depth * start.num) &&
+                        (col * end.den <= depth * end.num);
+                    if (!wall && symmetric) reveal(depth, col);
+
+                    const Slope tileSlope{ 2 * col - 1, 2 * depth };
+                    if (prev == 1 && !wall) start = tileSlope;
+                    if (prev == 0 && wall) scan(depth + 1, start, tileSlope);
+                    prev = wall ? 1 : 0;
+                }
+                if (prev == 0) scan(depth + 1, start, end);
+            }
+        };
+    }
+
+    void Visibility::BuildUnitVisibility(const Models::Grid& map, int r, int c, int sightRange, VisMask& out, Mode mode)
     {
-        Clear(out);
+        out.clear();
+        if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) return;
+
+        if (mode == Mode::Shadowcast) {
+            out.set(r, c);
+            Shadowcaster sc{ map, out, r, c, sightRange * sightRange };
+            for (sc.quadrant = 0; sc.quadrant < 4; ++sc.quadrant)
+                sc.scan(1, Slope{ -1, 1 }, Slope{ 1, 1 });
+            return;
+        }
+
         const int R2 = sightRange * sightRange;
 
         int rmin = std::max(0, r - sightRange);
@@ -50,7 +116,7 @@ namespace AI {
             for (int cc = cmin; cc <= cmax; ++cc) {
                 int drr = rr - r, dcc = cc - c;
                 if (drr * drr + dcc * dcc > R2) continue;
-                if (HasLineOfSight(map, r, c, rr, cc)) out[rr][cc] = 1;
+                if (HasLineOfSight(map, r, c, rr, cc)) out.set(rr, cc);
             }
         }
     }
@@ -59,17 +125,17 @@ namespace AI {
         const std::vector<Models::Unit*>& units,
         Team team,
         int sightRange,
-        BArray& out)
+        VisMask& out,
+        Mode mode)
     {
-        Clear(out);
-        BArray tmp;
+        SIM_PROFILE_ZONE(TeamVisibility);
+        out.clear();
+        VisMask tmp;
         for (size_t i = 0; i < units.size(); ++i) {
             const Models::Unit* u = units[i];
             if (!u->isAlive || u->team != team) continue;
-            BuildUnitVisibility(map, u->row, u->col, sightRange, tmp);
-            for (int r = 0; r < GRID_SIZE; ++r)
-                for (int c = 0; c < GRID_SIZE; ++c)
-                    if (tmp[r][c]) out[r][c] = 1;
+            BuildUnitVisibility(map, u->row, u->col, sightRange, tmp, mode);
+            out |= tmp;
         }
     }
 
@@ -6,24 +6,27 @@
 #include "Definitions.h"
 #include "Grid.h"
 #include "Units.h"
+#include "VisMask.h"
 
 namespace AI {
 
     class Visibility {
     public:
-        using BArray = std::array<std::array<uint8_t, Definitions::GRID_SIZE>, Definitions::GRID_SIZE>;
+        // Rays: one Bresenham HasLineOfSight ray per cell in range.
+        // Shadowcast: symmetric shadowcasting, one O(cells) sweep per unit.
+        enum class Mode : uint8_t { Rays, Shadowcast };
 
         static bool HasLineOfSight(const Models::Grid& map, int r0, int c0, int r1, int c1);
 
-        static void BuildUnitVisibility(const Models::Grid& map, int r, int c, int sightRange, BArray& out);
+        static void BuildUnitVisibility(const Models::Grid& map, int r, int c, int sightRange, VisMask& out,
+            Mode mode = Mode::Rays);
 
         static void BuildTeamVisibility(const Models::Grid& map,
             const std::vector<Models::Unit*>& units,
             Definitions::Team team,
             int sightRange,
-            BArray& out);
-
-        static void Clear(BArray& arr);
+            VisMask& out,
+            Mode mode = Mode::Rays);
     };
 
 } // namespace AI
\ No newline at end of file
@@ -12,14 +12,13 @@
 #include "Pathfinding.h"
 #include "Combat.h"
 
-#include "Globals.h"
+#include "World.h"
 #include "Visibility.h"
 #include "SecurityMap.h"
 #include <limits> 
 #include <cmath>  
 #include "State_Idle.h"
-
-extern Combat::System g_combat;
+#include "Log.h"
 
 namespace {
     constexpr float GRENADE_MIN_THROW_DIST2 = 1.0f;              
@@ -37,10 +36,10 @@ namespace {
     constexpr float UNDER_FIRE_GRENADE_FACTOR = 1.00f; 
 }
 
-static int countEnemiesAround(int cr, int cc, float radius2)
+static int countEnemiesAround(const std::vector<Models::Unit*>& units, int cr, int cc, float radius2)
 {
     int count = 0;
-    for (const auto* other : g_units) {
+    for (const auto* other : units) {
         if (!other->isAlive) continue;
         if (other->team == Definitions::Team::Blue || other->team == Definitions::Team::Orange) {
             int dr = other->row - cr;
@@ -51,52 +50,26 @@ static int countEnemiesAround(int cr, int cc, float radius2)
     return 0; 
 }
 
-static int countEnemiesAroundVsTeam(Definitions::Team selfTeam, int cr, int cc, float radius2)
+static int countEnemiesAroundVsTeam(const Simulation::SpatialHash& index, Definitions::Team selfTeam, int cr, int cc, float radius2)
 {
-    int count = 0;
-    for (const auto* other : g_units) {
-        if (!other->isAlive) continue;
-        if (other->team == selfTeam) continue; 
-        int dr = other->row - cr;
-        int dc = other->col - cc;
-        float d2 = float(dr * dr + dc * dc);
-        if (d2 <= radius2) ++count;
-    }
-    return count;
+    return index.countWithin(Simulation::SpatialHash::enemiesOf(selfTeam), cr, cc, radius2);
 }
 
-static bool hasFriendlyNear(Definitions::Team selfTeam, int cr, int cc, float radius2)
+static bool hasFriendlyNear(const Simulation::SpatialHash& index, Definitions::Team selfTeam, int cr, int cc, float radius2)
 {
-    for (const auto* other : g_units) {
-        if (!other->isAlive) continue;
-        if (other->team != selfTeam) continue; 
-        int dr = other->row - cr;
-        int dc = other->col - cc;
-        float d2 = float(dr * dr + dc * dc);
-        if (d2 <= radius2) return true;
-    }
-    return false;
+    return index.anyWithin(Simulation::SpatialHash::only(selfTeam), cr, cc, radius2);
 }
 
 
 namespace Models {
 
     static bool isEnemyInRange(const Models::Unit* self, int range) {
-        const int rangeSq = range * range;
-        for (const auto* other : g_units) {
-            if (!other->isAlive || other->team == self->team) continue;
-
-            int dr = other->row - self->row;
-            int dc = other->col - self->col;
-            if ((dr * dr + dc * dc) <= rangeSq) {
-                return true; 
-            }
-        }
-        return false;
+        return self->world->proximity.anyWithin(Simulation::SpatialHash::enemiesOf(self->team),
+            self->row, self->col, float(range * range));
     }
 
-    Warrior::Warrior(Definitions::Team t, int r0, int c0)
-        : Unit(t, Definitions::Role::Warrior, r0, c0) {
+    Warrior::Warrior(Simulation::World& w, Definitions::Team t, int r0, int c0)
+        : Unit(w, t, Definitions::Role::Warrior, r0, c0) {
     }
 
     char Warrior::roleLetter() const { return 'W'; }
@@ -104,23 +77,7 @@ namespace Models {
     bool Warrior::acquireVisibleEnemy(int& outR, int& outC) const {
         outR = -1; outC = -1;
         if (!isAlive) return false;
-
-        const int R2 = Definitions::SIGHT_RANGE * Definitions::SIGHT_RANGE;
-        float bestD2 = 1e12f;
-
-        for (const auto* other : g_units) {
-            if (!other->isAlive || other->team == this->team) continue;
-            int dr = other->row - this->row;
-            int dc = other->col - this->col;
-            float d2 = float(dr * dr + dc * dc);
-            if (d2 > R2 || d2 >= bestD2) continue;
-            if (!AI::Visibility::HasLineOfSight(g_grid, this->row, this->col, other->row, other->col)) continue;
-
-            bestD2 = d2;
-            outR = other->row;
-            outC = other->col;
-        }
-        return (outR >= 0);
+        return world->perception.bestVisibleEnemy(*this, outR, outC);
     }
 
     void Warrior::CheckAndReportStatus() {
@@ -144,17 +101,11 @@ namespace Models {
             int near_er = -1, near_ec = -1;
             bool nearest_target_found = false;
             if (!visible_target_found) {
-                float nearest_d2 = std::numeric_limits<float>::infinity();
-                for (const auto* other : g_units) {
-                    if (!other->isAlive || other->team == this->team) continue;
-                    int dr = other->row - this->row;
-                    int dc = other->col - this->col;
-                    float d2 = float(dr * dr + dc * dc);
-                    if (d2 < nearest_d2) {
-                        nearest_d2 = d2;
-                        near_er = other->row;
-                        near_ec = other->col;
-                    }
+                const Models::Unit* nearest = world->proximity.nearest(
+                    Simulation::SpatialHash::enemiesOf(this->team), this->row, this->col);
+                if (nearest) {
+                    near_er = nearest->row;
+                    near_ec = nearest->col;
                 }
                 nearest_target_found = (near_er != -1);
             }
@@ -171,7 +122,7 @@ namespace Models {
             bool target_reachable = false;
             if (target_chosen) {
                 AI::Pathfinding::Path path_check = AI::Pathfinding::AStar_FindPath(
-                    this, g_grid, g_smap,
+                    this, world->grid, world->smap,
                     { this->row, this->col }, { target_r, target_c },
                     Definitions::ASTAR_RISK_WEIGHT
                 );
@@ -183,7 +134,7 @@ namespace Models {
 
             if (target_chosen && target_reachable) {
                 if (!is_attacking && !is_moving_to_attack) {
-                    m_fsm->ChangeState(new AI::State_Attacking(target_r, target_c, &g_combat));
+                    m_fsm->ChangeState(new AI::State_Attacking(target_r, target_c, &world->combat));
                 }
                 return;
             }
@@ -195,8 +146,7 @@ namespace Models {
                 return;
             }
             else {
-                const float maxRisk = g_smap.maxValue();
-                const float hereRisk = (maxRisk > 0.001f) ? (g_smap.at(row, col) / maxRisk) : 0.0f;
+                const float hereRisk = world->smap.normAt(row, col);
                 if (hereRisk >= Definitions::WARRIOR_UNDER_FIRE_THRESHOLD * 0.8f) {
                     if (dynamic_cast<AI::State_Defending*>(current_state) == nullptr) {
                         m_fsm->ChangeState(new AI::State_Defending(row, col));
@@ -222,7 +172,7 @@ namespace Models {
                     report(AI::EventType::LowAmmo, row, col, stats.ammo);
                     m_reportedLowAmmo = true;
                 }
-                printf("Unit %d: Out of ammo AND under threat. Retreating to cover!\n", id);
+                SIM_LOG("Unit %d: Out of ammo AND under threat. Retreating to cover!\n", id);
                 m_fsm->ChangeState(new AI::State_RetreatingToCover());
                 return;
             }
@@ -238,8 +188,7 @@ namespace Models {
         }
 
         const float riskThreshold = Definitions::WARRIOR_UNDER_FIRE_THRESHOLD;
-        const float maxRisk = g_smap.maxValue();
-        const float normalizedRisk = (maxRisk > 0.001f) ? (g_smap.at(row, col) / maxRisk) : 0.0f;
+        const float normalizedRisk = world->smap.normAt(row, col);
 
         if (normalizedRisk >= riskThreshold && !m_reportedUnderFire) {
             m_reportedUnderFire = true;
@@ -283,10 +232,10 @@ namespace Models {
         const float d2 = dr * dr + dc * dc;
 
         if (d2 < GRENADE_MIN_THROW_DIST2) {
-            g_combat.dropGrenade(r0, c0, g_grid, team);
+            world->combat.dropGrenade(r0, c0, world->grid, team);
         }
         else {
-            g_combat.throwGrenadeParabola(r0, c0, rT, cT, team);
+            world->combat.throwGrenadeParabola(r0, c0, rT, cT, team);
         }
 
         --grenades;
@@ -311,16 +260,15 @@ namespace Models {
         const float d2 = dr * dr + dc * dc;
         if (d2 > GRENADE_MAX_THROW_DIST2) return;
 
-        const float maxRisk = g_smap.maxValue();
-        const float hereRisk = (maxRisk > 1e-5f) ? (g_smap.at(row, col) / maxRisk) : 0.0f;
+        const float hereRisk = world->smap.normAt(row, col);
         const float fireThreshold = Definitions::WARRIOR_UNDER_FIRE_THRESHOLD * UNDER_FIRE_GRENADE_FACTOR;
         const bool  underFire = (hereRisk >= fireThreshold);
 
         const int enemiesNearTarget =
-            countEnemiesAroundVsTeam(this->team, er, ec, DECISION_AOE_RADIUS2);
+            countEnemiesAroundVsTeam(world->proximity, this->team, er, ec, DECISION_AOE_RADIUS2);
 
         const bool friendTooClose =
-            hasFriendlyNear(this->team, er, ec, SAFETY_FRIEND_RADIUS2);
+            hasFriendlyNear(world->proximity, this->team, er, ec, SAFETY_FRIEND_RADIUS2);
 
         if (friendTooClose) return;
 
@@ -7,7 +7,7 @@ namespace Models {
 
     class Warrior : public Unit {
     public:
-        Warrior(Definitions::Team t, int r0, int c0);
+        Warrior(Simulation::World& w, Definitions::Team t, int r0, int c0);
 
         virtual char roleLetter() const override;
 
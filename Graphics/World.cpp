@@ -0,0 +1,41 @@
+#include "World.h"
+#include "Units.h"
+
+namespace Simulation {
+
+    World::World()
+        : commanderBlue(*this, Definitions::Team::Blue)
+        , commanderOrange(*this, Definitions::Team::Orange)
+    {
+        combat.bindUnits(&proximity);
+    }
+
+    World::~World() { clearUnits(); }
+
+    void World::clearUnits() {
+        bus.clear();
+        for (auto* u : units) delete u;
+        units.clear();
+        occupancy.clear();
+        proximity.clear();
+        perception.clear();
+        combat.clear();
+        paths.clear();
+    }
+
+    bool World::isSharedGoal(int r, int c) const {
+        const Models::Landmarks& lm = grid.landmarks();
+        const Models::ivec2 p{ r, c };
+        if (p == lm.ammoBlue || p == lm.medBlue || p == lm.ammoOrange || p == lm.medOrange) return true;
+        if (commanderBlue.hasAnchor() && r == commanderBlue.anchorR && c == commanderBlue.anchorC) return true;
+        if (commanderOrange.hasAnchor() && r == commanderOrange.anchorR && c == commanderOrange.anchorC) return true;
+        return false;
+    }
+
+    Models::Unit* World::findUnit(int id) const {
+        if (id <= 0) return nullptr;
+        for (auto* u : units) if (u && u->id == id) return u;
+        return nullptr;
+    }
+
+} // namespace Simulation
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include "Definitions.h"
+#include "Rng.h"
+#include "Grid.h"
+#include "SecurityMap.h"
+#include "OccupancyGrid.h"
+#include "SpatialHash.h"
+#include "Perception.h"
+#include "Combat.h"
+#include "EventBus.h"
+#include "Commander.h"
+#include "Connectivity.h"
+#include "CoverField.h"
+#include "HierarchicalPlanner.h"
+#include "FlowField.h"
+#include "PathJobs.h"
+
+namespace Models { class Unit; }
+
+namespace Simulation {
+
+    // Everything one match owns. Units and commanders keep a pointer back to
+    // their World, and states reach it through the unit they run on, so any
+    // number of worlds can be simulated side by side.
+    class World {
+    public:
+        World();
+        ~World();
+
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        // Deletes every unit, drops the bus handlers they registered and any
+        // projectiles still in flight.
+        void clearUnits();
+
+        Models::Unit* findUnit(int id) const;
+
+        // Destinations many units head for (depots, commander anchors);
+        // FindPath serves these from the flow-field cache.
+        bool isSharedGoal(int r, int c) const;
+
+        inline AI::Commander& commander(Definitions::Team t) {
+            return (t == Definitions::Team::Blue) ? commanderBlue : commanderOrange;
+        }
+
+        // Master seed of the current match and the streams derived from it.
+        uint32_t seed = 0;
+        RngStreams rng;
+        int frame = 0;
+
+        Models::Grid grid;
+        std::vector<Models::Unit*> units;
+        SecurityMap smap;
+        OccupancyGrid occupancy;
+        SpatialHash proximity;
+        AI::Perception perception;
+        AI::Pathfinding::Connectivity connectivity;
+        AI::Pathfinding::CoverField cover;
+        AI::Pathfinding::HierarchicalPlanner hpa;
+        AI::Pathfinding::FlowFieldService flow;
+        AI::Pathfinding::PathJobQueue paths;
+        Combat::System combat;
+        AI::EventBus bus;
+        AI::Commander commanderBlue;
+        AI::Commander commanderOrange;
+    };
+
+} // namespace Simulation
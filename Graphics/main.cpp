@@ -5,6 +5,8 @@
 #include <cmath>
 #include <algorithm>
 #include <ctime>
+#include <cstdlib>
+#include <cstring>
 #include <map> 
 
 #include "Definitions.h"
@@ -15,7 +17,7 @@
 #include "Visibility.h"
 #include "Combat.h"
 #include "Pathfinding.h"
-#include "Globals.h"
+#include "World.h"
 #include "Warrior.h" 
 
 // AI Includes
@@ -24,53 +26,31 @@
 #include "EventBus.h"
 #include "Commander.h"
 #include "StateMachine.h"
+#include "Match.h"
+#include "Profiler.h"
 
 using namespace Definitions;
 
-// World state
-Models::Grid              g_grid;
-std::vector<Models::Unit*> g_units;
-Simulation::SecurityMap   g_smap;
-static AI::Visibility::BArray g_vis;
+// Simulation (world globals are defined in Match.cpp)
+static Simulation::Match g_match;
+static Simulation::World& g_world = g_match.world();
+static AI::VisMask g_vis;
 
 // View modes
 static bool g_showSecurity = false; 
 static bool g_showVisibility = false; 
 static Team g_visTeam = Team::Blue; 
-
-// Add a small helper for printing team name
-static inline const char* teamTag(Team t) {
-    return (t == Team::Blue) ? "Blue" : "Orange";
-}
+static AI::Visibility::Mode g_visMode = AI::Visibility::Mode::Shadowcast;
 
 // HUD (to console)
 static float g_fps = 0.0f;
 static long  g_cntRock = 0, g_cntTree = 0, g_cntWater = 0, g_cntDepot = 0;
 static int   g_blueCount = 0, g_orangeCount = 0;
 
-Combat::System g_combat;
 static int g_targetRow = -1, g_targetCol = -1;
 
-// Commander + helpers 
-static AI::Commander g_commanderBlue(Definitions::Team::Blue);
-static AI::Commander g_commanderOrange(Definitions::Team::Orange);
-static int  g_frameCounter = 0;
-static bool g_commanderEnabled = false; 
-
-// Random spawn flags/ids (debug)
-static bool g_randomizeWarriorsSpawn = true;
-static int  g_randBlueWarriorId = -1;
-static int  g_randOrangeWarriorId = -1;
-
-// Anchors
-static bool g_blueAnchorValid = false;
-static bool g_orangeAnchorValid = false;
-static int  g_orangeAnchorR = -1, g_orangeAnchorC = -1;
-static bool g_gameOver = false;
-static Definitions::Team g_winningTeam = Definitions::Team::Blue;
-
-
-
+// Master seed of the match on screen; N starts the next seed.
+static uint32_t g_seed = 0;
 
 // Helpers
 
@@ -114,7 +94,7 @@ static void drawTeamHealthBars()
     const float PADDING_Y = 10.0f;
 
     int blueIdx = 0;
-    for (const auto* u : g_units) { 
+    for (const auto* u : g_world.units) { 
         if (u->team != Team::Blue) continue;
 
         float x_role = PADDING_X;
@@ -150,7 +130,7 @@ static void drawTeamHealthBars()
     }
 
     int orangeIdx = 0;
-    for (const auto* u : g_units) { 
+    for (const auto* u : g_world.units) { 
         if (u->team != Team::Orange) continue;
 
         float x_role = W - PADDING_X - ROLE_BOX_SIZE;
@@ -196,7 +176,7 @@ static void drawTeamHealthBars()
 
 static void drawGameOverMessage()
 {
-    if (!g_gameOver) return; 
+    if (!g_match.gameOver()) return; 
 
     const int W = glutGet(GLUT_WINDOW_WIDTH);
     const int H = glutGet(GLUT_WINDOW_HEIGHT);
@@ -217,7 +197,7 @@ static void drawGameOverMessage()
     glLoadIdentity();
 
     std::string winMsg;
-    if (g_winningTeam == Definitions::Team::Blue) {
+    if (g_match.winner() == Definitions::Team::Blue) {
         winMsg = "BLUE TEAM IS THE WINNER"; 
         glColor4f(0.2f, 0.6f, 1.0f, 1.0f); 
     }
@@ -256,7 +236,7 @@ static void drawGameOverMessage()
 
 static void drawStartHint()
 {
-    if (g_gameOver || g_commanderEnabled) return;
+    if (g_match.gameOver() || g_match.commanderEnabled()) return;
 
     const int W = glutGet(GLUT_WINDOW_WIDTH);
     const int H = glutGet(GLUT_WINDOW_HEIGHT);
@@ -294,23 +274,23 @@ static void drawStartHint()
 }
 
 
+// Popcounts of the terrain bitplanes: rocks are the only LOS blockers,
+// trees the explosive blockers that are neither rock nor depot, and water
+// the non-walkable cells that are not rock.
 static void computeMapCounts()
 {
-    g_cntRock = g_cntTree = g_cntWater = g_cntDepot = 0;
-    for (int r = 0; r < GRID_SIZE; ++r)
-        for (int c = 0; c < GRID_SIZE; ++c) {
-            int v = g_grid.at(r, c);
-            if (v == ROCK)               ++g_cntRock;
-            else if (v == TREE)          ++g_cntTree;
-            else if (v == WATER)         ++g_cntWater;
-            else if (v == DEPOT_AMMO || v == DEPOT_MED) ++g_cntDepot;
-        }
+    using Models::Plane;
+    const Models::Grid& g = g_world.grid;
+    g_cntRock = g.plane(Plane::BlocksLOS).count();
+    g_cntDepot = g.plane(Plane::Depot).count();
+    g_cntTree = g.plane(Plane::BlocksExplosive).count() - g_cntRock - g_cntDepot;
+    g_cntWater = GRID_SIZE * GRID_SIZE - g.plane(Plane::Walkable).count() - g_cntRock;
 }
 
 static void computeUnitCounts()
 {
     g_blueCount = g_orangeCount = 0;
-    for (const auto* u : g_units) {
+    for (const auto* u : g_world.units) {
         if (!u->isAlive) continue;
         if (u->team == Team::Blue) ++g_blueCount; else ++g_orangeCount; 
     }
@@ -318,8 +298,8 @@ static void computeUnitCounts()
 
 static void rebuildVisibility()
 {
-    if (!g_showVisibility) { AI::Visibility::Clear(g_vis); return; }
-    AI::Visibility::BuildTeamVisibility(g_grid, g_units, g_visTeam, SIGHT_RANGE, g_vis);
+    if (!g_showVisibility) { g_vis.clear(); return; }
+    AI::Visibility::BuildTeamVisibility(g_world.grid, g_world.units, g_visTeam, SIGHT_RANGE, g_vis, g_visMode);
 }
 
 static void drawTargetCross()
@@ -365,7 +345,7 @@ static void drawTeamRings()
         glEnd();
         };
 
-    for (const auto* u : g_units) {
+    for (const auto* u : g_world.units) {
         if (!u->isAlive) continue;
         const float cx = u->col * CELL_PX + CELL_PX * 0.5f;
         const float cy = u->row * CELL_PX + CELL_PX * 0.5f;
@@ -386,227 +366,22 @@ static void DebugOverlayDraw()
 {
     drawTargetCross();
     drawTeamRings();
-    g_combat.draw();
+    g_world.combat.draw();
     drawTeamHealthBars();
     drawGameOverMessage();
     drawStartHint();
 }
 
-// Random & anchors respecting playfield
-static inline bool inHalf(Definitions::Team t, int c) {
-    return (t == Definitions::Team::Blue) ? (c < GRID_SIZE / 2) : (c >= GRID_SIZE / 2);
-}
-
-static bool isSpawnableCell(int r, int c)
-{
-    if (r < 0 || r >= GRID_SIZE || c < 0 || c >= GRID_SIZE) return false;
-    if (!AI::Pathfinding::inPlayfield(r, c)) return false;
-    if (!AI::Pathfinding::IsWalkableForMovement(g_grid.at(r, c))) return false;
-    if (AI::Pathfinding::IsOccupied(r, c)) return false;
-    return true;
-}
-
-static bool randomFreeCellInHalf(Definitions::Team team, int& outR, int& outC)
-{
-    const int tries = 500;
-    for (int k = 0; k < tries; ++k) {
-        int r = std::rand() % GRID_SIZE;
-        int c = std::rand() % GRID_SIZE;
-        if (!AI::Pathfinding::inPlayfield(r, c)) continue;
-        if (!inHalf(team, c)) continue;
-        if (!AI::Pathfinding::IsWalkableForMovement(g_grid.at(r, c))) continue;
-        if (AI::Pathfinding::IsOccupied(r, c)) continue;
-        outR = r; outC = c;
-        return true;
-    }
-    return false;
-}
-
-static void randomizeAllWarriorsInTeams()
-{
-    if (!g_randomizeWarriorsSpawn) return;
-    g_randBlueWarriorId = -1;
-    g_randOrangeWarriorId = -1;
-
-    for (auto* u : g_units) {
-        if (!u->isAlive || u->role != Role::Warrior) continue;
-        int r, c;
-        if (randomFreeCellInHalf(u->team, r, c)) {
-            u->row = r; u->col = c; u->isMoving = false;
-            if (u->team == Team::Blue && g_randBlueWarriorId == -1)   g_randBlueWarriorId = u->id;
-            if (u->team == Team::Orange && g_randOrangeWarriorId == -1) g_randOrangeWarriorId = u->id;
-        }
-    }
-}
-
-static bool selectAnchorForTeam(Definitions::Team team, int& outR, int& outC)
-{
-    const int tries = AI::Commander::ANCHOR_RETRIES;
-    const float safeMax = AI::Commander::SAFE_RISK_MAX;
-    int bestR = -1, bestC = -1; float bestRisk = 1e9f;
-
-    for (int k = 0; k < tries; ++k) {
-        int r = std::rand() % GRID_SIZE;
-        int c = std::rand() % GRID_SIZE;
-        if (!isSpawnableCell(r, c)) continue;
-        if (!inHalf(team, c)) continue;
-        float risk = g_smap.at(r, c);
-        if (risk <= safeMax && risk < bestRisk) {
-            bestRisk = risk; bestR = r; bestC = c;
-            if (bestRisk <= 0.05f) break;
-        }
-    }
-    if (bestR < 0) {
-        for (int k = 0; k < tries; ++k) {
-            int r = std::rand() % GRID_SIZE;
-            int c = std::rand() % GRID_SIZE;
-            if (!isSpawnableCell(r, c)) continue;
-            if (!inHalf(team, c)) continue;
-            float risk = g_smap.at(r, c);
-            if (risk < bestRisk) { bestRisk = risk; bestR = r; bestC = c; }
-        }
-    }
-    if (bestR >= 0) { outR = bestR; outC = bestC; return true; }
-    return false;
-}
-
-static void placeFirstByRole(Definitions::Team team, Definitions::Role role, int r, int c)
-{
-    for (auto* u : g_units) {
-        if (!u->isAlive) continue;
-        if (u->team == team && u->role == role) {
-            if (!AI::Pathfinding::IsOccupied(r, c)) {
-                u->row = r; u->col = c; u->isMoving = false;
-            }
-            break;
-        }
-    }
-}
-
-static void sanitizeWorldOutsidePlayfield()
-{
-    const int EMPTY_CELL = Definitions::Cell::EMPTY;
-    for (int r = 0; r < GRID_SIZE; ++r) {
-        for (int c = 0; c < GRID_SIZE; ++c) {
-            if (AI::Pathfinding::inPlayfield(r, c)) continue;
-            int v = g_grid.at(r, c);
-            if (v == ROCK || v == TREE || v == DEPOT_AMMO || v == DEPOT_MED || v == WATER) {
-                g_grid.set(r, c, EMPTY_CELL);
-            }
-        }
-    }
-}
-
-static void autoEnemySightings(int frameCounter,
-    const std::vector<Models::Unit*>& blueTeam,
-    const std::vector<Models::Unit*>& orangeTeam)
-{
-    if (frameCounter % 15 != 0) return;
-
-    auto reportLOS = [&](const std::vector<Models::Unit*>& mine, const std::vector<Models::Unit*>& theirs)
-        {
-            for (auto* me : mine) {
-                if (!me || !me->isAlive) continue;
-                for (auto* en : theirs) {
-                    if (!en || !en->isAlive) continue;
-                    int dr = en->row - me->row;
-                    int dc = en->col - me->col;
-                    if (dr * dr + dc * dc > SIGHT_RANGE * SIGHT_RANGE) continue;
-                    if (!AI::Visibility::HasLineOfSight(g_grid, me->row, me->col, en->row, en->col)) continue;
-
-                    AI::EventBus::instance().publish(AI::Message{
-                        AI::EventType::EnemySighted,
-                        me->id, -1, en->row, en->col, 0
-                        });
-                    break;
-                }
-            }
-        };
-
-    reportLOS(blueTeam, orangeTeam);
-    reportLOS(orangeTeam, blueTeam);
-}
-
-
 // Build world
 static void buildTestWorld()
 {
-    for (auto* u : g_units) {
-        delete u; 
-    }
-    g_units.clear();
-
-    g_grid = Models::Grid();
-    sanitizeWorldOutsidePlayfield();
-
-    const int rowBlue = GRID_SIZE / 6;
-    const int startBlue = GRID_SIZE / 10;
-    const int step = 3;
-
-    g_units.reserve(10); 
-
-    g_units.push_back(new Models::Unit(Team::Blue, Role::Commander, rowBlue, startBlue + step * 0));
+    g_match.buildTestWorld(g_seed);
+    printf("Match seed: %u\n", g_seed);
 
-    g_units.push_back(new Models::Warrior(Team::Blue, rowBlue, startBlue + step * 1));
-
-    g_units.push_back(new Models::Unit(Team::Blue, Role::Medic, rowBlue, startBlue + step * 2));
-    g_units.push_back(new Models::Unit(Team::Blue, Role::Supplier, rowBlue, startBlue + step * 3));
-
-    g_units.push_back(new Models::Warrior(Team::Blue, rowBlue, startBlue + step * 4));
-
-    const int rowOrange = GRID_SIZE - GRID_SIZE / 6;
-    const int startOrange = GRID_SIZE - GRID_SIZE / 10;
-    g_units.push_back(new Models::Unit(Team::Orange, Role::Commander, rowOrange, startOrange - step * 0));
-    g_units.push_back(new Models::Warrior(Team::Orange, rowOrange, startOrange - step * 1));
-    g_units.push_back(new Models::Unit(Team::Orange, Role::Medic, rowOrange, startOrange - step * 2));
-    g_units.push_back(new Models::Unit(Team::Orange, Role::Supplier, rowOrange, startOrange - step * 3));
-    g_units.push_back(new Models::Warrior(Team::Orange, rowOrange, startOrange - step * 4));
-
-    int nextUnitId = 1;
-    for (auto* u : g_units) {
-        u->id = nextUnitId++;
-        u->isMoving = false;
-        u->isFighting = false;
-        u->isAutonomous = false;
-        u->isAlive = true;
-        if (u->team == Team::Blue) {
-            if (u->role == Role::Commander) g_commanderBlue.setUnitId(u->id);
-        }
-        else {
-            if (u->role == Role::Commander) g_commanderOrange.setUnitId(u->id);
-        }
-    }
-
-    randomizeAllWarriorsInTeams();
     computeMapCounts();
     computeUnitCounts();
-    g_smap.RebuildSecurityMap(g_grid);
     rebuildVisibility();
-
-    int ar, ac;
-    g_blueAnchorValid = false;
-    g_orangeAnchorValid = false;
-    if (selectAnchorForTeam(Team::Blue, ar, ac)) {
-        placeFirstByRole(Team::Blue, Role::Commander, ar, ac);
-        g_commanderBlue.anchorR = ar; g_commanderBlue.anchorC = ac;
-        g_blueAnchorValid = true;
-    }
-    if (selectAnchorForTeam(Team::Orange, ar, ac)) {
-        placeFirstByRole(Team::Orange, Role::Commander, ar, ac);
-        g_commanderOrange.anchorR = ar; g_commanderOrange.anchorC = ac;
-        g_orangeAnchorValid = true;
-    }
-
     g_targetRow = g_targetCol = -1;
-    g_commanderEnabled = false;
-    g_frameCounter = 0;
-
-    g_combat.bindUnits(&g_units);
-
-    g_commanderBlue.initSubscriptions();
-    g_commanderOrange.initSubscriptions();
-
-    g_gameOver = false;
 }
 
 // Display / Idle / Input
@@ -620,144 +395,67 @@ static void display()
         t0 = t; frames = 0;
     }
 
-    char buf1[200], buf2[128], buf3[128], buf4[160], buf7[128], bufCmd[64];
+    char buf1[240], buf2[128], buf3[128], buf4[160], buf7[128], bufCmd[64];
     std::snprintf(buf1, sizeof(buf1),
-        "FPS: %.1f  Grid: %dx%d Cell: %dpx Security:%s(RClk) Visibility:%s(V, team=%s)",
+        "FPS: %.1f  Grid: %dx%d Cell: %dpx Security:%s(RClk) Visibility:%s(V, team=%s, fov=%s(F))",
         g_fps, GRID_SIZE, GRID_SIZE, CELL_PX,
         g_showSecurity ? "ON" : "OFF",
         g_showVisibility ? "ON" : "OFF",
-        (g_visTeam == Team::Blue ? "Blue" : "Orange"));
+        (g_visTeam == Team::Blue ? "Blue" : "Orange"),
+        (g_visMode == AI::Visibility::Mode::Shadowcast ? "shadowcast" : "rays"));
     std::snprintf(buf2, sizeof(buf2), "Cells ROCK:%ld TREE:%ld WATER:%ld DEPOTS:%ld",
         g_cntRock, g_cntTree, g_cntWater, g_cntDepot);
-    std::snprintf(buf3, sizeof(buf3), "Units BLUE:%d ORANGE:%d", g_blueCount, g_orangeCount);
+    std::snprintf(buf3, sizeof(buf3), "Units BLUE:%d ORANGE:%d  Seed:%u", g_blueCount, g_orangeCount, g_seed);
     std::snprintf(buf4, sizeof(buf4), "SMap max=%.2f samples=%d decay=%.3f",
-        g_smap.maxValue(), SECURITY_SAMPLES, SECURITY_DECAY);
-    std::snprintf(bufCmd, sizeof(bufCmd), "Commander: %s (K)", g_commanderEnabled ? "ON" : "OFF");
+        g_world.smap.maxValue(), SECURITY_SAMPLES, SECURITY_DECAY);
+    std::snprintf(bufCmd, sizeof(bufCmd), "Commander: %s (K)", g_match.commanderEnabled() ? "ON" : "OFF");
 
     std::vector<std::string> hud; hud.reserve(16);
     hud.push_back(buf1); hud.push_back(buf2); hud.push_back(buf3); hud.push_back(buf4);
     hud.push_back(bufCmd);
 
+#if SIM_PROFILE
+    {
+        using Simulation::Profiler::AverageMs;
+        using Simulation::Profiler::AverageCalls;
+        using Z = Simulation::Profiler::Zone;
+        char bufProf1[200], bufProf2[200];
+        std::snprintf(bufProf1, sizeof(bufProf1),
+            "Prof ms/frame: frame=%.2f bullets=%.2f percept=%.2f cmd=%.2f (orders=%.2f) render=%.2f",
+            AverageMs(Z::Frame), AverageMs(Z::TickBullets), AverageMs(Z::Perception),
+            AverageMs(Z::CommanderTick), AverageMs(Z::DecideOrders), AverageMs(Z::Render));
+        std::snprintf(bufProf2, sizeof(bufProf2),
+            "Prof ms/frame: fsm=%.2f astar=%.2f (%.1f calls) smap=%.2f teamvis=%.2f  T: dump trace.json",
+            AverageMs(Z::FsmUpdate), AverageMs(Z::AStar), AverageCalls(Z::AStar),
+            AverageMs(Z::SecurityMap), AverageMs(Z::TeamVisibility));
+        hud.push_back(bufProf1); hud.push_back(bufProf2);
+    }
+#endif
+
     static int lastPrintMs = 0;
     int nowMs = glutGet(GLUT_ELAPSED_TIME);
     if (nowMs - lastPrintMs > 1000) {
-        printf("\n--- Frame %d ---\n", g_frameCounter);
+        printf("\n--- Frame %d ---\n", g_match.frame());
         for (const auto& s : hud) std::printf("%s\n", s.c_str());
         fflush(stdout);
         lastPrintMs = nowMs;
     }
 
+    SIM_PROFILE_ZONE(Render);
     if (g_showVisibility)
-        Painting::RenderFrameWithVisibility_Overlay(g_grid, g_units, g_vis, hud, &DebugOverlayDraw);
+        Painting::RenderFrameWithVisibility_Overlay(g_world.grid, g_world.units, g_vis, hud, &DebugOverlayDraw);
     else if (g_showSecurity)
-        Painting::RenderFrameWithSecurity_Overlay(g_grid, g_units, g_smap, hud, &DebugOverlayDraw);
+        Painting::RenderFrameWithSecurity_Overlay(g_world.grid, g_world.units, g_world.smap, hud, &DebugOverlayDraw);
     else
-        Painting::RenderFrameWithHUD_Overlay(g_grid, g_units, hud, &DebugOverlayDraw);
+        Painting::RenderFrameWithHUD_Overlay(g_world.grid, g_world.units, hud, &DebugOverlayDraw);
 }
 
 
 static void idle()
 {
-    if (!g_gameOver) {
-        g_combat.tickBullets(g_grid, g_smap);
-    }
-
-    std::vector<Models::Unit*> liveBlueUnits;
-    std::vector<Models::Unit*> liveOrangeUnits;
-    for (auto* u : g_units) {
-        if (u->isAlive) {
-            if (u->team == Team::Blue) {
-                liveBlueUnits.push_back(u);
-            }
-            else {
-                liveOrangeUnits.push_back(u);
-            }
-        }
-    }
-
-    struct TeamStatus {
-        Models::Unit* commander = nullptr;
-        bool commanderAlive = false;
-        bool warriorsAlive = false;
-        bool supportsAlive = false;
-    };
-    std::map<Team, TeamStatus> teamStatus;
-
-    for (auto* u : liveBlueUnits) {
-        TeamStatus& st = teamStatus[Team::Blue];
-        if (u->role == Role::Commander) { st.commander = u; st.commanderAlive = true; }
-        else if (u->role == Role::Warrior) { st.warriorsAlive = true; }
-        else if (u->role == Role::Medic || u->role == Role::Supplier) { st.supportsAlive = true; }
-    }
-    for (auto* u : liveOrangeUnits) {
-        TeamStatus& st = teamStatus[Team::Orange];
-        if (u->role == Role::Commander) { st.commander = u; st.commanderAlive = true; }
-        else if (u->role == Role::Warrior) { st.warriorsAlive = true; }
-        else if (u->role == Role::Medic || u->role == Role::Supplier) { st.supportsAlive = true; }
-    }
-
-    if (!g_gameOver) {
-        bool blueWarriorsExist = teamStatus[Team::Blue].warriorsAlive;
-        bool orangeWarriorsExist = teamStatus[Team::Orange].warriorsAlive;
-
-        if (!blueWarriorsExist && orangeWarriorsExist) {
-            g_gameOver = true;
-            g_winningTeam = Team::Orange; 
-        }
-        else if (blueWarriorsExist && !orangeWarriorsExist) {
-            g_gameOver = true;
-            g_winningTeam = Team::Blue; 
-        }
-    }
-
-
-    if (!g_gameOver) {
-
-        for (auto& kv : teamStatus) {
-            Team team = kv.first;
-            TeamStatus& status = kv.second;
-            std::vector<Models::Unit*>& teamPtrs = (team == Team::Blue) ? liveBlueUnits : liveOrangeUnits;
-
-            if (!status.commanderAlive && status.warriorsAlive) {
-                bool changed = false;
-                for (auto* u : teamPtrs) {
-                    if (u->role == Role::Warrior && !u->isAutonomous) {
-                        u->isAutonomous = true;
-                        changed = true;
-                    }
-                }
-                if (changed) printf("[CONTINGENCY/%s] Commander down! Warriors autonomous.\n", teamTag(team));
-            }
-            else if (!status.warriorsAlive && status.commanderAlive) {
-                if (status.commander && !status.commander->isFighting) {
-                    printf("[CONTINGENCY/%s] Warriors down! Commander fights.\n", teamTag(team));
-                    status.commander->isFighting = true;
-                }
-            }
-        }
-
-        if (g_commanderEnabled) {
-            autoEnemySightings(g_frameCounter, liveBlueUnits, liveOrangeUnits);
-            g_commanderBlue.tick(g_grid, liveBlueUnits, liveOrangeUnits, g_frameCounter);
-            g_commanderOrange.tick(g_grid, liveOrangeUnits, liveBlueUnits, g_frameCounter);
-        }
-
-        for (auto* u : g_units) {
-            if (u->isAlive) {
-                if (u->m_fsm) {
-                    u->m_fsm->Update();
-                }
-                if (u->role == Definitions::Role::Warrior) {
-                    Models::Warrior* warrior = static_cast<Models::Warrior*>(u);
-                    warrior->CheckAndReportStatus();
-                }
-            }
-        }
-
-    }
+    g_match.step();
 
     computeUnitCounts();
-    ++g_frameCounter;
     glutPostRedisplay();
 }
 
@@ -794,7 +492,7 @@ static void mouse(int button, int state, int x, int y)
 }
 
 static Models::Unit* findCommander(Definitions::Team team) {
-    for (auto* u : g_units) {
+    for (auto* u : g_world.units) {
         if (!u) continue;
         if (u->isAlive && u->role == Definitions::Role::Commander && u->team == team)
             return u;
@@ -805,9 +503,10 @@ static Models::Unit* findCommander(Definitions::Team team) {
 
 static void keyboard(unsigned char key, int , int )
 {
-    if (g_gameOver) {
+    if (g_match.gameOver()) {
         switch (key) {
         case 'n': case 'N':
+            ++g_seed;
             buildTestWorld(); 
             break;
         case 'e': case 'E':
@@ -819,22 +518,39 @@ static void keyboard(unsigned char key, int , int )
     }
 
     switch (key) {
+#if SIM_PROFILE
+    case 't': case 'T':
+        if (Simulation::Profiler::WriteChromeTrace("trace.json"))
+            printf("Profiler trace written to trace.json\n");
+        else
+            printf("Could not write trace.json\n");
+        break;
+#endif
+
     case 'k': case 'K':
-        g_commanderEnabled = !g_commanderEnabled;
-        printf("Commander AI %s\n", g_commanderEnabled ? "ENABLED" : "DISABLED");
+        g_match.setCommanderEnabled(!g_match.commanderEnabled());
+        printf("Commander AI %s\n", g_match.commanderEnabled() ? "ENABLED" : "DISABLED");
+        break;
+
+    case 'f': case 'F':
+        g_visMode = (g_visMode == AI::Visibility::Mode::Shadowcast)
+            ? AI::Visibility::Mode::Rays
+            : AI::Visibility::Mode::Shadowcast;
+        printf("Visibility FOV mode: %s\n", g_visMode == AI::Visibility::Mode::Shadowcast ? "shadowcast" : "rays");
+        rebuildVisibility();
         break;
 
     case 'x': case 'X': { 
         auto* cmd = findCommander(Definitions::Team::Blue);
         if (cmd && cmd->isAlive) {
-            cmd->isAlive = false;
+            cmd->kill();
   
-            AI::EventBus::instance().publish(AI::Message{
+            g_world.bus.publish(AI::Message{
                 AI::EventType::CommanderDown, cmd->id, -1, -1, -1, (int)cmd->team
                 });
             std::puts("[TEST] Blue commander was killed (CommanderDown sent).");
 
-            for (auto* u : g_units) {
+            for (auto* u : g_world.units) {
                 if (u && u->isAlive && u->team == Definitions::Team::Blue) {
                     u->isAutonomous = true;
                     std::printf("[AUTO] Unit #%d (%c) is now autonomous (Blue).\n",
@@ -851,13 +567,13 @@ static void keyboard(unsigned char key, int , int )
     case 'o': case 'O': { 
         auto* cmd = findCommander(Definitions::Team::Orange);
         if (cmd && cmd->isAlive) {
-            cmd->isAlive = false;
-            AI::EventBus::instance().publish(AI::Message{
+            cmd->kill();
+            g_world.bus.publish(AI::Message{
                 AI::EventType::CommanderDown, cmd->id, -1, -1, -1, (int)cmd->team
                 });
             std::puts("[TEST] Orange commander was killed (CommanderDown sent).");
 
-            for (auto* u : g_units) {
+            for (auto* u : g_world.units) {
                 if (u && u->isAlive && u->team == Definitions::Team::Orange) {
                     u->isAutonomous = true;
                     std::printf("[AUTO] Unit #%d (%c) is now autonomous (Orange).\n",
@@ -894,8 +610,13 @@ static void reshape(int w, int h)
 
 int main(int argc, char** argv)
 {
-    std::srand((unsigned)std::time(nullptr));
+    g_seed = (uint32_t)std::time(nullptr);
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (!std::strcmp(argv[i], "--seed")) g_seed = (uint32_t)std::strtoul(argv[i + 1], nullptr, 10);
+    }
 
+    // Path searches overlap the next frame on their own thread.
+    g_world.paths.setWorkers(1);
     buildTestWorld();
 
     glutInit(&argc, argv);